@@ -1,22 +1,25 @@
 /* Generator is (c) James Ponder, 1997-2001 http://www.squish.net/generator/ */
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "generator.h"
 #include "gensound.h"
 #include "gensoundp.h"
+#include "soundthread.h"
 #include "vdp.h"
 #include "ui.h"
 #include "sn76496.h"
+#include "resample.h"
 #include "gen_context.h"
 #include "gen_ui_callbacks.h"
+#include "simd.h"
 
 #ifdef JFM
 #include "jfm.h"
 #else
-#include "support.h"
-#include "fm.h"
+#include "ym2612.h"
 #endif
 
 /*** variables externed ***/
@@ -40,14 +43,22 @@ unsigned int sound_on = 1;      /* sound enabled */
 unsigned int sound_psg = 1;     /* psg enabled */
 unsigned int sound_fm = 1;      /* fm enabled */
 unsigned int sound_filter = 50; /* low-pass filter percentage (0-100) */
+unsigned int sound_threaded = 0; /* z80 and sound chips on a second core */
+unsigned int sound_drc = 0;      /* resample output to hold the threshold */
+double sound_drcratio = 1.0;     /* output samples per field sample */
+unsigned int sound_native = 0;   /* chips at their own rate, resampled */
 
 /* pal is lowest framerate */
 uint16 sound_soundbuf[2][SOUND_MAXRATE / 50];
 
 /*** forward references ***/
 
-static void sound_process(void);
+static void sound_process(unsigned int s1, unsigned int s2);
+static void sound_drcinit(void);
+static void sound_nativefield(void);
 static void sound_writetolog(unsigned char c);
+static void sound_logwrite(uint8 port, uint8 data);
+static void sound_peeksync(void);
 
 /*** file scoped variables ***/
 
@@ -57,14 +68,96 @@ static unsigned int sound_logdata_size;    /* sound_logdata size */
 static unsigned int sound_logdata_p;       /* current log data offset */
 static unsigned int sound_fieldhassamples; /* flag if field has samples */
 
+/* Chip writes are not made straight away but logged with the field sample
+   they take effect at, and the field is synthesised in as few runs as
+   possible - at the end of the field, or before anything reads chip state
+   back (YM2612 status, resets, save states).  A write made before the end
+   of line N is applied at the first sample of line N, as it was when the
+   chips were run a line at a time, so the output is the same.
+
+   Reading the YM2612's status doesn't need the sound made up to now,
+   only the timers, which ym2612_peek follows ahead of the synthesis -
+   Z80 drivers poll the status all through a field. */
+
+#define SOUND_WRITES 4096 /* log entries, a full log is synthesised early */
+#define SOUND_PORTPSG 4   /* port of SN76496 writes, YM2612 ports are 0-3 */
+
+typedef struct {
+  uint16 sample; /* field sample the write takes effect at */
+  uint8 port;    /* YM2612 port or SOUND_PORTPSG */
+  uint8 data;
+} t_sound_write;
+
+static t_sound_write sound_writes[SOUND_WRITES]; /* write log */
+static unsigned int sound_nwrites;  /* entries in sound_writes */
+static unsigned int sound_linepos;  /* field samples up to the last line */
+static unsigned int sound_rendered; /* field samples synthesised */
+static unsigned int sound_psgline;  /* line the PSG has been run to */
+static unsigned int sound_peekpos;  /* field sample the status is up to */
+
+/* Dynamic rate control.  With sound_drc on the front end times fields off
+   its own clock, which never quite matches the sound card's, so the output
+   is resampled by a ratio nudged up to SOUND_DRCMAX either way to hold the
+   sound platform's buffer at sound_threshold instead of skipping frames.
+   The resampler is a windowed sinc of SOUND_DRCTAPS taps, tabled at
+   SOUND_DRCPHASES points between two samples and interpolated between. */
+
+#define SOUND_DRCTAPS 16
+#define SOUND_DRCPHASES 64
+#define SOUND_DRCOUT (SOUND_MAXRATE / 50 + SOUND_MAXRATE / 50 / 100 + 2)
+
+static float sound_drctaps[SOUND_DRCPHASES + 1][SOUND_DRCTAPS];
+static float sound_drchist[2][SOUND_DRCTAPS - 1]; /* last field's end */
+static double sound_drcpos = SOUND_DRCTAPS / 2 - 1; /* next output time */
+static double sound_drcbias = 0;                     /* drift found so far */
+static int sound_drcready = 0;                       /* taps tabled */
+
+/* With sound_native on the chips run at the YM2612's own rate, its clock
+   / 144, and each field's mix is brought down to sound_speed with a band
+   limited resampler instead of the chips being point sampled at it.  A
+   field is then however many chip samples the resampler needs for the
+   next sound_sampsperfield outputs, sound_fieldsamps. */
+
+#define SOUND_FIELDMAX (SOUND_MAXRATE / 50 * 5 / 4) /* chip samples a field */
+
+static t_resample *sound_resample;    /* nullptr unless sound_native */
+static unsigned int sound_fieldsamps; /* chip samples this field */
+static sint32 sound_nativemix[2][SOUND_FIELDMAX]; /* the field's mix */
+
 #ifdef JFM
 static t_jfm_ctx *sound_ctx;
+#else
+static t_ym2612 *sound_ctx;
 #endif
 
+/*** sound_chiprate - the rate to run the chips at ***/
+
+static unsigned int sound_chiprate(void)
+{
+  /* the YM2612 makes a sample every 144 of its clocks, vdp_clock / 7 */
+  return sound_native ? (vdp_clock / 7 + 72) / 144 : sound_speed;
+}
+
+/*** sound_nativeinit - set up resampling from the chips' rate, if on ***/
+
+static int sound_nativeinit(unsigned int rate)
+{
+  resample_final(sound_resample);
+  sound_resample = nullptr;
+  sound_fieldsamps = sound_sampsperfield;
+  if (rate == sound_speed)
+    return 0;
+  if (!(sound_resample = resample_init(rate, sound_speed)))
+    return 1;
+  sound_fieldsamps = resample_needed(sound_resample, sound_sampsperfield);
+  return 0;
+}
+
 /*** sound_init - initialise this sub-unit ***/
 
 int sound_init(void)
 {
+  unsigned int rate;
   int ret;
 
   /* The sound_minfields parameter specifies how many fields worth of sound we
@@ -75,37 +168,42 @@ int sound_init(void)
 
   sound_sampsperfield = sound_speed / vdp_framerate;
   sound_threshold = sound_sampsperfield * sound_minfields;
+  rate = sound_chiprate();
 
   ret = sound_start();
   if (ret)
     return ret;
 #ifdef JFM
-  if ((sound_ctx = jfm_init(0, 2612, vdp_clock / 7, sound_speed, nullptr,
+  if ((sound_ctx = jfm_init(0, 2612, vdp_clock / 7, rate, nullptr,
                             nullptr)) == nullptr) {
 #else
-  if (YM2612Init(1, vdp_clock / 7, sound_speed, nullptr, nullptr)) {
+  if ((sound_ctx = ym2612_init(0, vdp_clock / 7, rate, nullptr, nullptr)) ==
+      nullptr) {
 #endif
     LOG_VERBOSE(("YM2612 failed init"));
     sound_stop();
     return 1;
   }
-  if (SN76496Init(0, vdp_clock / 15, 0, sound_speed)) {
-    LOG_VERBOSE(("SN76496 failed init"));
+  if (SN76496Init(0, vdp_clock / 15, 0, rate) || sound_nativeinit(rate)) {
+    LOG_VERBOSE(("SN76496 or resampler failed init"));
     sound_stop();
 #ifdef JFM
     jfm_final(sound_ctx);
 #else
-    YM2612Shutdown();
+    ym2612_final(sound_ctx);
+    sound_ctx = nullptr;
 #endif
     return 1;
   }
+  sound_nwrites = sound_linepos = sound_rendered = sound_psgline = 0;
+  sound_peeksync();
   if (sound_logdata)
     free(sound_logdata);
   sound_logdata_size = 8192;
   sound_logdata = malloc(sound_logdata_size);
   if (!sound_logdata)
     ui_err("out of memory");
-  LOG_VERBOSE(("YM2612 Initialised @ sample rate %d", sound_speed));
+  LOG_VERBOSE(("YM2612 Initialised @ sample rate %d", rate));
   return 0;
 }
 
@@ -113,12 +211,16 @@ int sound_init(void)
 
 void sound_final(void)
 {
+  soundthread_stop();
   sound_stop();
 #ifdef JFM
   jfm_final(sound_ctx);
 #else
-  YM2612Shutdown();
+  ym2612_final(sound_ctx);
+  sound_ctx = nullptr;
 #endif
+  resample_final(sound_resample);
+  sound_resample = nullptr;
 }
 
 /*** sound_start - start sound ***/
@@ -127,6 +229,7 @@ int sound_start(void)
 {
   int result;
 
+  soundthread_sync();
   if (sound_active) {
     /* Already active - do a full reset including SDL audio subsystem restart.
      * This fixes issues where audio doesn't work after stop/start cycles
@@ -154,6 +257,7 @@ void sound_stop(void)
 {
   if (!sound_active)
     return;
+  soundthread_sync();
   LOG_VERBOSE(("Stopping sound..."));
   soundp_stop();
   sound_active = 0;
@@ -164,10 +268,14 @@ void sound_stop(void)
 
 int sound_reset(void)
 {
+  unsigned int rate;
+
   /* Use soundp_reset() directly for a full audio subsystem restart.
    * This fixes issues where audio doesn't work after reset cycles
    * without a full SDL audio subsystem reinit. */
   LOG_VERBOSE(("Resetting sound (full subsystem restart)..."));
+  soundthread_sync();
+  sound_flush();
 
   /* Stop and shutdown sound chips */
   if (sound_active) {
@@ -177,12 +285,14 @@ int sound_reset(void)
 #ifdef JFM
   jfm_final(sound_ctx);
 #else
-  YM2612Shutdown();
+  ym2612_final(sound_ctx);
+  sound_ctx = nullptr;
 #endif
 
   /* Recalculate timing parameters */
   sound_sampsperfield = sound_speed / vdp_framerate;
   sound_threshold = sound_sampsperfield * sound_minfields;
+  rate = sound_chiprate();
 
   /* Do full audio subsystem restart */
   if (soundp_reset() != 0) {
@@ -193,28 +303,32 @@ int sound_reset(void)
 
   /* Reinitialize sound chips */
 #ifdef JFM
-  if ((sound_ctx = jfm_init(0, 2612, vdp_clock / 7, sound_speed, nullptr,
+  if ((sound_ctx = jfm_init(0, 2612, vdp_clock / 7, rate, nullptr,
                             nullptr)) == nullptr) {
 #else
-  if (YM2612Init(1, vdp_clock / 7, sound_speed, nullptr, nullptr)) {
+  if ((sound_ctx = ym2612_init(0, vdp_clock / 7, rate, nullptr, nullptr)) ==
+      nullptr) {
 #endif
     LOG_VERBOSE(("YM2612 failed init during reset"));
     soundp_stop();
     sound_active = 0;
     return 1;
   }
-  if (SN76496Init(0, vdp_clock / 15, 0, sound_speed)) {
-    LOG_VERBOSE(("SN76496 failed init during reset"));
+  if (SN76496Init(0, vdp_clock / 15, 0, rate) || sound_nativeinit(rate)) {
+    LOG_VERBOSE(("SN76496 or resampler failed init during reset"));
     soundp_stop();
     sound_active = 0;
 #ifdef JFM
     jfm_final(sound_ctx);
 #else
-    YM2612Shutdown();
+    ym2612_final(sound_ctx);
+    sound_ctx = nullptr;
 #endif
     return 1;
   }
 
+  sound_nwrites = sound_linepos = sound_rendered = sound_psgline = 0;
+  sound_peeksync();
   LOG_VERBOSE(("Sound reset complete."));
   return 0;
 }
@@ -223,6 +337,7 @@ int sound_reset(void)
 
 void sound_startfield(void)
 {
+  soundthread_startfield();
   sound_logdata_p = 0;
   if (gen_musiclog == musiclog_gnm) {
     sound_writetolog(0);
@@ -239,6 +354,7 @@ void sound_endfield(void)
   uint8 *p, *o;
 
   if (gen_musiclog) {
+    soundthread_sync(); /* logging was switched on mid-field */
     if (gen_musiclog == musiclog_gym) {
       /* GYM format ends a field with a 0 byte */
       sound_writetolog(0);
@@ -307,7 +423,103 @@ void sound_endfield(void)
     LOG_VERBOSE(("Threshold %d, therefore feedback = %d ", sound_threshold,
                  sound_feedback));
   }
-  soundp_output(sound_soundbuf[0], sound_soundbuf[1], sound_sampsperfield);
+  if (soundthread_on)
+    soundthread_push(st_output, 0, 0);
+  else
+    sound_output();
+}
+
+/*** sound_output - pass the field's samples to the sound platform, through
+     the rate control if it is on ***/
+
+void sound_output(void)
+{
+  static uint16 out[2][SOUND_DRCOUT];
+  static float in[SOUND_DRCTAPS - 1 + SOUND_MAXRATE / 50];
+  double error, target, step, pos;
+  unsigned int n = sound_sampsperfield;
+  unsigned int c, i, k, samples = 0;
+  int pending;
+
+  if (!sound_drc) {
+    soundp_output(sound_soundbuf[0], sound_soundbuf[1], n);
+    return;
+  }
+  if (!sound_drcready)
+    sound_drcinit();
+
+  /* more samples when under the threshold, fewer when over, in proportion
+     to how far off plus the drift between the clocks built up slowly from
+     the same, so the buffer settles at the threshold, smoothed over a few
+     fields */
+  pending = soundp_samplesbuffered();
+  error = ((double)sound_threshold - pending) / (double)sound_threshold;
+  sound_drcbias += SOUND_DRCMAX * error / 64;
+  if (sound_drcbias < -SOUND_DRCMAX)
+    sound_drcbias = -SOUND_DRCMAX;
+  if (sound_drcbias > SOUND_DRCMAX)
+    sound_drcbias = SOUND_DRCMAX;
+  target = 1.0 + sound_drcbias + SOUND_DRCMAX * error;
+  if (target < 1.0 - SOUND_DRCMAX)
+    target = 1.0 - SOUND_DRCMAX;
+  if (target > 1.0 + SOUND_DRCMAX)
+    target = 1.0 + SOUND_DRCMAX;
+  sound_drcratio += (target - sound_drcratio) / 8;
+  step = 1.0 / sound_drcratio;
+
+  /* in[] is the end of the last field then this one, an output at time t
+     between in[i] and in[i + 1] takes taps from in[i - 7] to in[i + 8] */
+  for (c = 0; c < 2; c++) {
+    memcpy(in, sound_drchist[c], sizeof(sound_drchist[c]));
+    for (i = 0; i < n; i++)
+      in[SOUND_DRCTAPS - 1 + i] = (sint16)sound_soundbuf[c][i];
+    memcpy(sound_drchist[c], in + n, sizeof(sound_drchist[c]));
+
+    samples = 0;
+    for (pos = sound_drcpos; pos < n + SOUND_DRCTAPS / 2 - 1; pos += step) {
+      unsigned int t = (unsigned int)pos;
+      double phase = (pos - t) * SOUND_DRCPHASES;
+      unsigned int p = (unsigned int)phase;
+      float frac = phase - p, sum = 0;
+      const float *x = in + t - (SOUND_DRCTAPS / 2 - 1);
+      long v;
+
+      for (k = 0; k < SOUND_DRCTAPS; k++)
+        sum += x[k] * (sound_drctaps[p][k] +
+                       frac * (sound_drctaps[p + 1][k] - sound_drctaps[p][k]));
+      v = lrintf(sum);
+      out[c][samples++] = v < -32768 ? -32768 : v > 32767 ? 32767 : v;
+    }
+  }
+  sound_drcpos = pos - n;
+  soundp_output(out[0], out[1], samples);
+}
+
+/*** sound_drcinit - table the rate control's taps ***/
+
+static void sound_drcinit(void)
+{
+  unsigned int p, k;
+
+  for (p = 0; p <= SOUND_DRCPHASES; p++) {
+    double sum = 0;
+
+    for (k = 0; k < SOUND_DRCTAPS; k++) {
+      /* distance of tap k from the output, Blackman windowed over taps */
+      double x = (double)k - (SOUND_DRCTAPS / 2 - 1) -
+                 (double)p / SOUND_DRCPHASES;
+      double w = 2 * M_PI * (x + SOUND_DRCTAPS / 2) / SOUND_DRCTAPS;
+      double h = x == 0 ? 1 : sin(M_PI * x) / (M_PI * x);
+
+      h *= 0.42 - 0.5 * cos(w) + 0.08 * cos(2 * w);
+      sound_drctaps[p][k] = h;
+      sum += h;
+    }
+    /* unity gain at DC whatever the phase */
+    for (k = 0; k < SOUND_DRCTAPS; k++)
+      sound_drctaps[p][k] /= sum;
+  }
+  sound_drcready = 1;
 }
 
 /*** sound_ym2612fetch - fetch byte from ym2612 chip ***/
@@ -315,9 +527,13 @@ void sound_endfield(void)
 uint8 sound_ym2612fetch(uint8 addr)
 {
 #ifdef JFM
+  sound_flush(); /* status and timers up to now */
   return jfm_read(sound_ctx, addr);
 #else
-  return YM2612Read(0, addr);
+  /* status and timers up to now, without the sound */
+  ym2612_peekrun(sound_ctx, sound_linepos - sound_peekpos);
+  sound_peekpos = sound_linepos;
+  return ym2612_peek(sound_ctx);
 #endif
 }
 
@@ -361,11 +577,7 @@ void sound_ym2612store(uint8 addr, uint8 data)
     sound_regs2[sound_address2] = data;
     break;
   }
-#ifdef JFM
-  jfm_write(sound_ctx, addr, data);
-#else
-  YM2612Write(0, addr, data);
-#endif
+  sound_logwrite(addr, data);
 }
 
 /*** sound_sn76496store - store a byte to the sn76496 chip ***/
@@ -377,23 +589,36 @@ void sound_sn76496store(uint8 data)
     sound_writetolog(3);
     sound_writetolog(data);
   }
-  SN76496Write(0, data);
+  sound_logwrite(SOUND_PORTPSG, data);
 }
 
 /*** sound_genreset - reset genesis sound ***/
 
 void sound_genreset(void)
 {
+  sound_flush();
 #ifdef JFM
   jfm_reset(sound_ctx);
 #else
-  YM2612ResetChip(0);
+  ym2612_reset(sound_ctx);
+#endif
+  sound_peeksync();
+}
+
+/*** sound_savestate - save or load the FM chip's state ***/
+
+void sound_savestate(void)
+{
+#ifndef JFM
+  if (sound_ctx)
+    ym2612_savestate(sound_ctx);
 #endif
+  sound_peeksync();
 }
 
 /*** sound_line - called at end of line ***/
 
-void sound_line(void)
+void sound_line(unsigned int line)
 {
   if (gen_musiclog == musiclog_gnm) {
     /* GNM log */
@@ -409,10 +634,117 @@ void sound_line(void)
       sound_fieldhassamples = 1;
     }
   }
-  sound_process();
+  if (line == 0 && sound_linepos) {
+    /* the last field was cut short */
+    sound_flush();
+    if (sound_resample) {
+      /* hold the last sample to the end of the field, as the resampler
+         is expecting the whole of it */
+      unsigned int c, i;
+
+      for (c = 0; c < 2; c++)
+        for (i = sound_rendered; i < sound_fieldsamps; i++)
+          sound_nativemix[c][i] = sound_nativemix[c][sound_rendered - 1];
+      sound_nativefield();
+    }
+    sound_linepos = sound_rendered = sound_psgline = sound_peekpos = 0;
+  }
+  sound_linepos = (sound_fieldsamps * (line + 1)) / vdp_totlines;
+  if (line + 1 >= vdp_totlines) {
+    /* end of field - synthesise it all, writes from now on are next field's */
+    sound_flush();
+    if (sound_resample)
+      sound_nativefield();
+    sound_linepos = sound_rendered = sound_psgline = sound_peekpos = 0;
+  }
+}
+
+/*** sound_logwrite - log a chip write to be made at the current sample ***/
+
+static void sound_logwrite(uint8 port, uint8 data)
+{
+  t_sound_write *w;
+
+  if (sound_nwrites == SOUND_WRITES)
+    sound_flush();
+  w = &sound_writes[sound_nwrites++];
+  w->sample = sound_linepos;
+  w->port = port;
+  w->data = data;
+#ifndef JFM
+  if (port != SOUND_PORTPSG) {
+    /* the status sees the write where the chip will */
+    ym2612_peekrun(sound_ctx, sound_linepos - sound_peekpos);
+    sound_peekpos = sound_linepos;
+    ym2612_peekwrite(sound_ctx, port, data);
+  }
+#endif
 }
 
-/*** sound_process - process sound ***/
+/*** sound_flush - synthesise up to the last line end, making logged writes ***/
+
+void sound_flush(void)
+{
+  unsigned int i;
+
+  for (i = 0; i < sound_nwrites; i++) {
+    const t_sound_write *w = &sound_writes[i];
+
+    if (w->sample > sound_rendered) {
+      sound_process(sound_rendered, w->sample);
+      sound_rendered = w->sample;
+    }
+    if (w->port == SOUND_PORTPSG)
+      SN76496Write(0, w->data);
+    else
+#ifdef JFM
+      jfm_write(sound_ctx, w->port, w->data);
+#else
+      ym2612_write(sound_ctx, w->port, w->data);
+#endif
+  }
+  sound_nwrites = 0;
+  if (sound_linepos > sound_rendered) {
+    sound_process(sound_rendered, sound_linepos);
+    sound_rendered = sound_linepos;
+  }
+  sound_peeksync();
+}
+
+/*** sound_peeksync - follow the YM2612's status on from where it is ***/
+
+static void sound_peeksync(void)
+{
+#ifndef JFM
+  if (sound_ctx)
+    ym2612_peeksync(sound_ctx);
+#endif
+  sound_peekpos = sound_rendered;
+}
+
+/*** sound_psgupdate - run the PSG for field samples s1 to s2 ***/
+
+static void sound_psgupdate(uint16 *buf, unsigned int s1, unsigned int s2)
+{
+  int lines[SOUND_FIELDMAX];
+  unsigned int s = s1;
+  int count = 0;
+
+  /* split at the line ends, SN76496Update's handling of silent channels
+     depends on how many samples it is asked for and it used to be called a
+     line at a time */
+  while (s < s2) {
+    unsigned int end;
+
+    while ((end = sound_fieldsamps * (sound_psgline + 1) / vdp_totlines) <= s)
+      sound_psgline++;
+    if (end > s2)
+      end = s2;
+    lines[count++] = end - s;
+    s = end;
+  }
+  SN76496UpdateLines(0, buf, lines, count);
+}
 
 /* Audio processing improvements:
  * - High-pass filter (DC blocking) to remove DC offset
@@ -447,139 +779,218 @@ static const sint32 BIQUAD_B2 = 0x1E00;  /* ~0.117 */
 static const sint32 BIQUAD_A1 = -0x6000; /* ~-0.375 (negated for subtraction) */
 static const sint32 BIQUAD_A2 = 0x0400;  /* ~0.016 */
 
+/* The coefficients in use and the sound_filter they were scaled for */
+typedef struct {
+  unsigned int filter;
+  sint32 b0, b1, b2, a1, a2;
+} biquad_coeffs_t;
+
+/* High-pass filter (DC blocking filter)
+ * Uses a simple single-pole high-pass: y[n] = alpha * (y[n-1] + x[n] - x[n-1])
+ * Alpha ~= 0.995 gives cutoff around 15 Hz at 44.1 kHz */
+#define SOUND_HPALPHA 0xFEB8 /* ~0.995 in 16.16 fixed point */
+
 /* Apply biquad filter to a sample (Direct Form II transposed) */
 static inline sint32 biquad_process(biquad_state_t *state, sint32 input,
-                                     sint32 b0, sint32 b1, sint32 b2,
-                                     sint32 a1, sint32 a2)
+                                    const biquad_coeffs_t *c)
 {
   /* y[n] = b0*x[n] + z1
    * z1 = b1*x[n] + z2 - a1*y[n]
    * z2 = b2*x[n] - a2*y[n] */
-  sint32 output = ((b0 * input) >> 16) + (state->z1 >> 16);
-  state->z1 = ((b1 * input) + state->z2) - (a1 * output);
-  state->z2 = (b2 * input) - (a2 * output);
+  sint32 output = ((c->b0 * input) >> 16) + (state->z1 >> 16);
+  state->z1 = ((c->b1 * input) + state->z2) - (c->a1 * output);
+  state->z2 = (c->b2 * input) - (c->a2 * output);
   return output;
 }
 
-static void sound_process(void)
+/*** sound_lpfcoeffs - the low-pass coefficients for sound_filter ***/
+
+static const biquad_coeffs_t *sound_lpfcoeffs(void)
 {
-  static sint16 *tbuf[2];
-  int s1 = (sound_sampsperfield * (vdp_line)) / vdp_totlines;
-  int s2 = (sound_sampsperfield * (vdp_line + 1)) / vdp_totlines;
-  /* pal is lowest framerate */
-  uint16 sn76496buf[SOUND_MAXRATE / 50]; /* far too much but who cares */
-  unsigned int samples = s2 - s1;
-  unsigned int i;
+  static biquad_coeffs_t c = {.filter = ~0u};
+  unsigned int filter = sound_filter;
+  sint32 filter_scale;
 
-  /* Biquad low-pass filter state (two-pole for better anti-aliasing) */
-  static biquad_state_t lpf_l = {0, 0};
-  static biquad_state_t lpf_r = {0, 0};
+  if (c.filter == filter)
+    return &c;
+  /* Scale biquad coefficients based on sound_filter (0-100%)
+   * 0% = no filtering (bypass), 100% = maximum filtering
+   * We interpolate the b coefficients toward unity gain at 0% */
+  filter_scale = (0x10000 * filter) / 100;
+  c.b0 = BIQUAD_B0 +
+         (((0x10000 - BIQUAD_B0) * (0x10000 - filter_scale)) >> 16);
+  c.b1 = (BIQUAD_B1 * filter_scale) >> 16;
+  c.b2 = (BIQUAD_B2 * filter_scale) >> 16;
+  c.a1 = (BIQUAD_A1 * filter_scale) >> 16;
+  c.a2 = (BIQUAD_A2 * filter_scale) >> 16;
+  c.filter = filter;
+  return &c;
+}
+
+/*** sound_mix - FM at 7/8 plus PSG at 3/8, fm or psg nullptr if off ***/
+
+/* Mixing ratios (improved based on hardware analysis):
+ * YM2612: Full level (14-bit output after internal limiting)
+ * SN76496: Outputs in range 0 to 0x7fff, subtract 0x4000 for signed
+ *
+ * Real hardware has PSG slightly quieter than FM.
+ * We use: FM * 7/8 + PSG * 3/8 for better balance.
+ * This gives more headroom and prevents clipping. */
+
+static void sound_mix(sint32 *mixl, sint32 *mixr, sint16 *const fm[2],
+                      const uint16 *psg, unsigned int samples)
+{
+  unsigned int i = 0;
+
+#if SIMD_VECTORS
+  /* eight samples a round, the widening and the arithmetic the same as
+     the loop below */
+  for (; i + 8 <= samples; i += 8) {
+    t_simd_s32x8 l = {}, r = {};
+
+    if (fm) {
+      t_simd_s16x8 fml, fmr;
+
+      memcpy(&fml, fm[0] + i, sizeof(fml));
+      memcpy(&fmr, fm[1] + i, sizeof(fmr));
+      l = (__builtin_convertvector(fml, t_simd_s32x8) * 7) >> 3;
+      r = (__builtin_convertvector(fmr, t_simd_s32x8) * 7) >> 3;
+    }
+    if (psg) {
+      t_simd_u16x8 sn;
+      t_simd_s32x8 snsample;
+
+      memcpy(&sn, psg + i, sizeof(sn));
+      snsample = (__builtin_convertvector(sn, t_simd_s32x8) - 0x4000) * 3 / 8;
+      l += snsample;
+      r += snsample;
+    }
+    memcpy(mixl + i, &l, sizeof(l));
+    memcpy(mixr + i, &r, sizeof(r));
+  }
+#endif
+  for (; i < samples; i++) {
+    sint32 l = 0, r = 0;
+
+    if (fm) {
+      /* Scale FM for headroom */
+      l = (fm[0][i] * 7) >> 3;
+      r = (fm[1][i] * 7) >> 3;
+    }
+    if (psg) {
+      /* Convert PSG to signed and scale */
+      sint32 snsample = ((sint32)psg[i] - 0x4000) * 3 / 8;
+
+      l += snsample;
+      r += snsample;
+    }
+    mixl[i] = l;
+    mixr[i] = r;
+  }
+}
+
+/*** sound_filterblock - high-pass then low-pass a block of the mix ***/
 
-  /* High-pass filter state (DC blocking filter)
-   * Uses a simple single-pole high-pass: y[n] = alpha * (y[n-1] + x[n] - x[n-1])
-   * Alpha ~= 0.995 gives cutoff around 15 Hz at 44.1 kHz */
+/* Each filter is a recurrence, so this goes a sample at a time, but with
+   the state in locals and left and right as two independent chains */
+
+static void sound_filterblock(sint16 *const out[2], const sint32 *mixl,
+                              const sint32 *mixr, unsigned int samples)
+{
+  /* the filters run on from one block to the next */
   static sint32 hp_prev_in_l, hp_prev_in_r;
   static sint32 hp_prev_out_l, hp_prev_out_r;
-  const sint32 HP_ALPHA = 0xFEB8; /* ~0.995 in 16.16 fixed point */
+  static biquad_state_t lpf_l = {0, 0};
+  static biquad_state_t lpf_r = {0, 0};
+  const biquad_coeffs_t c = *sound_lpfcoeffs();
+  sint32 in_l = hp_prev_in_l, in_r = hp_prev_in_r;
+  sint32 hp_l = hp_prev_out_l, hp_r = hp_prev_out_r;
+  biquad_state_t z_l = lpf_l, z_r = lpf_r;
+  unsigned int i;
 
-  /* Scale biquad coefficients based on sound_filter (0-100%)
-   * 0% = no filtering (bypass), 100% = maximum filtering
-   * We interpolate the b coefficients toward unity gain at 0% */
-  sint32 filter_scale = (0x10000 * sound_filter) / 100;
-  sint32 b0 = BIQUAD_B0 + (((0x10000 - BIQUAD_B0) * (0x10000 - filter_scale)) >> 16);
-  sint32 b1 = (BIQUAD_B1 * filter_scale) >> 16;
-  sint32 b2 = (BIQUAD_B2 * filter_scale) >> 16;
-  sint32 a1 = (BIQUAD_A1 * filter_scale) >> 16;
-  sint32 a2 = (BIQUAD_A2 * filter_scale) >> 16;
+  for (i = 0; i < samples; i++) {
+    sint32 l = mixl[i];
+    sint32 r = mixr[i];
+
+    /* High-pass filter (DC blocking) */
+    hp_l = (SOUND_HPALPHA * (hp_l + l - in_l)) >> 16;
+    hp_r = (SOUND_HPALPHA * (hp_r + r - in_r)) >> 16;
+    in_l = l;
+    in_r = r;
+
+    /* Two-pole low-pass filter (biquad for better anti-aliasing) */
+    out[0][i] = biquad_process(&z_l, hp_l, &c);
+    out[1][i] = biquad_process(&z_r, hp_r, &c);
+  }
+  hp_prev_in_l = in_l;
+  hp_prev_in_r = in_r;
+  hp_prev_out_l = hp_l;
+  hp_prev_out_r = hp_r;
+  lpf_l = z_l;
+  lpf_r = z_r;
+}
+
+/*** sound_process - synthesise, mix and filter field samples s1 to s2 ***/
+
+/* Called with as large a block as the logged writes allow, usually the
+   rest of the field, and each stage runs over the whole block.  At the
+   chips' own rate the mix is left for sound_nativefield to filter. */
+
+static void sound_process(unsigned int s1, unsigned int s2)
+{
+  static sint16 *tbuf[2];
+  static sint16 fmbuf[2][SOUND_FIELDMAX];
+  static uint16 sn76496buf[SOUND_FIELDMAX];
+  /* pal is lowest framerate */
+  static sint32 mixbuf[2][SOUND_MAXRATE / 50];
+  sint32 *mix[2] = {mixbuf[0], mixbuf[1]};
+  unsigned int samples = s2 - s1;
 
   tbuf[0] = sound_soundbuf[0] + s1;
   tbuf[1] = sound_soundbuf[1] + s1;
+  if (sound_resample) {
+    tbuf[0] = fmbuf[0] + s1;
+    tbuf[1] = fmbuf[1] + s1;
+    mix[0] = sound_nativemix[0] + s1;
+    mix[1] = sound_nativemix[1] + s1;
+  }
 
-  if (s2 > s1) {
-    if (sound_fm)
+  if (s2 <= s1)
+    return;
+  if (!sound_resample && !sound_fm && !sound_psg) {
+    /* no sound */
+    memset(tbuf[0], 0, 2 * samples);
+    memset(tbuf[1], 0, 2 * samples);
+    return;
+  }
+  if (sound_fm)
 #ifdef JFM
-      jfm_update(sound_ctx, (void **)tbuf, samples1);
+    jfm_update(sound_ctx, (void **)tbuf, samples1);
 #else
-      YM2612UpdateOne(0, tbuf, samples);
+    ym2612_update(sound_ctx, tbuf, samples);
 #endif
+  if (sound_psg)
+    sound_psgupdate(sn76496buf, s1, s2);
+  sound_mix(mix[0], mix[1], sound_fm ? tbuf : nullptr,
+            sound_psg ? sn76496buf : nullptr, samples);
+  if (!sound_resample)
+    sound_filterblock(tbuf, mix[0], mix[1], samples);
+}
 
-    /* Mixing ratios (improved based on hardware analysis):
-     * YM2612: Full level (14-bit output after internal limiting)
-     * SN76496: Outputs in range 0 to 0x7fff, subtract 0x4000 for signed
-     *
-     * Real hardware has PSG slightly quieter than FM.
-     * We use: FM * 7/8 + PSG * 3/8 for better balance.
-     * This gives more headroom and prevents clipping. */
-
-    if (sound_fm && sound_psg) {
-      SN76496Update(0, sn76496buf, samples);
-      for (i = 0; i < samples; i++) {
-        /* Convert PSG to signed and scale */
-        sint32 snsample = ((sint32)sn76496buf[i] - 0x4000) * 3 / 8;
-        /* Scale FM for headroom */
-        sint32 l = snsample + ((tbuf[0][i] * 7) >> 3);
-        sint32 r = snsample + ((tbuf[1][i] * 7) >> 3);
-
-        /* High-pass filter (DC blocking) */
-        sint32 hp_l = (HP_ALPHA * (hp_prev_out_l + l - hp_prev_in_l)) >> 16;
-        sint32 hp_r = (HP_ALPHA * (hp_prev_out_r + r - hp_prev_in_r)) >> 16;
-        hp_prev_in_l = l;
-        hp_prev_in_r = r;
-        hp_prev_out_l = hp_l;
-        hp_prev_out_r = hp_r;
-
-        /* Two-pole low-pass filter (biquad for better anti-aliasing) */
-        sint32 lp_l = biquad_process(&lpf_l, hp_l, b0, b1, b2, a1, a2);
-        sint32 lp_r = biquad_process(&lpf_r, hp_r, b0, b1, b2, a1, a2);
-        tbuf[0][i] = lp_l;
-        tbuf[1][i] = lp_r;
-      }
-    } else if (!sound_fm && !sound_psg) {
-      /* no sound */
-      memset(tbuf[0], 0, 2 * samples);
-      memset(tbuf[1], 0, 2 * samples);
-    } else if (sound_fm) {
-      /* fm only */
-      for (i = 0; i < samples; i++) {
-        sint32 l = (tbuf[0][i] * 7) >> 3;
-        sint32 r = (tbuf[1][i] * 7) >> 3;
-
-        /* High-pass filter (DC blocking) */
-        sint32 hp_l = (HP_ALPHA * (hp_prev_out_l + l - hp_prev_in_l)) >> 16;
-        sint32 hp_r = (HP_ALPHA * (hp_prev_out_r + r - hp_prev_in_r)) >> 16;
-        hp_prev_in_l = l;
-        hp_prev_in_r = r;
-        hp_prev_out_l = hp_l;
-        hp_prev_out_r = hp_r;
-
-        /* Two-pole low-pass filter (biquad for better anti-aliasing) */
-        sint32 lp_l = biquad_process(&lpf_l, hp_l, b0, b1, b2, a1, a2);
-        sint32 lp_r = biquad_process(&lpf_r, hp_r, b0, b1, b2, a1, a2);
-        tbuf[0][i] = lp_l;
-        tbuf[1][i] = lp_r;
-      }
-    } else {
-      /* psg only */
-      SN76496Update(0, sn76496buf, samples);
-      for (i = 0; i < samples; i++) {
-        sint32 snsample = ((sint32)sn76496buf[i] - 0x4000) * 3 / 8;
-
-        /* High-pass filter (DC blocking) */
-        sint32 hp_l = (HP_ALPHA * (hp_prev_out_l + snsample - hp_prev_in_l)) >> 16;
-        sint32 hp_r = (HP_ALPHA * (hp_prev_out_r + snsample - hp_prev_in_r)) >> 16;
-        hp_prev_in_l = snsample;
-        hp_prev_in_r = snsample;
-        hp_prev_out_l = hp_l;
-        hp_prev_out_r = hp_r;
-
-        /* Two-pole low-pass filter (biquad for better anti-aliasing) */
-        sint32 lp_l = biquad_process(&lpf_l, hp_l, b0, b1, b2, a1, a2);
-        sint32 lp_r = biquad_process(&lpf_r, hp_r, b0, b1, b2, a1, a2);
-        tbuf[0][i] = lp_l;
-        tbuf[1][i] = lp_r;
-      }
-    }
-  }
+/*** sound_nativefield - bring the field's mix down to the output rate and
+     filter it into sound_soundbuf ***/
+
+static void sound_nativefield(void)
+{
+  static sint32 mixbuf[2][SOUND_MAXRATE / 50];
+  const sint32 *const in[2] = {sound_nativemix[0], sound_nativemix[1]};
+  sint32 *const mix[2] = {mixbuf[0], mixbuf[1]};
+  sint16 *const out[2] = {(sint16 *)sound_soundbuf[0],
+                          (sint16 *)sound_soundbuf[1]};
+
+  resample_run(sound_resample, in, mix, sound_sampsperfield);
+  sound_filterblock(out, mixbuf[0], mixbuf[1], sound_sampsperfield);
+  sound_fieldsamps = resample_needed(sound_resample, sound_sampsperfield);
 }
 
 /*** sound_writetolog - write to music log buffer ***/
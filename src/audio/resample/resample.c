@@ -0,0 +1,189 @@
+/* resample - band-limited sample rate conversion of a stereo stream, see
+   resample.h */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "generator.h"
+#include "simd.h"
+#include "resample.h"
+
+#define RESAMPLE_TAPS 64
+#define RESAMPLE_PHASES 128  /* tabled points between two inputs */
+#define RESAMPLE_BETA 8.0    /* Kaiser window, about 80 dB stopband */
+#define RESAMPLE_CUTOFF 0.95 /* of the output's Nyquist */
+#define RESAMPLE_CHUNK 512   /* outputs made at a time */
+#define RESAMPLE_BUFFER                                                        \
+  (RESAMPLE_TAPS - 1 + RESAMPLE_CHUNK * RESAMPLE_MAXRATIO + 1)
+
+struct resample {
+  unsigned int inrate, outrate;
+  unsigned int step;     /* whole inputs per output */
+  unsigned int stepfrac; /* and the outrate-ths left over */
+  unsigned int frac;     /* next output is frac outrate-ths past buf's
+                            first sample */
+  float scale;           /* 1 / outrate */
+  float taps[RESAMPLE_PHASES + 1][RESAMPLE_TAPS];
+  float buf[2][RESAMPLE_BUFFER]; /* last chunk's last RESAMPLE_TAPS - 1
+                                    inputs, then this chunk's */
+};
+
+/*** resample_i0 - the zeroth order modified Bessel function ***/
+
+static double resample_i0(double x)
+{
+  double sum = 1, term = 1;
+  unsigned int k;
+
+  for (k = 1; term > sum * 1e-12; k++) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+/*** resample_init - create a converter from inrate to outrate ***/
+
+t_resample *resample_init(unsigned int inrate, unsigned int outrate)
+{
+  t_resample *rs;
+  double fc, i0beta = resample_i0(RESAMPLE_BETA);
+  unsigned int p, k;
+
+  if (!outrate || inrate < outrate || inrate / outrate >= RESAMPLE_MAXRATIO)
+    return nullptr;
+  rs = calloc(1, sizeof(*rs));
+  if (!rs)
+    return nullptr;
+  rs->inrate = inrate;
+  rs->outrate = outrate;
+  rs->step = inrate / outrate;
+  rs->stepfrac = inrate % outrate;
+  rs->scale = 1.0f / outrate;
+
+  /* cut off under the output's Nyquist, in input half cycles */
+  fc = RESAMPLE_CUTOFF * outrate / inrate;
+  for (p = 0; p <= RESAMPLE_PHASES; p++) {
+    double sum = 0;
+
+    for (k = 0; k < RESAMPLE_TAPS; k++) {
+      /* distance of tap k from an output p phases past tap TAPS / 2 - 1 */
+      double x = (double)k - (RESAMPLE_TAPS / 2 - 1) -
+                 (double)p / RESAMPLE_PHASES;
+      double w = x / (RESAMPLE_TAPS / 2);
+      double h = x == 0 ? fc : sin(M_PI * fc * x) / (M_PI * x);
+
+      h *= w * w < 1 ? resample_i0(RESAMPLE_BETA * sqrt(1 - w * w)) / i0beta
+                     : 0;
+      rs->taps[p][k] = h;
+      sum += h;
+    }
+    /* unity gain at DC whatever the phase */
+    for (k = 0; k < RESAMPLE_TAPS; k++)
+      rs->taps[p][k] /= sum;
+  }
+  return rs;
+}
+
+/*** resample_final - free a converter ***/
+
+void resample_final(t_resample *rs)
+{
+  free(rs);
+}
+
+/*** resample_needed - inputs to make outlen more outputs ***/
+
+unsigned int resample_needed(const t_resample *rs, unsigned int outlen)
+{
+  return ((uint64_t)rs->frac + (uint64_t)outlen * rs->inrate) / rs->outrate;
+}
+
+/*** resample_chunk - make outlen outputs from buf ***/
+
+static void resample_chunk(t_resample *rs, sint32 *outl, sint32 *outr,
+                           unsigned int outlen)
+{
+  unsigned int n, i = 0, r = rs->frac;
+
+  for (n = 0; n < outlen; n++) {
+    /* phase p and the fraction f of the way on to p + 1 */
+    uint64_t pr = (uint64_t)r * RESAMPLE_PHASES;
+    unsigned int p = pr / rs->outrate;
+    float f = (float)(pr - (uint64_t)p * rs->outrate) * rs->scale;
+    const float *a = rs->taps[p], *b = rs->taps[p + 1];
+    const float *xl = rs->buf[0] + i, *xr = rs->buf[1] + i;
+    float l = 0, rr = 0;
+    unsigned int k = 0;
+
+#if SIMD_VECTORS
+    /* four taps a round, the dot products with both phases for both
+       channels side by side */
+    t_simd_f32x4 la = {}, lb = {}, ra = {}, rb = {}, vl, vr;
+
+    for (; k < RESAMPLE_TAPS; k += 4) {
+      t_simd_f32x4 ta, tb, sl, sr;
+
+      memcpy(&ta, a + k, sizeof(ta));
+      memcpy(&tb, b + k, sizeof(tb));
+      memcpy(&sl, xl + k, sizeof(sl));
+      memcpy(&sr, xr + k, sizeof(sr));
+      la += sl * ta;
+      lb += sl * tb;
+      ra += sr * ta;
+      rb += sr * tb;
+    }
+    vl = la + (lb - la) * f;
+    vr = ra + (rb - ra) * f;
+    l = (vl[0] + vl[1]) + (vl[2] + vl[3]);
+    rr = (vr[0] + vr[1]) + (vr[2] + vr[3]);
+#else
+    for (; k < RESAMPLE_TAPS; k++) {
+      float t = a[k] + f * (b[k] - a[k]);
+
+      l += xl[k] * t;
+      rr += xr[k] * t;
+    }
+#endif
+    outl[n] = lrintf(l);
+    outr[n] = lrintf(rr);
+    i += rs->step;
+    r += rs->stepfrac;
+    if (r >= rs->outrate) {
+      r -= rs->outrate;
+      i++;
+    }
+  }
+}
+
+/*** resample_run - convert to outlen outputs ***/
+
+void resample_run(t_resample *rs, const sint32 *const in[2],
+                  sint32 *const out[2], unsigned int outlen)
+{
+  unsigned int done = 0, used = 0;
+
+  while (done < outlen) {
+    unsigned int n = outlen - done < RESAMPLE_CHUNK ? outlen - done
+                                                    : RESAMPLE_CHUNK;
+    unsigned int inlen = resample_needed(rs, n);
+    unsigned int c, i;
+
+    for (c = 0; c < 2; c++) {
+      float *x = rs->buf[c] + RESAMPLE_TAPS - 1;
+
+      for (i = 0; i < inlen; i++)
+        x[i] = in[c][used + i];
+    }
+    resample_chunk(rs, out[0] + done, out[1] + done, n);
+    /* the inputs the next chunk's first outputs reach back to */
+    for (c = 0; c < 2; c++)
+      memmove(rs->buf[c], rs->buf[c] + inlen,
+              (RESAMPLE_TAPS - 1) * sizeof(float));
+    rs->frac = ((uint64_t)rs->frac + (uint64_t)n * rs->inrate) % rs->outrate;
+    used += inlen;
+    done += n;
+  }
+}
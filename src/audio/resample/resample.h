@@ -0,0 +1,43 @@
+/* resample - band-limited sample rate conversion of a stereo stream
+
+   The sound chips can be run at their own rate, the YM2612's being its
+   clock / 144 (about 53 kHz), and brought down to the output rate here
+   rather than point sampled at it.  Each output is a 64 tap Kaiser
+   windowed sinc, cut off a little under the output's Nyquist, tabled
+   at 128 points between two input samples and interpolated between; the
+   input position is kept exactly, as a fraction of the output rate, so
+   there is no drift however long it runs.
+
+   CPU budget: converting 53 kHz to 44.1 kHz must stay under 5 ms per
+   second of audio on one core (0.5%), resample-bench prints the time.  The
+   chips cost about a fifth more at 53 kHz than at 44.1 kHz on top of that,
+   ym2612-bench times the YM2612 at both. */
+
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+/* a converter from one rate to another, all its state is in here */
+typedef struct resample t_resample;
+
+/* inrate must be under this times outrate */
+#define RESAMPLE_MAXRATIO 4
+
+/*
+** Create a converter down from inrate to outrate samples a second.
+** return      the converter, nullptr if out of memory or the rates are out
+**             of range
+*/
+t_resample *resample_init(unsigned int inrate, unsigned int outrate);
+
+/* Free a converter */
+void resample_final(t_resample *rs);
+
+/* The input samples resample_run needs to make outlen more output samples */
+unsigned int resample_needed(const t_resample *rs, unsigned int outlen);
+
+/* Convert exactly resample_needed(rs, outlen) samples of in[0] (left) and
+   in[1] (right) to outlen samples of out[0] and out[1] */
+void resample_run(t_resample *rs, const sint32 *const in[2],
+                  sint32 *const out[2], unsigned int outlen);
+
+#endif
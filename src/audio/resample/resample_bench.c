@@ -0,0 +1,130 @@
+/* Resampler benchmark - times converting the YM2612's NTSC rate down to
+   44.1 kHz a field per call as the emulator does, and measures how clean a
+   tone in the passband comes through and how far one that would alias is
+   kept down - it fails if either is over BENCH_LIMIT.  The time is only
+   printed, to compare against the CPU budget in resample.h, as it depends
+   on what else the machine is doing.
+
+   Usage: resample-bench [seconds]  (default 60 seconds of audio) */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "generator.h"
+#include "resample.h"
+
+#define BENCH_IN 53267 /* NTSC YM2612 clock / 144 */
+#define BENCH_OUT 44100
+#define BENCH_FIELD (BENCH_OUT / 60)
+#define BENCH_LATENCY 32 /* inputs an output lags by, half the taps */
+#define BENCH_LIMIT -80.0 /* dB, tone error or aliasing */
+
+/*** bench_tone - the error power over the signal power in dB, after the
+     first field, of a freq Hz tone converted a field at a time ***/
+
+static double bench_tone(double freq, unsigned int fields)
+{
+  static sint32 in[2][BENCH_IN / 60 + 2], out[2][BENCH_FIELD];
+  const sint32 *const inp[2] = {in[0], in[1]};
+  sint32 *const outp[2] = {out[0], out[1]};
+  t_resample *rs = resample_init(BENCH_IN, BENCH_OUT);
+  double signal = 0, noise = 0, w = 2 * M_PI * freq / BENCH_IN;
+  unsigned int f, i, pos = 0;
+
+  if (!rs) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  for (f = 0; f < fields; f++) {
+    unsigned int inlen = resample_needed(rs, BENCH_FIELD);
+
+    for (i = 0; i < inlen; i++) {
+      in[0][i] = lrint(16000 * sin(w * (pos + i)));
+      in[1][i] = -in[0][i];
+    }
+    pos += inlen;
+    resample_run(rs, inp, outp, BENCH_FIELD);
+    for (i = 0; f && i < BENCH_FIELD; i++) {
+      /* where output i falls in the input, a tone that would alias
+         should not come out at all */
+      double t = (double)(f * BENCH_FIELD + i) * BENCH_IN / BENCH_OUT -
+                 BENCH_LATENCY;
+      double want = freq < BENCH_OUT / 2 ? 16000 * sin(w * t) : 0;
+
+      signal += 16000.0 * 16000.0 / 2;
+      noise += (out[0][i] - want) * (out[0][i] - want);
+    }
+  }
+  resample_final(rs);
+  return 10 * log10(noise / signal);
+}
+
+/*** bench_convert - convert fields of in to out, a field per call ***/
+
+static void bench_convert(sint32 *in[2], sint32 *out[2], unsigned int fields)
+{
+  t_resample *rs = resample_init(BENCH_IN, BENCH_OUT);
+  unsigned int f, used = 0;
+
+  if (!rs) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  for (f = 0; f < fields; f++) {
+    const sint32 *const inp[2] = {in[0] + used, in[1] + used};
+    sint32 *const outp[2] = {out[0] + f * BENCH_FIELD,
+                             out[1] + f * BENCH_FIELD};
+
+    used += resample_needed(rs, BENCH_FIELD);
+    resample_run(rs, inp, outp, BENCH_FIELD);
+  }
+  resample_final(rs);
+}
+
+int main(int argc, char *argv[])
+{
+  static const double tones[] = {1000, 10000, 18000, 27000};
+  int seconds = argc > 1 ? atoi(argv[1]) : 60;
+  unsigned int fields = seconds * 60;
+  size_t samples = (size_t)seconds * BENCH_IN + 1, i;
+  sint32 *in[2], *out[2];
+  double start, time;
+  unsigned int t;
+  int failed = 0;
+
+  in[0] = malloc(samples * sizeof(sint32));
+  in[1] = malloc(samples * sizeof(sint32));
+  out[0] = malloc((size_t)fields * BENCH_FIELD * sizeof(sint32));
+  out[1] = malloc((size_t)fields * BENCH_FIELD * sizeof(sint32));
+  if (seconds < 1 || !in[0] || !in[1] || !out[0] || !out[1]) {
+    fprintf(stderr, "Usage: %s [seconds]\n", argv[0]);
+    return 1;
+  }
+  printf("Resampling %d Hz to %d Hz\n", BENCH_IN, BENCH_OUT);
+  for (t = 0; t < sizeof(tones) / sizeof(tones[0]); t++) {
+    double db = bench_tone(tones[t], 60);
+
+    printf("%5.0f Hz tone  %s %6.1f dB%s\n", tones[t],
+           tones[t] < BENCH_OUT / 2 ? "error   " : "aliasing", db,
+           db > BENCH_LIMIT ? "  OVER" : "");
+    if (db > BENCH_LIMIT)
+      failed = 1;
+  }
+
+  /* a chord that doesn't repeat over a field */
+  for (i = 0; i < samples; i++) {
+    in[0][i] = 8000 * sin(i * 0.0631) + 4000 * sin(i * 1.377);
+    in[1][i] = 8000 * sin(i * 0.0517) + 4000 * sin(i * 2.113);
+  }
+  start = bench_now();
+  bench_convert(in, out, fields);
+  time = (bench_now() - start) * 1000 / seconds;
+  printf("%d seconds, %.3f ms per second of audio\n", seconds, time);
+  free(in[0]);
+  free(in[1]);
+  free(out[0]);
+  free(out[1]);
+  return failed;
+}
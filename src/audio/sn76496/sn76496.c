@@ -34,10 +34,14 @@
 /* get uint16 definition */
 #include "generator.h"
 
+#include <string.h>
+
+#include "simd.h"
 #include "sn76496.h"
 
 #define MAX_OUTPUT 0x7fff
 #define STEP 0x10000
+#define SN_BLOCK 256 /* samples made at a time by SN76496Update */
 
 /* Formulas for noise generator */
 /* The SN76489/SN76496 uses a 16-bit Linear Feedback Shift Register (LFSR).
@@ -149,105 +153,150 @@ void SN76496Write(int chip, int data)
   }
 }
 
+/*** sn_fill - add v to samples s to e - 1 of the block ***/
+
+static void sn_fill(unsigned int *acc, int s, int e, unsigned int v)
+{
+#if SIMD_VECTORS
+  for (; s + 4 <= e; s += 4) {
+    t_simd_u32x4 a;
+
+    memcpy(&a, acc + s, sizeof(a));
+    a += v;
+    memcpy(acc + s, &a, sizeof(a));
+  }
+#endif
+  for (; s < e; s++)
+    acc[s] += v;
+}
+
+/*** sn_channel - run channel c for length samples, adding its output times
+     its volume to the block unless acc is null ***/
+
+static void sn_channel(struct SN76496 *R, int c, unsigned int *acc, int length)
+{
+  const int period = R->Period[c];
+  const unsigned int high = STEP * R->Volume[c];
+  int level = R->Output[c];
+  int edge = R->Count[c]; /* time of the next edge from the block start */
+  int s = 0;
+
+  /* Period 0 means DC output - tones held high, noise left where it is */
+  if (period == 0) {
+    if (acc && (c < 3 || level))
+      sn_fill(acc, 0, length, high);
+    return;
+  }
+
+  /* Period is the time between edges of the square wave, or between shifts
+     of the noise generator.  Between edges whole samples are either high or
+     low, in the sample with an edge the high time is added up edge by edge.
+     An edge falling on the end of a sample belongs to that sample. */
+  for (;;) {
+    int e = edge > 0 ? (edge - 1) / STEP : 0;
+    int t = e * STEP;
+    int vol = 0;
+
+    if (e >= length)
+      break;
+    if (acc && level)
+      sn_fill(acc, s, e, high);
+    s = e + 1;
+    while (edge <= s * STEP) {
+      if (level)
+        vol += edge - t;
+      t = edge;
+      if (c < 3) {
+        level ^= 1;
+      } else {
+        /* Correct LFSR shift with parity-based feedback.
+         * Feedback bit = parity of (RNG AND tap_mask)
+         * Then shift right and insert feedback at bit 15. */
+        int feedback = parity(R->RNG & R->NoiseFB);
+        R->RNG = (R->RNG >> 1) | (feedback << 15);
+        level = R->RNG & 1;
+      }
+      edge += period;
+    }
+    if (level)
+      vol += s * STEP - t;
+    if (acc)
+      acc[e] += vol * R->Volume[c];
+  }
+  if (acc && level)
+    sn_fill(acc, s, length, high);
+  R->Count[c] = edge - length * STEP;
+  R->Output[c] = level;
+}
+
+/*** sn_output - clip the block and scale it down to the output ***/
+
+static void sn_output(uint16 *buffer, const unsigned int *acc, int length)
+{
+  int i = 0;
+
+#if SIMD_VECTORS
+  for (; i + 8 <= length; i += 8) {
+    t_simd_u32x8 out;
+    t_simd_u16x8 res;
+
+    memcpy(&out, acc + i, sizeof(out));
+    out = simd_select((t_simd_u32x8)(out > MAX_OUTPUT * STEP),
+                      MAX_OUTPUT * STEP + (t_simd_u32x8){}, out);
+    res = __builtin_convertvector(out / STEP, t_simd_u16x8);
+    memcpy(buffer + i, &res, sizeof(res));
+  }
+#endif
+  for (; i < length; i++) {
+    unsigned int out = acc[i];
+
+    if (out > MAX_OUTPUT * STEP)
+      out = MAX_OUTPUT * STEP;
+    buffer[i] = out / STEP;
+  }
+}
+
 void SN76496Update(int chip, uint16 *buffer, int length)
 {
-  int i;
+  SN76496UpdateLines(chip, buffer, &length, 1);
+}
+
+void SN76496UpdateLines(int chip, uint16 *buffer, const int *lines, int count)
+{
   struct SN76496 *R = &sn[chip];
+  unsigned int acc[SN_BLOCK];
+  int i, l, length = 0;
 
-  /* If the volume is 0, increase the counter */
+  /* If the volume is 0, increase the counter.  The channel adds nothing to
+     the output but this is done for each of the updates, so the way the
+     samples are split up matters to it. */
   for (i = 0; i < 4; i++) {
-    if (R->Volume[i] == 0) {
+    if (R->Volume[i] != 0)
+      continue;
+    for (l = 0; l < count; l++) {
       /* note that I do count += length, NOT count = length + 1. You might
          think it's the same since the volume is 0, but doing the latter
          could cause interferencies when the program is rapidly modulating
          the volume. */
-      if (R->Count[i] <= length * STEP)
-        R->Count[i] += length * STEP;
+      if (R->Count[i] <= lines[l] * STEP)
+        R->Count[i] += lines[l] * STEP;
+      sn_channel(R, i, nullptr, lines[l]);
     }
   }
 
+  /* the rest do not care, they are run a block at a time */
+  for (l = 0; l < count; l++)
+    length += lines[l];
   while (length > 0) {
-    int vol[4];
-    unsigned int out;
-    int left;
-
-    /* vol[] keeps track of how long each square wave stays */
-    /* in the 1 position during the sample period. */
-    vol[0] = vol[1] = vol[2] = vol[3] = 0;
-
-    for (i = 0; i < 3; i++) {
-      /* Period 0 means DC output - channel held high */
-      if (R->Period[i] == 0) {
-        vol[i] = STEP; /* full high for entire sample */
-        continue;
-      }
-
-      if (R->Output[i])
-        vol[i] += R->Count[i];
-      R->Count[i] -= STEP;
-      /* Period[i] is the half period of the square wave. Here, in each */
-      /* loop I add Period[i] twice, so that at the end of the loop the */
-      /* square wave is in the same status (0 or 1) it was at the start. */
-      /* vol[i] is also incremented by Period[i], since the wave has been 1 */
-      /* exactly half of the time, regardless of the initial position. */
-      /* If we exit the loop in the middle, Output[i] has to be inverted */
-      /* and vol[i] incremented only if the exit status of the square */
-      /* wave is 1. */
-      while (R->Count[i] <= 0) {
-        R->Count[i] += R->Period[i];
-        if (R->Count[i] > 0) {
-          R->Output[i] ^= 1;
-          if (R->Output[i])
-            vol[i] += R->Period[i];
-          break;
-        }
-        R->Count[i] += R->Period[i];
-        vol[i] += R->Period[i];
-      }
-      if (R->Output[i])
-        vol[i] -= R->Count[i];
-    }
-
-    /* Noise channel processing */
-    left = STEP;
-
-    /* Period 0 for noise means DC output (when using tone 2 freq with period 0) */
-    if (R->Period[3] == 0) {
-      vol[3] = R->Output[3] ? STEP : 0;
-    } else {
-      do {
-        int nextevent;
-
-        if (R->Count[3] < left)
-          nextevent = R->Count[3];
-        else
-          nextevent = left;
-        if (R->Output[3])
-          vol[3] += R->Count[3];
-        R->Count[3] -= nextevent;
-        if (R->Count[3] <= 0) {
-          /* Correct LFSR shift with parity-based feedback.
-           * Feedback bit = parity of (RNG AND tap_mask)
-           * Then shift right and insert feedback at bit 15. */
-          int feedback = parity(R->RNG & R->NoiseFB);
-          R->RNG = (R->RNG >> 1) | (feedback << 15);
-          R->Output[3] = R->RNG & 1;
-          R->Count[3] += R->Period[3];
-          if (R->Output[3])
-            vol[3] += R->Period[3];
-        }
-        if (R->Output[3])
-          vol[3] -= R->Count[3];
-        left -= nextevent;
-      } while (left > 0);
-    }
-
-    out = vol[0] * R->Volume[0] + vol[1] * R->Volume[1] +
-          vol[2] * R->Volume[2] + vol[3] * R->Volume[3];
-    if (out > MAX_OUTPUT * STEP)
-      out = MAX_OUTPUT * STEP;
-    *(buffer++) = out / STEP;
-    length--;
+    int n = length < SN_BLOCK ? length : SN_BLOCK;
+
+    memset(acc, 0, n * sizeof(acc[0]));
+    for (i = 0; i < 4; i++)
+      if (R->Volume[i] != 0)
+        sn_channel(R, i, acc, n);
+    sn_output(buffer, acc, n);
+    buffer += n;
+    length -= n;
   }
 }
 
@@ -22,5 +22,8 @@ extern struct SN76496 sn[MAX_76496];
 int SN76496Init(int chip, int clock, int gain, int sample_rate);
 void SN76496Write(int chip, int data);
 void SN76496Update(int chip, uint16 *buffer, int length);
+/* the same as SN76496Update for lines[0], then lines[1] ... samples */
+void SN76496UpdateLines(int chip, uint16 *buffer, const int *lines,
+                        int count);
 
 #endif
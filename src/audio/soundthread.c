@@ -0,0 +1,298 @@
+/* Generator is (c) James Ponder, 1997-2001 http://www.squish.net/generator/ */
+
+/* sound thread - runs the z80, YM2612 and SN76496 on a second core
+
+   While the thread is running the 68k side never touches z80 or sound chip
+   state.  Everything it would have done - the z80 sync and sample
+   generation at the end of each line, bus requests, resets, z80 RAM and bank
+   register stores, YM2612 and PSG port stores and the end of field output -
+   is appended to a single-producer single-consumer queue along with the 68k
+   clock count at the time, and the thread replays the queue in order.  The
+   same calls in the same order against the same clock counts produce the
+   same z80 execution and the same samples as running them inline.
+
+   Anything on the 68k side that reads z80 or sound chip state back (z80 RAM,
+   YM2612 status, bus request status, save states, resets) calls
+   soundthread_sync() first, which waits for the queue to drain - i.e. that
+   access is synchronous.
+
+   The z80 can bank 68k memory into its address space.  Cartridge ROM is
+   safe to read from another thread, 68k RAM and I/O are not, so if the z80
+   banks anything else it waits in soundthread_fallback until the 68k side
+   is parked in soundthread_sync, and the 68k side, at its next event or
+   sync, drains the queue and stops the thread before it runs on - sound
+   runs inline from then on.  Until then the z80 sees 68k RAM as it is
+   when the 68k side parks, which can be later than it would have inline
+   by as much as the queue holds.  Music logging also runs inline. */
+
+#include <threads.h>
+#include <stdatomic.h>
+
+#include "generator.h"
+#include "cpu68k.h"
+#include "cpuz80.h"
+#include "gensound.h"
+#include "gensoundp.h"
+#include "soundthread.h"
+#include "ui.h"
+
+#define SOUNDTHREAD_QUEUELEN (1 << 16) /* events, must be a power of 2 */
+#define SOUNDTHREAD_SPIN 256           /* empty polls before sleeping */
+
+/*** variables externed ***/
+
+unsigned int soundthread_on = 0; /* thread owns z80 and sound state */
+
+/*** forward references ***/
+
+static int soundthread_main(void *arg);
+static void soundthread_replay(const t_soundthread_event *ev);
+
+/*** file scoped variables ***/
+
+static t_soundthread_event soundthread_queue[SOUNDTHREAD_QUEUELEN];
+static _Atomic unsigned int soundthread_head; /* next event to be queued */
+static _Atomic unsigned int soundthread_tail; /* next event to be replayed */
+static _Atomic unsigned int soundthread_sleeping;
+static _Atomic unsigned int soundthread_quit;
+static _Atomic unsigned int soundthread_unsafe; /* z80 banked non-ROM */
+static _Atomic unsigned int soundthread_parked; /* 68k side in _drain */
+static thrd_t soundthread_thread;
+static mtx_t soundthread_mutex;
+static cnd_t soundthread_cond;
+
+/*** soundthread_start - start the thread ***/
+
+static int soundthread_start(void)
+{
+  atomic_store(&soundthread_head, 0);
+  atomic_store(&soundthread_tail, 0);
+  atomic_store(&soundthread_sleeping, 0);
+  atomic_store(&soundthread_quit, 0);
+  if (mtx_init(&soundthread_mutex, mtx_plain) != thrd_success)
+    return -1;
+  if (cnd_init(&soundthread_cond) != thrd_success) {
+    mtx_destroy(&soundthread_mutex);
+    return -1;
+  }
+  if (thrd_create(&soundthread_thread, soundthread_main, nullptr) !=
+      thrd_success) {
+    cnd_destroy(&soundthread_cond);
+    mtx_destroy(&soundthread_mutex);
+    return -1;
+  }
+  soundthread_on = 1;
+  LOG_VERBOSE(("Sound thread started"));
+  return 0;
+}
+
+/*** soundthread_drain - wait until everything queued has been replayed ***/
+
+static void soundthread_drain(void)
+{
+  /* the 68k side does nothing else meanwhile, so the z80 can use 68k RAM
+     and I/O - see soundthread_fallback */
+  atomic_store(&soundthread_parked, 1);
+  while (atomic_load_explicit(&soundthread_tail, memory_order_acquire) !=
+         atomic_load_explicit(&soundthread_head, memory_order_relaxed))
+    thrd_yield();
+  atomic_store(&soundthread_parked, 0);
+}
+
+/*** soundthread_halt - stop the drained thread ***/
+
+static void soundthread_halt(void)
+{
+  atomic_store(&soundthread_quit, 1);
+  mtx_lock(&soundthread_mutex);
+  cnd_signal(&soundthread_cond);
+  mtx_unlock(&soundthread_mutex);
+  thrd_join(soundthread_thread, nullptr);
+  cnd_destroy(&soundthread_cond);
+  mtx_destroy(&soundthread_mutex);
+  soundthread_on = 0;
+  LOG_VERBOSE(("Sound thread stopped"));
+}
+
+/*** soundthread_stop - drain the queue and stop the thread ***/
+
+void soundthread_stop(void)
+{
+  if (!soundthread_on)
+    return;
+  soundthread_drain();
+  soundthread_halt();
+}
+
+/*** soundthread_startfield - start or stop the thread at a field boundary ***/
+
+void soundthread_startfield(void)
+{
+#ifdef RAZE
+  /* the replay follows the mz80 glue's stop/start semantics */
+  unsigned int want = 0;
+#else
+  unsigned int want = sound_threaded && gen_musiclog == musiclog_off &&
+                      !atomic_load(&soundthread_unsafe);
+#endif
+
+  if (want && !soundthread_on) {
+    if (soundthread_start()) {
+      LOG_CRITICAL(("Unable to start sound thread"));
+      sound_threaded = 0;
+    }
+  } else if (!want && soundthread_on) {
+    soundthread_stop();
+  }
+}
+
+/*** soundthread_reset - sync and forget any earlier fallback ***/
+
+void soundthread_reset(void)
+{
+  soundthread_sync();
+  atomic_store(&soundthread_unsafe, 0);
+}
+
+/*** soundthread_fallback - z80 banked something unsafe ***/
+
+void soundthread_fallback(void)
+{
+  atomic_store(&soundthread_unsafe, 1);
+  /* on the thread, hold the z80 until the 68k side has stopped to drain the
+     queue, which it does at its next event or sync and then stops us */
+  if (thrd_equal(thrd_current(), soundthread_thread))
+    while (!atomic_load(&soundthread_parked))
+      thrd_yield();
+}
+
+/*** soundthread_push - queue an event, called by the 68k side ***/
+
+void soundthread_push(t_soundthread_type type, uint16 addr, uint8 data)
+{
+  unsigned int head =
+      atomic_load_explicit(&soundthread_head, memory_order_relaxed);
+  t_soundthread_event *ev;
+
+  /* the z80 banked 68k RAM or I/O (soundthread_sync stops the thread), or
+     the queue is full - the thread is a whole queue behind, let it catch up */
+  if (atomic_load(&soundthread_unsafe) ||
+      head - atomic_load_explicit(&soundthread_tail, memory_order_acquire) >=
+          SOUNDTHREAD_QUEUELEN)
+    soundthread_sync();
+  if (!soundthread_on) {
+    /* stopped, this and everything after it is inline */
+    t_soundthread_event inline_ev = {cpu68k_clocks, addr, data, type};
+
+    soundthread_replay(&inline_ev);
+    return;
+  }
+
+  ev = &soundthread_queue[head & (SOUNDTHREAD_QUEUELEN - 1)];
+  ev->clocks = cpu68k_clocks;
+  ev->addr = addr;
+  ev->data = data;
+  ev->type = type;
+
+  /* seq_cst pairs with the thread setting soundthread_sleeping and then
+     re-checking head, so either it sees this event or we see it asleep */
+  atomic_store(&soundthread_head, head + 1);
+  if (atomic_load(&soundthread_sleeping)) {
+    mtx_lock(&soundthread_mutex);
+    cnd_signal(&soundthread_cond);
+    mtx_unlock(&soundthread_mutex);
+  }
+}
+
+/*** soundthread_sync - wait until everything queued has been replayed ***/
+
+void soundthread_sync(void)
+{
+  if (!soundthread_on)
+    return;
+  soundthread_drain();
+  if (atomic_load(&soundthread_unsafe)) {
+    /* stop before the 68k side runs on and changes what the z80 uses */
+    LOG_NORMAL(("Z80 banked 68k RAM/IO - sound thread disabled"));
+    soundthread_halt();
+  }
+}
+
+/*** soundthread_main - thread body ***/
+
+static int soundthread_main(void *arg)
+{
+  unsigned int tail =
+      atomic_load_explicit(&soundthread_tail, memory_order_relaxed);
+  unsigned int idle = 0;
+
+  (void)arg;
+  for (;;) {
+    if (tail == atomic_load_explicit(&soundthread_head, memory_order_acquire)) {
+      if (atomic_load(&soundthread_quit))
+        break;
+      if (++idle < SOUNDTHREAD_SPIN) {
+        thrd_yield();
+        continue;
+      }
+      mtx_lock(&soundthread_mutex);
+      atomic_store(&soundthread_sleeping, 1);
+      while (tail == atomic_load(&soundthread_head) &&
+             !atomic_load(&soundthread_quit))
+        cnd_wait(&soundthread_cond, &soundthread_mutex);
+      atomic_store(&soundthread_sleeping, 0);
+      mtx_unlock(&soundthread_mutex);
+      idle = 0;
+      continue;
+    }
+    idle = 0;
+    soundthread_replay(&soundthread_queue[tail & (SOUNDTHREAD_QUEUELEN - 1)]);
+    atomic_store_explicit(&soundthread_tail, ++tail, memory_order_release);
+  }
+  return 0;
+}
+
+/*** soundthread_replay - do what the 68k side would have done inline ***/
+
+static void soundthread_replay(const t_soundthread_event *ev)
+{
+  switch (ev->type) {
+  case st_line:
+    cpuz80_syncto(ev->clocks);
+    sound_line(ev->addr);
+    break;
+  case st_z80int:
+    cpuz80_interrupt();
+    break;
+  case st_z80endfield:
+    cpuz80_endfield();
+    break;
+  case st_output:
+    sound_output();
+    break;
+  case st_z80ram:
+    cpuz80_ram[ev->addr] = ev->data;
+    break;
+  case st_z80bank:
+    cpuz80_bankwrite(ev->data);
+    break;
+  case st_z80busreq:
+    cpuz80_syncto(ev->clocks);
+    cpuz80_active = !ev->data;
+    break;
+  case st_z80reset:
+    if (ev->data) {
+      cpuz80_resetcpu();
+      sound_genreset();
+    } else {
+      cpuz80_unresetcpu();
+    }
+    break;
+  case st_ym2612:
+    sound_ym2612store(ev->addr, ev->data);
+    break;
+  case st_sn76496:
+    sound_sn76496store(ev->data);
+    break;
+  }
+}
@@ -0,0 +1,164 @@
+/* Generator is (c) James Ponder, 1997-2001 http://www.squish.net/generator/ */
+
+/* genfm - writes fm-kernels.h, the YM2612 channel calculation specialised
+   for each of the 8 algorithms, with and without LFO and with and without
+   feedback.  ym2612.c includes it and setup_kernel picks one per channel
+   when the registers change, so the per sample update has no connections
+   to follow and no LFO or feedback tests.  ym2612_calc runs them.
+
+   Each kernel does the whole channel calculation for a channel with that
+   setup, the LFO taken from the chip's OPN, and returns the channel
+   output. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* forward references */
+
+void generate(FILE *output, int algo, int lfo, int fb);
+
+/* defines */
+
+#define HEADER                                                                 \
+  "/*************************************************************************" \
+  "****/\n/*     Generator - Sega Genesis emulation - (c) James Ponder "       \
+  "1997-2001       "                                                           \
+  "*/\n/"                                                                      \
+  "**************************************************************************" \
+  "***/\n/*                                                                  " \
+  "         */\n/* fm-kernels.h                                             " \
+  "                 */\n/*                                                   " \
+  "                        "                                                   \
+  "*/\n/"                                                                      \
+  "**************************************************************************" \
+  "***/\n\n"
+
+#define FNAME_GENFM_OUT "fm-kernels.h"
+
+/* Where each slot's output goes, for each algorithm (see setup_kernel).
+   Bit 0 = S2, bit 1 = S3, bit 2 = S4, bit 3 = the channel output.  S4
+   always goes to the output. */
+
+static const int genfm_route[8][3] = {
+    /*  S1   S2   S3 */
+    {0x1, 0x2, 0x4}, /* 0: S1-S2-S3-S4 */
+    {0x2, 0x2, 0x4}, /* 1: (S1+S2)-S3-S4 */
+    {0x4, 0x2, 0x4}, /* 2: (S1+(S2-S3))-S4 */
+    {0x1, 0x4, 0x4}, /* 3: ((S1-S2)+S3)-S4 */
+    {0x1, 0x8, 0x4}, /* 4: (S1-S2)+(S3-S4) */
+    {0x7, 0x8, 0x8}, /* 5: S1-(S2+S3+S4) */
+    {0x1, 0x8, 0x8}, /* 6: (S1-S2)+S3+S4 */
+    {0x8, 0x8, 0x8}  /* 7: S1+S2+S3+S4 */
+};
+
+static const char *genfm_slot[4] = {"SLOT1", "SLOT2", "SLOT3", "SLOT4"};
+
+/* program entry routine */
+
+int main(int argc, char *argv[])
+{
+  const char *fname = argc > 1 ? argv[1] : FNAME_GENFM_OUT;
+  FILE *output;
+  int algo, lfo, fb;
+
+  printf("Writing %s... ", fname);
+  fflush(stdout);
+
+  if ((output = fopen(fname, "w")) == nullptr) {
+    perror("fopen output");
+    exit(1);
+  }
+  fputs(HEADER, output);
+
+  for (algo = 0; algo < 8; algo++)
+    for (lfo = 0; lfo < 2; lfo++)
+      for (fb = 0; fb < 2; fb++)
+        generate(output, algo, lfo, fb);
+
+  /* the table setup_kernel picks from */
+  fprintf(output, "static FM_CH_CALC *const fm_kernels[8][2][2] = {\n");
+  for (algo = 0; algo < 8; algo++) {
+    fprintf(output, "    {");
+    for (lfo = 0; lfo < 2; lfo++)
+      fprintf(output, "{FM_CALC_ALGO%d%s, FM_CALC_ALGO%d%s_FB}%s", algo,
+              lfo ? "_LFO" : "", algo, lfo ? "_LFO" : "",
+              lfo ? "" : ",\n     ");
+    fprintf(output, "}%s\n", algo < 7 ? "," : "");
+  }
+  fprintf(output, "};\n");
+
+  if (fclose(output)) {
+    perror("fclose output");
+    exit(1);
+  }
+
+  printf("done.\n");
+  fflush(stdout);
+
+  /* normal program termination */
+  return (0);
+}
+
+/* generate one kernel */
+
+void generate(FILE *o, int algo, int lfo, int fb)
+{
+  const int *route = genfm_route[algo];
+  int s, src, first;
+
+  fprintf(o, "/* algorithm %d, %s, %s */\n", algo,
+          lfo ? "LFO" : "no LFO", fb ? "feedback" : "no feedback");
+  fprintf(o, "static INT32 FM_CALC_ALGO%d%s%s(FM_OPN *OPN, FM_CH *CH)\n{\n",
+          algo, lfo ? "_LFO" : "", fb ? "_FB" : "");
+  fprintf(o, "  FM_SLOT *SLOT = CH->SLOT;\n");
+  fprintf(o, "  INT32 out = CH->op1_out[0] + CH->op1_out[1];\n");
+  fprintf(o, "  unsigned int eg1, eg2, eg3, eg4;\n");
+  fprintf(o, "  INT32 s1, s2, s3, s4;\n\n");
+
+  /* envelope generator */
+  for (s = 0; s < 4; s++) {
+    fprintf(o, "  eg%d = calc_eg_env(&SLOT[%s])", s + 1, genfm_slot[s]);
+    if (lfo)
+      fprintf(o, " + SLOT[%s].ams * OPN->lfo_amd / LFO_RATE",
+              genfm_slot[s]);
+    fprintf(o, ";\n");
+  }
+  fprintf(o, "\n");
+
+  /* SLOT1 with its feedback, its output is the one from the sample before */
+  fprintf(o, "  s1 = CH->op1_out[0] = CH->op1_out[1];\n");
+  fprintf(o, "  CH->op1_out[1] = eg1 < ENV_QUIET ? op_calc1(SLOT[SLOT1].Cnt, "
+             "eg1, %s) : 0;\n",
+          fb ? "out << CH->FB" : "out");
+
+  /* the other slots, each modulated by whatever is routed to it */
+  for (s = 1; s < 4; s++) {
+    fprintf(o, "  s%d = eg%d < ENV_QUIET ? op_calc(SLOT[%s].Cnt, eg%d, ", s + 1,
+            s + 1, genfm_slot[s], s + 1);
+    first = 1;
+    for (src = 0; src < s; src++) {
+      if (!(route[src] & 1 << (s - 1)))
+        continue;
+      fprintf(o, "%ss%d", first ? "" : " + ", src + 1);
+      first = 0;
+    }
+    fprintf(o, "%s) : 0;\n", first ? "0" : "");
+  }
+  fprintf(o, "\n");
+
+  /* phase generator */
+  if (lfo) {
+    fprintf(o, "  FM_CALC_PG(CH, OPN->lfo_pmd);\n");
+  } else {
+    for (s = 0; s < 4; s++)
+      fprintf(o, "  SLOT[%s].Cnt += SLOT[%s].Incr;\n", genfm_slot[s],
+              genfm_slot[s]);
+  }
+
+  /* the carriers */
+  fprintf(o, "  return ");
+  for (src = 0; src < 3; src++)
+    if (route[src] & 8)
+      fprintf(o, "s%d + ", src + 1);
+  fprintf(o, "s4;\n}\n\n");
+}
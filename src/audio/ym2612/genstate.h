@@ -17,5 +17,3 @@
 
 #define state_save_register_int(mod, ins, name, val) \
   state_transfer32(mod, name, ins, val, 1);
-
-#define state_save_register_func_postload(a) a();
@@ -1,10 +1,6 @@
-/* Generator fm.c support file */
+/* Generator ym2612.c support file */
 
 /* #include "config.h" */ /* Meson passes all config via compiler flags */
 
-#define errorlog 0
 #define INLINE inline
-#define HAS_YM2612 1
-#define YM2612UpdateRequest(x)
-#define AY8910_set_clock(chip, clock) /* */
-#define logerror                      /* */
+#define logerror /* */
@@ -0,0 +1,1888 @@
+/*
+**
+** File: ym2612.c -- software implementation of the Yamaha YM2612 (OPN2)
+**
+** Copyright (C) 1998 Tatsuyuki Satoh , MultiArcadeMachineEmulator development
+**
+** Version 0.37e
+**
+** Generator: the YM2612 part of fm.c on its own.  The other chips and the
+** globals they shared are gone - a chip's state, LFO and channel outputs
+** included, is all in its YM2612, so each owner has its own and any number
+** can run at once.  Only the tables built by the first ym2612_init are
+** shared, and they are read only after that.
+*/
+
+/*
+** History:
+**
+** 12-08-2001 Jarek Burczynski:
+**  - corrected sin_tab and tl_tab data	(verified on real chip)
+**  - corrected feedback calculations (verified on real chip)
+**  - corrected phase generator calculations (verified on real chip)
+**  - corrected envelope generator calculations (verified on real chip)
+**  - corrected FM volume level (YM2610 and YM2610B).
+**  - changed YMxxxUpdateOne() functions (YM2203, YM2608, YM2610, YM2610B,
+* YM2612) :
+**    this was needed to calculate YM2610 FM channels output correctly.
+**    (Each FM channel is calculated as in other chips, but the output of the
+* channel
+**    gets shifted right by one *before* sending to accumulator. That was
+* impossible to do
+**    with previous implementation).
+**
+** 23-07-2001 Jarek Burczynski, Nicola Salmoria:
+**  - corrected YM2610 ADPCM type A algorithm and tables (verified on real chip)
+**
+** 11-06-2001 Jarek Burczynski:
+**  - corrected end of sample bug in OPNB_ADPCM_CALC_CHA.
+**    Real YM2610 checks for equality between current and end addresses (only 20
+* LSB bits).
+**
+** 08-12-98 hiro-shi:
+** rename ADPCMA -> ADPCMB, ADPCMB -> ADPCMA
+** move ROM limit check.(CALC_CH? -> 2610Write1/2)
+** test program (ADPCMB_TEST)
+** move ADPCM A/B end check.
+** ADPCMB repeat flag(no check)
+** change ADPCM volume rate (8->16) (32->48).
+**
+** 09-12-98 hiro-shi:
+** change ADPCM volume. (8->16, 48->64)
+** replace ym2610 ch0/3 (YM-2610B)
+** init cur_chip (restart bug fix)
+** change ADPCM_SHIFT (10->8) missing bank change 0x4000-0xffff.
+** add ADPCM_SHIFT_MASK
+** change ADPCMA_DECODE_MIN/MAX.
+*/
+
+
+/*
+  TO DO:
+    - use real sample rate and let mixer.c do the sample rate convertion
+
+  preliminary :
+    key scale level rate (?)
+    LFO contoller
+
+  note:
+    fnum          fM * 2^20 / (fM/(12*n))
+    TimerOverA    ( 12*n)*(1024-NA)/fM
+    TimerOverB    (192*n)*(256-NB)/fM
+    output bits   10bit<<3bit
+    sampling rate fFM / (12*prescaler)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Generator */
+#include "support.h"
+#include "ym2612.h"
+#include "genstate.h"
+
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+
+/* --- emulation options --- */
+/* internal timers: James Ponder 2001-09-30: use internal timer in Generator */
+#define FM_INTERNAL_TIMER 1
+/* support OPN SSG type envelope mode (SSG-EG) */
+/* SSG-EG provides looping/alternating envelope patterns used by many games */
+#define FM_SEG_SUPPORT 1
+/* busy flag emulation using sample counter (no external timer required) */
+#define FM_BUSY_FLAG_SUPPORT 1
+
+/* -------------------- sound quality define selection --------------------- */
+#define FREQ_SH 16  /* 16.16 fixed point (frequency calculations) */
+#define ENV_SH 16   /* 16.16 fixed point (envelope calculations)  */
+#define LFO_SH 23   /*  9.23 fixed point (LFO calculations)       */
+#define TIMER_SH 16 /* 16.16 fixed point (timers calculations)    */
+
+#define FREQ_MASK ((1 << FREQ_SH) - 1)
+#define ENV_MASK ((1 << ENV_SH) - 1)
+
+/* envelope output entries */
+#define ENV_BITS 10
+#define ENV_LEN (1 << ENV_BITS)
+#define ENV_STEP (128.0 / ENV_LEN)
+#define ENV_QUIET ((int)(0x68 / (ENV_STEP)))
+
+#define MAX_ATT_INDEX ((ENV_LEN << ENV_SH) - 1) /* 1023.ffff */
+#define MIN_ATT_INDEX ((1 << ENV_SH) - 1)       /*    0.ffff */
+
+/* sinwave entries */
+#define SIN_BITS 10
+#define SIN_LEN (1 << SIN_BITS)
+#define SIN_MASK (SIN_LEN - 1)
+
+#define TL_RES_LEN (256) /* 8 bits addressing (real chip) */
+
+
+/* LFO table entries */
+#define LFO_ENT 512
+#define LFO_RATE 0x10000
+#define PMS_RATE 0x400
+/* OPN LFO waveform table */
+
+static INT32 OPN_LFO_wave[LFO_ENT];
+
+/* -------------------- tables --------------------- */
+
+/* sustain level table (3db per step) */
+/* bit0, bit1, bit2, bit3, bit4, bit5, bit6 */
+/* 1,    2,    4,    8,    16,   32,   64   (value)*/
+/* 0.75, 1.5,  3,    6,    12,   24,   48   (dB)*/
+
+/* 0 - 15: 0, 3, 6, 9,12,15,18,21,24,27,30,33,36,39,42,93 (dB)*/
+#define SC(db) (UINT32)(db * (4.0 / ENV_STEP) * (1 << ENV_SH))
+static const UINT32 SL_TABLE[16] = {
+    SC(0), SC(1), SC(2),  SC(3),  SC(4),  SC(5),  SC(6),  SC(7),
+    SC(8), SC(9), SC(10), SC(11), SC(12), SC(13), SC(14), SC(31)};
+#undef SC
+
+/*	TL_TAB_LEN is calculated as:
+ *	13 - sinus amplitude bits     (Y axis)
+ *	2  - sinus sign bit           (Y axis)
+ *	TL_RES_LEN - sinus resolution (X axis)
+ */
+#define TL_TAB_LEN (13 * 2 * TL_RES_LEN)
+static signed int tl_tab[TL_TAB_LEN];
+
+/* sin waveform table in 'decibel' scale */
+static unsigned int sin_tab[SIN_LEN];
+
+
+static UINT8 OPN_DTTABLE[4 * 32] = {
+    /* this is YM2612 phase increment data (in 10.10 fixed point format)*/
+    /* FD=0 */
+    0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0,
+    /* FD=1 */
+    0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5, 5,
+    6, 6, 7, 8, 8, 8, 8,
+    /* FD=2 */
+    1, 1, 1, 1, 2, 2, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5, 5, 6, 6, 7, 8, 8, 9, 10, 11,
+    12, 13, 14, 16, 16, 16, 16,
+    /* FD=3 */
+    2, 2, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5, 5, 6, 6, 7, 8, 8, 9, 10, 11, 12, 13, 14,
+    16, 17, 19, 20, 22, 22, 22, 22};
+
+
+/* output final shift */
+#define FINAL_SH (0)
+#define MAXOUT (+32767)
+#define MINOUT (-32768)
+
+/* -------------------- local defines , macros --------------------- */
+/* register number to channel number , slot offset */
+#define OPN_CHAN(N) (N & 3)
+#define OPN_SLOT(N) ((N >> 2) & 3)
+/* slot number */
+#define SLOT1 0
+#define SLOT2 2
+#define SLOT3 1
+#define SLOT4 3
+
+/* FM timer model */
+#define FM_TIMER_SINGLE (0)
+#define FM_TIMER_INTERVAL (1)
+
+/* ---------- one channel  ---------- */
+typedef struct fm_slot {
+  INT32 *DT;        /* detune          :DT_TABLE[DT]		*/
+  UINT32 TL;        /* total level     :TL << 3				*/
+  UINT8 KSR;        /* key scale rate  :3-KSR				*/
+  UINT8 ARval;      /* current AR							*/
+  const UINT32 *AR; /* attack rate     :&AR_TABLE[AR<<1]	*/
+  const UINT32 *DR; /* decay rate      :&DR_TABLE[DR<<1]	*/
+  const UINT32 *SR; /* sustain rate    :&DR_TABLE[SR<<1]	*/
+  const UINT32 *RR; /* release rate    :&DR_TABLE[RR<<2+2]	*/
+  UINT8 SEG;        /* SSG EG type     :SSGEG				*/
+  UINT8 ssg_inv;    /* SSG-EG output inversion flag        */
+  UINT8 ksr;        /* key scale rate  :kcode>>(3-KSR)		*/
+  UINT32 mul;       /* multiple        :ML_TABLE[ML]		*/
+
+  /* Phase Generator */
+  UINT32 Cnt;  /* frequency count :					*/
+  UINT32 Incr; /* frequency step  :					*/
+
+  /* Envelope Generator */
+  UINT8 state;  /* phase type							*/
+  INT32 volume; /* envelope counter						*/
+  UINT32 sl;    /* sustain level   :SL_TABLE[SL]		*/
+
+  UINT32 delta_ar; /* envelope step for Attack				*/
+  UINT32 delta_dr; /* envelope step for Decay				*/
+  UINT32 delta_sr; /* envelope step for Sustain			*/
+  UINT32 delta_rr; /* envelope step for Release			*/
+  UINT32 TLL;      /* adjusted TotalLevel					*/
+
+  UINT32 key; /* 0=last key was KEY OFF, 1=KEY ON		*/
+
+  /* LFO */
+  UINT32 amon; /* AMS enable flag						*/
+  UINT32 ams;  /* AMS depth level of this SLOT			*/
+} FM_SLOT;
+
+struct opn_f; /* the chip a channel's kernel runs for, see FM_OPN */
+
+typedef struct fm_chan {
+  FM_SLOT SLOT[4];
+  UINT8 ALGO;       /* Algorithm						*/
+  UINT8 FB;         /* feedback shift					*/
+  INT32 op1_out[2]; /* op1 output for feedback			*/
+  /* LFO */
+  INT32 pms;  /* PMS depth channel level			*/
+  UINT32 ams; /* AMS depth channel level			*/
+  /* Phase Generator */
+  UINT32 fc;   /* fnum,blk:adjusted to sample rate	*/
+  UINT8 kcode; /* key code:						*/
+  UINT8 idle;  /* silent until keyed on, see FM_CH_IDLE	*/
+  /* channel calculation for this setup, see setup_kernel */
+  INT32 (*calc)(struct opn_f *OPN, struct fm_chan *CH);
+} FM_CH;
+
+/* OPN common state */
+typedef struct fm_state {
+  UINT8 index;      /* chip index (number of chip) */
+  int clock;        /* master clock  (Hz)  */
+  int rate;         /* sampling rate (Hz)  */
+  double freqbase;  /* frequency base      */
+  double TimerBase; /* Timer base time     */
+#if FM_BUSY_FLAG_SUPPORT
+  INT32 BusyCount;  /* Busy flag sample counter (decrements each sample) */
+#endif
+  UINT8 address;       /* address register		*/
+  UINT8 irq;           /* interrupt level		*/
+  UINT8 irqmask;       /* irq mask				*/
+  UINT8 status;        /* status flag			*/
+  UINT32 mode;         /* mode  CSM / 3SLOT	*/
+  UINT8 prescaler_sel; /* prescaler slelector	*/
+  UINT8 fn_h;          /* freq latch			*/
+  int TA;              /* timer a				*/
+  int TAC;             /* timer a counter		*/
+  UINT8 TB;            /* timer b				*/
+  int TBC;             /* timer b counter		*/
+  /* local time tables */
+  INT32 DT_TABLE[8][32]; /* DeTune table		*/
+  UINT32 eg_tab[32 + 64 +
+                32]; /* Envelope Generator rates (32 + 64 rates + 32 RKS) */
+  /* Extention Timer and IRQ handler */
+  FM_TIMERHANDLER Timer_Handler;
+  FM_IRQHANDLER IRQ_Handler;
+  /* timer model single / interval */
+  UINT8 timermodel;
+} FM_ST;
+
+
+/* OPN 3slot struct */
+typedef struct opn_3slot {
+  UINT32 fc[3];   /* fnum3,blk3  :calculated */
+  UINT8 fn_h;     /* freq3 latch            */
+  UINT8 kcode[3]; /* key code    :          */
+} FM_3SLOT;
+
+/* OPN state */
+typedef struct opn_f {
+  FM_ST ST;                /* general state     */
+  FM_3SLOT SL3;            /* 3 slot mode state */
+  FM_CH *P_CH;             /* pointer of CH     */
+  unsigned int PAN[6 * 2]; /* fm channels output masks (0xffffffff = enable) */
+
+  UINT32 FN_TABLE[2048]; /* fnumber -> increment counter */
+  /* LFO */
+  UINT32 LFOCnt;
+  UINT32 LFOIncr;
+  UINT32 LFO_FREQ[8]; /* LFO FREQ table */
+  UINT32 lfo_amd;     /* AM depth for this sample */
+  INT32 lfo_pmd;      /* PM depth for this sample */
+} FM_OPN;
+
+typedef INT32 FM_CH_CALC(FM_OPN *OPN, FM_CH *CH);
+
+/* ----- limitter ----- */
+#define Limit(val, max, min) \
+  {                          \
+    if (val > max)           \
+      val = max;             \
+    else if (val < min)      \
+      val = min;             \
+  }
+
+/* ----- YM2612 DAC ladder effect ----- */
+/* The YM2612 has a 9-bit DAC with inherent non-linearity due to resistor
+ * ladder mismatches. This creates crossover distortion around zero crossing,
+ * giving the characteristic "crunchy" sound heard in Streets of Rage, etc.
+ *
+ * Based on analysis from Nuked-OPN2:
+ * - The DAC has asymmetric behavior around zero
+ * - Positive samples get a small positive bias
+ * - There's a "dead zone" around zero that pushes samples away
+ * - The effect is more pronounced at low amplitudes
+ *
+ * This simplified model captures the essential character of the distortion.
+ */
+INLINE INT32 ym2612_dac_ladder(INT32 sample)
+{
+  /* The ladder effect creates a "dead zone" around zero.
+   * Samples near zero get pushed away, creating crossover distortion.
+   * The threshold is approximately 1/256 of full scale (9-bit DAC behavior).
+   *
+   * For a 14-bit internal sample (after FINAL_SH), the dead zone is ~64 units.
+   * We model this as: if |sample| < threshold, push it away from zero.
+   */
+  const INT32 LADDER_THRESHOLD = 64;  /* Dead zone threshold */
+  const INT32 LADDER_BIAS = 32;       /* Bias to add in dead zone */
+
+  if (sample > 0) {
+    if (sample < LADDER_THRESHOLD) {
+      /* In dead zone: push away from zero */
+      sample += LADDER_BIAS;
+    }
+    /* Small positive bias for all positive samples (DAC +1 behavior) */
+    sample += (sample >> 9) + 1;
+  } else if (sample < 0) {
+    if (sample > -LADDER_THRESHOLD) {
+      /* In dead zone: push away from zero */
+      sample -= LADDER_BIAS;
+    }
+    /* Slight asymmetry for negative samples */
+    sample -= ((-sample) >> 9);
+  }
+  /* sample == 0 stays at 0 */
+
+  return sample;
+}
+
+#if FM_INTERNAL_TIMER
+/* ----- internal timer mode , update timer */
+/* ---------- calculate timer A ---------- */
+#define INTERNAL_TIMER_A(ST, CSM_CH)                      \
+  {                                                       \
+    if (ST->TAC && (ST->Timer_Handler == 0))              \
+      if ((ST->TAC -= (int)(ST->freqbase * 4096)) <= 0) { \
+        TimerAOver(ST);                                   \
+        /* CSM mode total level latch and auto key on */  \
+        if (ST->mode & 0x80)                              \
+          CSMKeyControll(CSM_CH);                         \
+      }                                                   \
+  }
+/* ---------- calculate timer B ---------- */
+#define INTERNAL_TIMER_B(ST, step)                             \
+  {                                                            \
+    if (ST->TBC && (ST->Timer_Handler == 0))                   \
+      if ((ST->TBC -= (int)(ST->freqbase * 4096 * step)) <= 0) \
+        TimerBOver(ST);                                        \
+  }
+#else /* FM_INTERNAL_TIMER */
+/* external timer mode */
+#define INTERNAL_TIMER_A(ST, CSM_CH)
+#define INTERNAL_TIMER_B(ST, step)
+#endif /* FM_INTERNAL_TIMER */
+
+/* --------------------- subroutines  --------------------- */
+/* status set and IRQ handling */
+INLINE void FM_STATUS_SET(FM_ST *ST, int flag)
+{
+  /* set status flag */
+  ST->status |= flag;
+  if (!(ST->irq) && (ST->status & ST->irqmask)) {
+    ST->irq = 1;
+    /* callback user interrupt handler (IRQ is OFF to ON) */
+    if (ST->IRQ_Handler)
+      (ST->IRQ_Handler)(ST->index, 1);
+  }
+}
+
+/* status reset and IRQ handling */
+INLINE void FM_STATUS_RESET(FM_ST *ST, int flag)
+{
+  /* reset status flag */
+  ST->status &= ~flag;
+  if ((ST->irq) && !(ST->status & ST->irqmask)) {
+    ST->irq = 0;
+    /* callback user interrupt handler (IRQ is ON to OFF) */
+    if (ST->IRQ_Handler)
+      (ST->IRQ_Handler)(ST->index, 0);
+  }
+}
+
+/* IRQ mask set */
+static void FM_IRQMASK_SET(FM_ST *ST, int flag)
+{
+  ST->irqmask = flag;
+  /* IRQ handling check */
+  FM_STATUS_SET(ST, 0);
+  FM_STATUS_RESET(ST, 0);
+}
+
+#if FM_BUSY_FLAG_SUPPORT
+/* Busy flag implementation using sample counter.
+ * The YM2612 sets the busy flag for approximately 32 FM clock cycles after a write.
+ * At 7.67 MHz FM clock and 44.1 kHz sample rate, this is less than 1 sample,
+ * but we use a minimum of 1 sample to ensure the flag is visible to polling code.
+ *
+ * The busy flag is important for games that poll the status register to wait
+ * for the chip to be ready before writing the next value. */
+INLINE UINT8 FM_STATUS_FLAG(FM_ST *ST)
+{
+  if (ST->BusyCount > 0)
+    return ST->status | 0x80; /* with busy */
+  return ST->status;
+}
+INLINE void FM_BUSY_SET(FM_ST *ST, int busyclock)
+{
+  /* Set busy for at least 1 sample. The busyclock parameter indicates
+   * the number of FM clocks the operation takes. We convert to samples:
+   * samples = busyclock * sample_rate / fm_clock
+   * For typical values (busyclock=32, rate=44100, clock=7670454):
+   * samples = 32 * 44100 / 7670454 ≈ 0.18, so we use minimum of 1 */
+  (void)busyclock; /* Currently unused - using fixed 1 sample */
+  ST->BusyCount = 1;
+}
+/* Called from ym2612_update to decrement busy counter each sample */
+INLINE void FM_BUSY_UPDATE(FM_ST *ST)
+{
+  if (ST->BusyCount > 0)
+    ST->BusyCount--;
+}
+#define FM_BUSY_CLEAR(ST) ((ST)->BusyCount = 0)
+#else
+#define FM_STATUS_FLAG(ST) ((ST)->status)
+#define FM_BUSY_SET(ST, bclock) \
+  {                             \
+  }
+#define FM_BUSY_UPDATE(ST) \
+  {                        \
+  }
+#define FM_BUSY_CLEAR(ST) \
+  {                       \
+  }
+#endif
+
+/* ---------- event handler of Phase Generator ---------- */
+
+/* phase of the envelope generator */
+#define EG_ATT 4
+#define EG_DEC 3
+#define EG_SUS 2
+#define EG_REL 1
+#define EG_OFF 0
+
+/* SSG-EG bit definitions (from SEG register, bits 0-3) */
+#define SSG_ENABLE   0x08  /* bit 3: SSG-EG enable */
+#define SSG_ATTACK   0x04  /* bit 2: attack direction (0=down, 1=up) */
+#define SSG_ALTERNATE 0x02 /* bit 1: alternate direction each cycle */
+#define SSG_HOLD     0x01  /* bit 0: hold at end of cycle */
+
+/* ----- key on of SLOT ----- */
+INLINE void FM_KEYON(FM_CH *CH, int s)
+{
+  FM_SLOT *SLOT = &CH->SLOT[s];
+  if (!SLOT->key) {
+    SLOT->key = 1;
+    /* restart Phase Generator */
+    SLOT->Cnt = 0;
+#if FM_SEG_SUPPORT
+    /* SSG-EG: initialize inversion state based on attack direction (bit 2) */
+    if (SLOT->SEG & SSG_ENABLE) {
+      /* SSG_ATTACK (bit 2) determines initial direction:
+       * 0 = start with downward envelope (normal)
+       * 1 = start with upward envelope (inverted output) */
+      SLOT->ssg_inv = (SLOT->SEG & SSG_ATTACK) ? 1 : 0;
+    } else {
+      SLOT->ssg_inv = 0;
+    }
+#endif
+    /* phase -> Attack */
+    SLOT->state = EG_ATT;
+    CH->idle = 0;
+  }
+}
+/* ----- key off of SLOT ----- */
+INLINE void FM_KEYOFF(FM_CH *CH, int s)
+{
+  FM_SLOT *SLOT = &CH->SLOT[s];
+  if (SLOT->key) {
+    SLOT->key = 0;
+#if FM_SEG_SUPPORT
+    /* SSG-EG: handle inversion on key-off.
+     * If output was inverted, we need to de-invert the volume
+     * so release phase starts from the actual output level. */
+    if ((SLOT->SEG & SSG_ENABLE) && SLOT->ssg_inv) {
+      /* De-invert: convert inverted volume to actual output volume */
+      SLOT->volume = MAX_ATT_INDEX - SLOT->volume;
+      if (SLOT->volume < 0)
+        SLOT->volume = 0;
+      SLOT->ssg_inv = 0;
+    }
+#endif
+    /* phase -> Release */
+    if (SLOT->state > EG_REL)
+      SLOT->state = EG_REL;
+  }
+}
+
+/* set detune & multiple */
+INLINE void set_det_mul(FM_ST *ST, FM_CH *CH, FM_SLOT *SLOT, int v)
+{
+  SLOT->mul = (v & 0x0f) ? (v & 0x0f) * 2 : 1;
+  SLOT->DT = ST->DT_TABLE[(v >> 4) & 7];
+  CH->SLOT[SLOT1].Incr = -1;
+}
+
+/* set total level */
+INLINE void set_tl(FM_CH *CH, FM_SLOT *SLOT, int v, int csmflag)
+{
+  SLOT->TL = (v & 0x7f) << (ENV_BITS - 7); /*7bit TL*/
+  /* if it is not a CSM channel , latch the total level */
+  if (!csmflag)
+    SLOT->TLL = SLOT->TL;
+}
+
+/* set attack rate & key scale  */
+INLINE void set_ar_ksr(FM_CH *CH, FM_SLOT *SLOT, int v, UINT32 *eg_tab)
+{
+  SLOT->KSR = 3 - (v >> 6);
+  SLOT->ARval = (v & 0x1f) ? 32 + ((v & 0x1f) << 1) : 0;
+  SLOT->AR = &eg_tab[SLOT->ARval];
+
+  if ((SLOT->ARval + SLOT->ksr) < 32 + 62)
+    SLOT->delta_ar = SLOT->AR[SLOT->ksr];
+  else
+    SLOT->delta_ar = MAX_ATT_INDEX + 1;
+
+  CH->SLOT[SLOT1].Incr =
+      -1; /* Optimize: only set this, if new SLOT->KSR is different */
+}
+
+/* set decay rate */
+INLINE void set_dr(FM_SLOT *SLOT, int v, UINT32 *eg_tab)
+{
+  SLOT->DR = (v & 0x1f) ? &eg_tab[32 + ((v & 0x1f) << 1)] : &eg_tab[0];
+  SLOT->delta_dr = SLOT->DR[SLOT->ksr];
+}
+
+/* set sustain rate */
+INLINE void set_sr(FM_SLOT *SLOT, int v, UINT32 *eg_tab)
+{
+  SLOT->SR = (v & 0x1f) ? &eg_tab[32 + ((v & 0x1f) << 1)] : &eg_tab[0];
+  SLOT->delta_sr = SLOT->SR[SLOT->ksr];
+}
+
+/* set release rate */
+INLINE void set_sl_rr(FM_SLOT *SLOT, int v, UINT32 *eg_tab)
+{
+  SLOT->sl = SL_TABLE[v >> 4];
+  SLOT->RR = &eg_tab[34 + ((v & 0x0f) << 2)];
+  SLOT->delta_rr = SLOT->RR[SLOT->ksr];
+}
+
+
+INLINE signed int op_calc(UINT32 phase, unsigned int env, signed int pm)
+{
+  UINT32 p;
+
+  p = (env << 3) +
+      sin_tab[(((signed int)((phase & ~FREQ_MASK) + (pm << 15))) >> FREQ_SH) &
+              SIN_MASK];
+
+  if (p >= TL_TAB_LEN)
+    return 0;
+  return tl_tab[p];
+}
+
+INLINE signed int op_calc1(UINT32 phase, unsigned int env, signed int pm)
+{
+  UINT32 p;
+  INT32 i;
+
+  i = (phase & ~FREQ_MASK) + pm;
+
+  /*logerror("i=%08x (i>>16)&511=%8i phase=%i [pm=%08x] ",i, (i>>16)&511,
+   * phase>>FREQ_SH, pm);*/
+
+  p = (env << 3) + sin_tab[(i >> FREQ_SH) & SIN_MASK];
+
+  /*logerror("(p&255=%i p>>8=%i) out= %i\n", p&255,p>>8, tl_tab[p&255]>>(p>>8)
+   * );*/
+
+  if (p >= TL_TAB_LEN)
+    return 0;
+  return tl_tab[p];
+}
+
+
+/*
+ * SSG-EG (SSG Envelope Generator) Implementation
+ *
+ * SSG-EG is controlled by register bits:
+ *   Bit 3: Enable SSG-EG mode
+ *   Bit 2: Attack direction (0 = attack towards min, 1 = attack towards max)
+ *   Bit 1: Alternate (toggle direction after each cycle)
+ *   Bit 0: Hold (hold at end instead of looping)
+ *
+ * The 8 SSG-EG types produce these envelope shapes:
+ *   1000: \\\\\\\ (repeat decay)
+ *   1001: \_____ (decay then hold low)
+ *   1010: \/\/\/\ (triangle wave)
+ *   1011: \^^^^^ (decay then hold high)
+ *   1100: /////// (repeat attack)
+ *   1101: /^^^^^ (attack then hold high)
+ *   1110: /\/\/\/ (inverted triangle)
+ *   1111: /_____ (attack then hold low)
+ */
+
+/* envelope step and output, without the LFO - static rather than INLINE,
+   no outside copy is needed and GCC then inlines it into every kernel */
+static inline unsigned int calc_eg_env(FM_SLOT *SLOT)
+{
+  unsigned int out;
+
+  switch (SLOT->state) {
+  case EG_ATT: /* attack phase */
+  {
+    INT32 step = SLOT->volume;
+
+    SLOT->volume -= SLOT->delta_ar;
+    step = (step >> ENV_SH) -
+           (((UINT32)SLOT->volume) >>
+            ENV_SH); /* number of levels passed since last time */
+    if (step > 0) {
+      INT32 tmp_volume =
+          SLOT->volume + (step << ENV_SH); /* adjust by number of levels */
+      do {
+        tmp_volume =
+            tmp_volume - (1 << ENV_SH) - ((tmp_volume >> 4) & ~ENV_MASK);
+        if (tmp_volume <= MIN_ATT_INDEX)
+          break;
+        step--;
+      } while (step);
+      SLOT->volume = tmp_volume;
+    }
+
+    if (SLOT->volume <= MIN_ATT_INDEX) {
+      if (SLOT->volume < 0)
+        SLOT->volume = 0;
+      SLOT->state = EG_DEC;
+    }
+  } break;
+
+  case EG_DEC: /* decay phase */
+    if ((SLOT->volume += SLOT->delta_dr) >= SLOT->sl) {
+      SLOT->volume = SLOT->sl;
+      SLOT->state = EG_SUS;
+    }
+    break;
+
+  case EG_SUS: /* sustain phase */
+#if FM_SEG_SUPPORT
+    /* SSG-EG: check for envelope completion during sustain */
+    if (SLOT->SEG & SSG_ENABLE) {
+      if ((SLOT->volume += SLOT->delta_sr) >= MAX_ATT_INDEX) {
+        /* Envelope reached minimum output (max attenuation) */
+        if (SLOT->SEG & SSG_HOLD) {
+          /* Hold mode */
+          if (SLOT->SEG & SSG_ALTERNATE) {
+            /* Hold with alternate: hold at opposite polarity */
+            SLOT->ssg_inv ^= 1;
+          }
+          /* Hold at current level */
+          SLOT->volume = MAX_ATT_INDEX;
+          SLOT->state = EG_OFF;
+        } else {
+          /* Loop mode */
+          if (SLOT->SEG & SSG_ALTERNATE) {
+            /* Alternate: invert and continue from max */
+            SLOT->ssg_inv ^= 1;
+          }
+          /* Restart from max volume (min attenuation) */
+          SLOT->volume = MIN_ATT_INDEX;
+          SLOT->state = EG_ATT;
+        }
+      }
+    } else
+#endif
+    {
+      /* Normal sustain behavior */
+      if ((SLOT->volume += SLOT->delta_sr) > MAX_ATT_INDEX) {
+        SLOT->volume = MAX_ATT_INDEX;
+        SLOT->state = EG_OFF;
+      }
+    }
+    break;
+
+  case EG_REL: /* release phase */
+#if FM_SEG_SUPPORT
+    /* SSG-EG during release: handle specially */
+    if (SLOT->SEG & SSG_ENABLE) {
+      /* When SSG-EG is active, release may need special handling.
+       * If envelope was inverted, we need to consider the inversion
+       * when transitioning to release. The release phase itself
+       * runs normally but starts from the current (possibly inverted) position. */
+      if ((SLOT->volume += SLOT->delta_rr) > MAX_ATT_INDEX) {
+        SLOT->volume = MAX_ATT_INDEX;
+        SLOT->state = EG_OFF;
+      }
+    } else
+#endif
+    {
+      if ((SLOT->volume += SLOT->delta_rr) > MAX_ATT_INDEX) {
+        SLOT->volume = MAX_ATT_INDEX;
+        SLOT->state = EG_OFF;
+      }
+    }
+    break;
+  }
+
+  /* Calculate output with SSG-EG inversion */
+#if FM_SEG_SUPPORT
+  if ((SLOT->SEG & SSG_ENABLE) && SLOT->ssg_inv && (SLOT->state != EG_OFF)) {
+    /* SSG-EG inversion: output = MAX - volume
+     * This creates the "upward" envelope shapes */
+    out = SLOT->TLL +
+          ((MAX_ATT_INDEX - (unsigned int)SLOT->volume) >> ENV_SH);
+  } else
+#endif
+  {
+    out = SLOT->TLL + (((unsigned int)SLOT->volume) >> ENV_SH);
+  }
+  return out;
+}
+
+static inline unsigned int calc_eg(FM_SLOT *SLOT, UINT32 lfo_amd)
+{
+  unsigned int out = calc_eg_env(SLOT);
+
+  if (SLOT->ams)
+    out += (SLOT->ams * lfo_amd / LFO_RATE);
+  return out;
+}
+
+
+/* ---------- update phase counters of a channel ---------- */
+INLINE void FM_CALC_PG(FM_CH *CH, INT32 lfo_pmd)
+{
+  INT32 pms = lfo_pmd * CH->pms / LFO_RATE;
+  if (pms) {
+    CH->SLOT[SLOT1].Cnt +=
+        CH->SLOT[SLOT1].Incr + (INT32)(pms * CH->SLOT[SLOT1].Incr) / PMS_RATE;
+    CH->SLOT[SLOT2].Cnt +=
+        CH->SLOT[SLOT2].Incr + (INT32)(pms * CH->SLOT[SLOT2].Incr) / PMS_RATE;
+    CH->SLOT[SLOT3].Cnt +=
+        CH->SLOT[SLOT3].Incr + (INT32)(pms * CH->SLOT[SLOT3].Incr) / PMS_RATE;
+    CH->SLOT[SLOT4].Cnt +=
+        CH->SLOT[SLOT4].Incr + (INT32)(pms * CH->SLOT[SLOT4].Incr) / PMS_RATE;
+  } else {
+    CH->SLOT[SLOT1].Cnt += CH->SLOT[SLOT1].Incr;
+    CH->SLOT[SLOT2].Cnt += CH->SLOT[SLOT2].Incr;
+    CH->SLOT[SLOT3].Cnt += CH->SLOT[SLOT3].Incr;
+    CH->SLOT[SLOT4].Cnt += CH->SLOT[SLOT4].Incr;
+  }
+}
+
+/* ---------- calculate a channel that is panned off ---------- */
+/* Only what carries over to later samples: envelopes, phases and the SLOT1
+   feedback.  The other slots only feed the channel output, which is not
+   heard. */
+INLINE void FM_CALC_CH_FB(FM_OPN *OPN, FM_CH *CH)
+{
+  unsigned int eg_out1;
+  INT32 out = CH->op1_out[0] + CH->op1_out[1];
+
+  eg_out1 = calc_eg(&CH->SLOT[SLOT1], OPN->lfo_amd);
+  calc_eg(&CH->SLOT[SLOT2], OPN->lfo_amd);
+  calc_eg(&CH->SLOT[SLOT3], OPN->lfo_amd);
+  calc_eg(&CH->SLOT[SLOT4], OPN->lfo_amd);
+
+  CH->op1_out[0] = CH->op1_out[1];
+  CH->op1_out[1] = 0;
+  if (eg_out1 < ENV_QUIET) /* SLOT 1 */
+    CH->op1_out[1] = op_calc1(CH->SLOT[SLOT1].Cnt, eg_out1, (out << CH->FB));
+
+  FM_CALC_PG(CH, OPN->lfo_pmd);
+}
+
+/* ---------- whether a channel is silent until it is next keyed on ---------- */
+/* Every slot is off (no envelope step changes it), too quiet to be heard and
+   not SSG-EG inverted (key off would de-invert it), and the feedback has died
+   away, so the channel calculation would only move the phase counters - which
+   key on resets. */
+INLINE int FM_CH_IDLE(FM_CH *CH)
+{
+  int s;
+
+  if (CH->op1_out[0] || CH->op1_out[1])
+    return 0;
+  for (s = 0; s < 4; s++)
+    if (CH->SLOT[s].state != EG_OFF ||
+        ((UINT32)CH->SLOT[s].volume >> ENV_SH) < ENV_QUIET ||
+        CH->SLOT[s].ssg_inv)
+      return 0;
+  return 1;
+}
+
+/* ---------- channel calculation specialised by genfm ---------- */
+#include "fm-kernels.h"
+
+/* ---------- pick the kernel for a channel's algorithm, LFO and FB ---------- */
+/* The algorithms (connections) are:
+   0: PG---S1---S2---S3---S4---OUT
+   1: PG---S1-+-S3---S4---OUT    2: PG---S1------+-S4---OUT
+      PG---S2-+                     PG---S2---S3-+
+   3: PG---S1---S2-+-S4---OUT    4: PG---S1---S2-+--OUT
+      PG---S3------+                PG---S3---S4-+
+   5:         +-S2-+             6: PG---S1---S2-+
+      PG---S1-+-S3-+-OUT            PG--------S3-+-OUT
+              +-S4-+                PG--------S4-+
+   7: PG---S1-+
+      PG---S2-+-OUT
+      PG---S3-+
+      PG---S4-+ */
+static void setup_kernel(FM_CH *CH)
+{
+  CH->calc = fm_kernels[CH->ALGO][CH->pms || CH->ams][CH->FB != 0];
+}
+
+/* ---------- update phase increment counter of operator ---------- */
+INLINE void CALC_FCSLOT(FM_SLOT *SLOT, int fc, int kc)
+{
+  int ksr;
+
+  /* (frequency) phase increment counter */
+  SLOT->Incr = ((fc + SLOT->DT[kc]) * SLOT->mul) >> 1;
+
+  ksr = kc >> SLOT->KSR;
+  if (SLOT->ksr != ksr) {
+    SLOT->ksr = ksr;
+    /* calculate envelope generator rates */
+    if ((SLOT->ARval + ksr) < 32 + 62)
+      SLOT->delta_ar = SLOT->AR[ksr];
+    else
+      SLOT->delta_ar = MAX_ATT_INDEX + 1;
+    SLOT->delta_dr = SLOT->DR[ksr];
+    SLOT->delta_sr = SLOT->SR[ksr];
+    SLOT->delta_rr = SLOT->RR[ksr];
+  }
+}
+
+/* ---------- update phase increments counters  ---------- */
+INLINE void OPN_CALC_FCOUNT(FM_CH *CH)
+{
+  if (CH->SLOT[SLOT1].Incr == -1) {
+    int fc = CH->fc;
+    int kc = CH->kcode;
+    CALC_FCSLOT(&CH->SLOT[SLOT1], fc, kc);
+    CALC_FCSLOT(&CH->SLOT[SLOT2], fc, kc);
+    CALC_FCSLOT(&CH->SLOT[SLOT3], fc, kc);
+    CALC_FCSLOT(&CH->SLOT[SLOT4], fc, kc);
+  }
+}
+
+/* ----------- initialize time tables ----------- */
+static void init_timetables(FM_ST *ST, UINT8 *DTTABLE)
+{
+  int i, d;
+  double rate;
+
+#if 0
+	logerror("FM.C: samplerate=%8i chip clock=%8i  freqbase=%f  \n",
+			 ST->rate, ST->clock, ST->freqbase );
+#endif
+
+  /* DeTune table */
+  for (d = 0; d <= 3; d++) {
+    for (i = 0; i <= 31; i++) {
+      rate = ((double)DTTABLE[d * 32 + i]) * SIN_LEN * ST->freqbase *
+             (1 << FREQ_SH) / ((double)(1 << 20));
+      ST->DT_TABLE[d][i] = (INT32)rate;
+      ST->DT_TABLE[d + 4][i] = (INT32)-rate;
+#if 0
+			logerror("FM.C: DT [%2i %2i] = %8x  \n", d, i, ST->DT_TABLE[d][i] );
+#endif
+    }
+  }
+
+  /* calculate Envelope Generator rate table */
+  for (i = 0; i < 34; i++)
+    ST->eg_tab[i] = 0; /* infinity */
+
+  /* Envelope timing ratio correction:
+   * The original MAME core assumed a 1:3 ratio between frequency counter
+   * and envelope generator updates. Hardware tests show the actual ratio
+   * is approximately 1:2.4375 (39/16).
+   *
+   * To correct this, we scale the envelope rate divisor:
+   * Original: 12.0 * 1024.0 (assumes 1:3 ratio)
+   * Corrected: 12.0 * (48.0/39.0) * 1024.0 (corrects to 1:2.4375 ratio)
+   *
+   * This makes envelopes progress at the correct rate relative to pitch. */
+  const double EG_RATE_DIVISOR = 12.0 * (48.0 / 39.0) * 1024.0;
+
+  for (i = 2; i < 64; i++) {
+    rate = ST->freqbase; /* frequency rate */
+    if (i < 60)
+      rate *= 1.0 + (i & 3) * 0.25; /* b0-1 : x1 , x1.25 , x1.5 , x1.75 */
+    rate *= 1 << (i >> 2);          /* b2-5 : shift bit */
+    rate /= EG_RATE_DIVISOR;
+    rate *= (double)(1 << ENV_SH);
+    ST->eg_tab[32 + i] = rate;
+#if 0
+		logerror("FM.C: Rate %2i %1i  Decay [real %11.4f ms][emul %11.4f ms][d=%08x]\n",i>>2, i&3,
+			( ((double)(ENV_LEN<<ENV_SH)) / rate )                     * (1000.0 / (double)ST->rate),
+			( ((double)(ENV_LEN<<ENV_SH)) / (double)ST->eg_tab[32+i] ) * (1000.0 / (double)ST->rate), ST->eg_tab[32+i] );
+#endif
+  }
+
+  for (i = 0; i < 32; i++) {
+    ST->eg_tab[32 + 64 + i] = ST->eg_tab[32 + 63];
+  }
+}
+
+/* ---------- reset one of channel  ---------- */
+static void reset_channel(FM_ST *ST, FM_CH *CH, int chan)
+{
+  int c, s;
+
+  ST->mode = 0; /* normal mode */
+  FM_STATUS_RESET(ST, 0xff);
+  ST->TA = 0;
+  ST->TAC = 0;
+  ST->TB = 0;
+  ST->TBC = 0;
+
+  for (c = 0; c < chan; c++) {
+    CH[c].fc = 0;
+    for (s = 0; s < 4; s++) {
+      CH[c].SLOT[s].SEG = 0;
+      CH[c].SLOT[s].ssg_inv = 0;
+      CH[c].SLOT[s].state = EG_OFF;
+      CH[c].SLOT[s].volume = MAX_ATT_INDEX;
+    }
+    CH[c].idle = 0;
+  }
+}
+
+/* ---------- initialize generic tables ---------- */
+
+static void init_tables(void)
+{
+  signed int i, x;
+  signed int n;
+  double o, m;
+
+  for (x = 0; x < TL_RES_LEN; x++) {
+    m = (1 << 16) / pow(2, (x + 1) * (ENV_STEP / 4.0) / 8.0);
+    m = floor(m);
+
+    /* we never reach (1<<16) here due to the (x+1) */
+    /* result fits within 16 bits at maximum */
+
+    n = (int)m; /* 16 bits here */
+    n >>= 4;    /* 12 bits here */
+    if (n & 1)  /* round to nearest */
+      n = (n >> 1) + 1;
+    else
+      n = n >> 1;
+    /* 11 bits here (rounded) */
+    n <<= 2; /* 13 bits here (as in real chip) */
+    tl_tab[x * 2 + 0] = n;
+    tl_tab[x * 2 + 1] = -tl_tab[x * 2 + 0];
+
+    for (i = 1; i < 13; i++) {
+      tl_tab[x * 2 + 0 + i * 2 * TL_RES_LEN] = tl_tab[x * 2 + 0] >> i;
+      tl_tab[x * 2 + 1 + i * 2 * TL_RES_LEN] =
+          -tl_tab[x * 2 + 0 + i * 2 * TL_RES_LEN];
+    }
+#if 0
+			logerror("tl %04i", x);
+			for (i=0; i<13; i++)
+				logerror(", [%02i] %4x", i*2, tl_tab[ x*2 /*+1*/ + i*2*TL_RES_LEN ]);
+			logerror("\n");
+		}
+#endif
+  }
+  /*logerror("FM.C: TL_TAB_LEN = %i elements (%i bytes)\n",TL_TAB_LEN,
+   * (int)sizeof(tl_tab));*/
+
+
+  for (i = 0; i < SIN_LEN; i++) {
+    /* non-standard sinus */
+    m = sin(((i * 2) + 1) * PI / SIN_LEN); /* checked against the real chip */
+
+    /* we never reach zero here due to ((i*2)+1) */
+
+    if (m > 0.0)
+      o = 8 * log(1.0 / m) / log(2); /* convert to 'decibels' */
+    else
+      o = 8 * log(-1.0 / m) / log(2); /* convert to 'decibels' */
+
+    o = o / (ENV_STEP / 4);
+
+    n = (int)(2.0 * o);
+    if (n & 1) /* round to nearest */
+      n = (n >> 1) + 1;
+    else
+      n = n >> 1;
+
+    sin_tab[i] = n * 2 + (m >= 0.0 ? 0 : 1);
+    /*logerror("FM.C: sin [%4i]= %4i (tl_tab value=%5i)\n", i,
+     * sin_tab[i],tl_tab[sin_tab[i]]);*/
+  }
+
+  /*logerror("FM.C: ENV_QUIET= %08x\n",ENV_QUIET );*/
+}
+
+/* OPN Mode  Register Write */
+INLINE void FMSetMode(FM_ST *ST, int n, int v)
+{
+  /* b7 = CSM MODE */
+  /* b6 = 3 slot mode */
+  /* b5 = reset b */
+  /* b4 = reset a */
+  /* b3 = timer enable b */
+  /* b2 = timer enable a */
+  /* b1 = load b */
+  /* b0 = load a */
+  ST->mode = v;
+
+  /* reset Timer b flag */
+  if (v & 0x20)
+    FM_STATUS_RESET(ST, 0x02);
+  /* reset Timer a flag */
+  if (v & 0x10)
+    FM_STATUS_RESET(ST, 0x01);
+  /* load b */
+  if (v & 0x02) {
+    if (ST->TBC == 0) {
+      /* James Ponder 2001-09-30: Timer is not correct, adjusted by 12 */
+      ST->TBC = (256 - ST->TB) << (4 + 12);
+      /* External timer handler */
+      if (ST->Timer_Handler)
+        (ST->Timer_Handler)(n, 1, ST->TBC, ST->TimerBase);
+    }
+  } else if (ST->timermodel == FM_TIMER_INTERVAL) { /* stop interbval timer */
+    if (ST->TBC != 0) {
+      ST->TBC = 0;
+      if (ST->Timer_Handler)
+        (ST->Timer_Handler)(n, 1, 0, ST->TimerBase);
+    }
+  }
+  /* load a */
+  if (v & 0x01) {
+    if (ST->TAC == 0) {
+      /* James Ponder 2001-09-30: Timer is not correct, adjusted by 12 */
+      ST->TAC = (1024 - ST->TA) << 12;
+      /* External timer handler */
+      if (ST->Timer_Handler)
+        (ST->Timer_Handler)(n, 0, ST->TAC, ST->TimerBase);
+    }
+  } else if (ST->timermodel == FM_TIMER_INTERVAL) { /* stop interbval timer */
+    if (ST->TAC != 0) {
+      ST->TAC = 0;
+      if (ST->Timer_Handler)
+        (ST->Timer_Handler)(n, 0, 0, ST->TimerBase);
+    }
+  }
+}
+
+/* Timer A Overflow */
+static void TimerAOver(FM_ST *ST)
+{
+  /* set status (if enabled) */
+  if (ST->mode & 0x04)
+    FM_STATUS_SET(ST, 0x01);
+  /* clear or reload the counter */
+  if (ST->timermodel == FM_TIMER_INTERVAL) {
+    /* James Ponder 2001-09-30: Timer is not correct, adjusted by 12 */
+    ST->TAC = (1024 - ST->TA) << 12;
+    if (ST->Timer_Handler)
+      (ST->Timer_Handler)(ST->index, 0, ST->TAC, ST->TimerBase);
+  } else
+    ST->TAC = 0;
+}
+/* Timer B Overflow */
+static void TimerBOver(FM_ST *ST)
+{
+  /* set status (if enabled) */
+  if (ST->mode & 0x08)
+    FM_STATUS_SET(ST, 0x02);
+  /* clear or reload the counter */
+  if (ST->timermodel == FM_TIMER_INTERVAL) {
+    /* James Ponder 2001-09-30: Timer is not correct, adjusted by 12 */
+    ST->TBC = (256 - ST->TB) << (4 + 12);
+    if (ST->Timer_Handler)
+      (ST->Timer_Handler)(ST->index, 1, ST->TBC, ST->TimerBase);
+  } else
+    ST->TBC = 0;
+}
+/* CSM Key Controll */
+static void CSMKeyControll(FM_CH *CH)
+{
+  /* all key off */
+  /* FM_KEYOFF(CH,SLOT1); */
+  /* FM_KEYOFF(CH,SLOT2); */
+  /* FM_KEYOFF(CH,SLOT3); */
+  /* FM_KEYOFF(CH,SLOT4); */
+  /* total level latch */
+  CH->SLOT[SLOT1].TLL = CH->SLOT[SLOT1].TL;
+  CH->SLOT[SLOT2].TLL = CH->SLOT[SLOT2].TL;
+  CH->SLOT[SLOT3].TLL = CH->SLOT[SLOT3].TL;
+  CH->SLOT[SLOT4].TLL = CH->SLOT[SLOT4].TL;
+  /* all key on */
+  FM_KEYON(CH, SLOT1);
+  FM_KEYON(CH, SLOT2);
+  FM_KEYON(CH, SLOT3);
+  FM_KEYON(CH, SLOT4);
+}
+
+/* FM channel save , internal state only */
+static void FMsave_state_channel(const char *name, int num, FM_CH *CH,
+                                 int num_ch)
+{
+  int slot, ch;
+  char state_name[20];
+  const char slot_array[4] = {1, 3, 2, 4};
+
+  for (ch = 0; ch < num_ch; ch++, CH++) {
+    /* channel */
+    sprintf(state_name, "%s.CH%d", name, ch);
+    state_save_register_INT32(state_name, num, "feedback", CH->op1_out, 2);
+    state_save_register_UINT32(state_name, num, "phasestep", &CH->fc, 1);
+    /* slots */
+    for (slot = 0; slot < 4; slot++) {
+      FM_SLOT *SLOT = &CH->SLOT[slot];
+
+      sprintf(state_name, "%s.CH%d.SLOT%d", name, ch, slot_array[slot]);
+      state_save_register_UINT32(state_name, num, "phasecount", &SLOT->Cnt, 1);
+      state_save_register_UINT8(state_name, num, "state", &SLOT->state, 1);
+      state_save_register_INT32(state_name, num, "volume", &SLOT->volume, 1);
+      state_save_register_UINT32(state_name, num, "totallevel", &SLOT->TLL, 1);
+    }
+  }
+}
+
+static void FMsave_state_st(const char *state_name, int num, FM_ST *ST)
+{
+#if FM_BUSY_FLAG_SUPPORT
+  state_save_register_INT32(state_name, num, "BusyCount", &ST->BusyCount, 1);
+#endif
+  state_save_register_UINT8(state_name, num, "address", &ST->address, 1);
+  state_save_register_UINT8(state_name, num, "IRQ", &ST->irq, 1);
+  state_save_register_UINT8(state_name, num, "IRQ MASK", &ST->irqmask, 1);
+  state_save_register_UINT8(state_name, num, "status", &ST->status, 1);
+  state_save_register_UINT32(state_name, num, "mode", &ST->mode, 1);
+  state_save_register_UINT8(state_name, num, "prescaler", &ST->prescaler_sel,
+                            1);
+  state_save_register_UINT8(state_name, num, "freq latch", &ST->fn_h, 1);
+  state_save_register_int(state_name, num, "TIMER A", &ST->TA);
+  state_save_register_int(state_name, num, "TIMER Acnt", &ST->TAC);
+  state_save_register_UINT8(state_name, num, "TIMER B", &ST->TB, 1);
+  state_save_register_int(state_name, num, "TIMER Bcnt", &ST->TBC);
+}
+
+/***********************************************************/
+/* OPN unit                                                */
+/***********************************************************/
+
+/* OPN key frequency number -> key code follow table */
+/* fnum higher 4bit -> keycode lower 2bit */
+static const UINT8 OPN_FKTABLE[16] = {0, 0, 0, 0, 0, 0, 0, 1,
+                                      2, 3, 3, 3, 3, 3, 3, 3};
+
+/* ---------- the tables every chip shares ---------- */
+/* Built by the first ym2612_init, only read after that */
+static void OPNInitTable(void)
+{
+  int i;
+
+  /* LFO wave table */
+  for (i = 0; i < LFO_ENT; i++) {
+    OPN_LFO_wave[i] = i < LFO_ENT / 2
+                          ? i * LFO_RATE / (LFO_ENT / 2)
+                          : (LFO_ENT - i) * LFO_RATE / (LFO_ENT / 2);
+
+    /*logerror("FM.C: OPN_LFO_wave[%4i]= %8x\n",i,OPN_LFO_wave[i]);*/
+    /* 0, 0x0100, 0x0200, 0x0300 ... 0xff00, 0x10000, 0xff00..0x0100 */
+  }
+
+  init_tables();
+}
+
+/* ---------- prescaler set(and make time tables) ---------- */
+static void OPNSetPres(FM_OPN *OPN, int pres, int TimerPres)
+{
+  int i;
+
+  /* frequency base */
+#if 1
+  OPN->ST.freqbase =
+      (OPN->ST.rate) ? ((double)OPN->ST.clock / OPN->ST.rate) / pres : 0;
+#else
+  OPN->ST.rate = (double)OPN->ST.clock / pres;
+  OPN->ST.freqbase = 1.0;
+#endif
+
+  /* Timer base time */
+  OPN->ST.TimerBase = 1.0 / ((double)OPN->ST.clock / (double)TimerPres);
+  /* make time tables */
+  init_timetables(&OPN->ST, OPN_DTTABLE);
+  /* calculate fnumber -> increment counter table */
+  for (i = 0; i < 2048; i++) {
+    /* freq table for octave 7 */
+    /* opn phase increment counter = 20bit */
+    OPN->FN_TABLE[i] =
+        (UINT32)((double)i * 64 * OPN->ST.freqbase *
+                 (1 << (FREQ_SH - 10))); /* -10 because chip works with 10.10
+                                            fixed point, while we use 16.16 */
+#if 0
+		logerror("FM.C: FN_TABLE[%4i] = %08x (dec=%8i)\n",
+				 i, OPN->FN_TABLE[i]>>6,OPN->FN_TABLE[i]>>6 );
+#endif
+  }
+
+  /* LFO freq. table */
+  {
+    /* 3.98Hz,5.56Hz,6.02Hz,6.37Hz,6.88Hz,9.63Hz,48.1Hz,72.2Hz @ 8MHz */
+#define FM_LF(Hz) ((double)LFO_ENT * (1 << LFO_SH) * (Hz) / (8000000.0 / 144))
+    static const double freq_table[8] = {FM_LF(3.98), FM_LF(5.56), FM_LF(6.02),
+                                         FM_LF(6.37), FM_LF(6.88), FM_LF(9.63),
+                                         FM_LF(48.1), FM_LF(72.2)};
+#undef FM_LF
+    for (i = 0; i < 8; i++) {
+      OPN->LFO_FREQ[i] = (UINT32)(freq_table[i] * OPN->ST.freqbase);
+    }
+  }
+
+  /*	LOG(LOG_INF,("OPN %d set prescaler %d\n",OPN->ST.index,pres));*/
+}
+
+/* ---------- write a timer register 0x24-0x27 ---------- */
+static void FMWriteTimer(FM_ST *ST, int r, int v)
+{
+  switch (r) {
+  case 0x24: /* timer A High 8*/
+    ST->TA = (ST->TA & 0x03) | (((int)v) << 2);
+    break;
+  case 0x25: /* timer A Low 2*/
+    ST->TA = (ST->TA & 0x3fc) | (v & 3);
+    break;
+  case 0x26: /* timer B */
+    ST->TB = v;
+    break;
+  case 0x27: /* mode , timer controll */
+    FMSetMode(ST, ST->index, v);
+    break;
+  }
+}
+
+/* ---------- write a OPN mode register 0x20-0x2f ---------- */
+static void OPNWriteMode(FM_OPN *OPN, int r, int v)
+{
+  UINT8 c;
+  FM_CH *CH;
+
+  switch (r) {
+  case 0x21: /* Test */
+    break;
+  case 0x22: /* LFO FREQ */
+    OPN->LFOIncr = (v & 0x08) ? OPN->LFO_FREQ[v & 7] : 0;
+    break;
+  case 0x24: /* timer A High 8*/
+  case 0x25: /* timer A Low 2*/
+  case 0x26: /* timer B */
+  case 0x27: /* mode , timer controll */
+    FMWriteTimer(&(OPN->ST), r, v);
+    break;
+  case 0x28: /* key on / off */
+    c = v & 0x03;
+    if (c == 3)
+      break;
+    if (v & 0x04)
+      c += 3;
+    CH = OPN->P_CH;
+    CH = &CH[c];
+    /* csm mode */
+    /* if( c == 2 && (OPN->ST.mode & 0x80) ) break; */
+    if (v & 0x10)
+      FM_KEYON(CH, SLOT1);
+    else
+      FM_KEYOFF(CH, SLOT1);
+    if (v & 0x20)
+      FM_KEYON(CH, SLOT2);
+    else
+      FM_KEYOFF(CH, SLOT2);
+    if (v & 0x40)
+      FM_KEYON(CH, SLOT3);
+    else
+      FM_KEYOFF(CH, SLOT3);
+    if (v & 0x80)
+      FM_KEYON(CH, SLOT4);
+    else
+      FM_KEYOFF(CH, SLOT4);
+    /*		LOG(LOG_INF,("OPN %d:%d : KEY %02X\n",n,c,v&0xf0));*/
+    break;
+  }
+}
+
+/* ---------- write a OPN register (0x30-0xff) ---------- */
+static void OPNWriteReg(FM_OPN *OPN, int r, int v)
+{
+  UINT8 c;
+  FM_CH *CH;
+  FM_SLOT *SLOT;
+
+  /* 0x30 - 0xff */
+  if ((c = OPN_CHAN(r)) == 3)
+    return; /* 0xX3,0xX7,0xXB,0xXF */
+  if (r >= 0x100)
+    c += 3;
+  CH = OPN->P_CH;
+  CH = &CH[c];
+
+  SLOT = &(CH->SLOT[OPN_SLOT(r)]);
+  switch (r & 0xf0) {
+  case 0x30: /* DET , MUL */
+    set_det_mul(&OPN->ST, CH, SLOT, v);
+    break;
+  case 0x40: /* TL */
+    set_tl(CH, SLOT, v, (c == 2) && (OPN->ST.mode & 0x80));
+    break;
+  case 0x50: /* KS, AR */
+    set_ar_ksr(CH, SLOT, v, OPN->ST.eg_tab);
+    break;
+  case 0x60: /*     DR */
+    /* bit7 = AMS_ON ENABLE(YM2612) */
+    set_dr(SLOT, v, OPN->ST.eg_tab);
+    SLOT->amon = (v & 0x80) ? ~0 : 0;
+    SLOT->ams = CH->ams & SLOT->amon;
+    break;
+  case 0x70: /*     SR */
+    set_sr(SLOT, v, OPN->ST.eg_tab);
+    break;
+  case 0x80: /* SL, RR */
+    set_sl_rr(SLOT, v, OPN->ST.eg_tab);
+    break;
+  case 0x90: /* SSG-EG */
+    SLOT->SEG = v & 0x0f;
+    break;
+  case 0xa0:
+    switch (OPN_SLOT(r)) {
+    case 0: /* 0xa0-0xa2 : FNUM1 */
+    {
+      UINT32 fn = (((UINT32)((OPN->ST.fn_h) & 7)) << 8) + v;
+      UINT8 blk = OPN->ST.fn_h >> 3;
+      /* keyscale code */
+      CH->kcode = (blk << 2) | OPN_FKTABLE[(fn >> 7)];
+      /* phase increment counter */
+      CH->fc = OPN->FN_TABLE[fn] >> (7 - blk);
+      CH->SLOT[SLOT1].Incr = -1;
+    } break;
+    case 1: /* 0xa4-0xa6 : FNUM2,BLK */
+      OPN->ST.fn_h = v & 0x3f;
+      break;
+    case 2: /* 0xa8-0xaa : 3CH FNUM1 */
+      if (r < 0x100) {
+        UINT32 fn = (((UINT32)(OPN->SL3.fn_h & 7)) << 8) + v;
+        UINT8 blk = OPN->SL3.fn_h >> 3;
+        /* keyscale code */
+        OPN->SL3.kcode[c] = (blk << 2) | OPN_FKTABLE[(fn >> 7)];
+        /* phase increment counter */
+        OPN->SL3.fc[c] = OPN->FN_TABLE[fn] >> (7 - blk);
+        (OPN->P_CH)[2].SLOT[SLOT1].Incr = -1;
+      }
+      break;
+    case 3: /* 0xac-0xae : 3CH FNUM2,BLK */
+      if (r < 0x100)
+        OPN->SL3.fn_h = v & 0x3f;
+      break;
+    }
+    break;
+  case 0xb0:
+    switch (OPN_SLOT(r)) {
+    case 0: /* 0xb0-0xb2 : FB,ALGO */
+    {
+      int feedback = (v >> 3) & 7;
+      CH->ALGO = v & 7;
+      CH->FB = feedback ? feedback + 6 : 0;
+      setup_kernel(CH);
+    } break;
+    case 1: /* 0xb4-0xb6 : L , R , AMS , PMS */
+    {
+      /* b0-2 PMS */
+      /* 0,3.4,6.7,10,14,20,40,80(cent) */
+      static const double pmd_table[8] = {0, 3.4, 6.7, 10, 14, 20, 40, 80};
+
+      /* b4-5 AMS */
+      /* 0, 1.4,     5.9,     11.8           (dB) */
+      /* 0, 1.40625, 5.90625, 11.90625 (or 11.8125) */
+      /* 0, 15,    , 63	  , 127      (or 126)   in internal representation */
+
+      /* bit0,    bit1,   bit2,  bit3, bit4, bit5, bit6, bit7, bit8, bit9 */
+      /* 1,       2,      4,     8,    16,   32,   64,   128,  256,  512
+       * (internal representation value)*/
+      /* 0.09375, 0.1875, 0.375, 0.75, 1.5,  3,    6,    12,   24,   48 (dB)*/
+      static const int amd_table[4] = {
+          (int)(((0.0 * 4) / 3) / ENV_STEP),
+          (int)(((1.40625 * 4) / 3) / ENV_STEP),
+          (int)(((5.90625 * 4) / 3) / ENV_STEP),
+          (int)(((11.90625 * 4) / 3) / ENV_STEP)};
+      /* amd_table simply becomes = { 0, 15, 63, 127 } */
+
+      CH->pms = (INT32)((1.5 / 1200.0) * pmd_table[v & 7] * PMS_RATE);
+
+      CH->ams = amd_table[(v >> 4) & 0x03];
+      CH->SLOT[SLOT1].ams = CH->ams & CH->SLOT[SLOT1].amon;
+      CH->SLOT[SLOT2].ams = CH->ams & CH->SLOT[SLOT2].amon;
+      CH->SLOT[SLOT3].ams = CH->ams & CH->SLOT[SLOT3].amon;
+      CH->SLOT[SLOT4].ams = CH->ams & CH->SLOT[SLOT4].amon;
+      setup_kernel(CH);
+
+      /* PAN :  b7 = L, b6 = R */
+      OPN->PAN[c * 2] = (v & 0x80) ? ~0 : 0;
+      OPN->PAN[c * 2 + 1] = (v & 0x40) ? ~0 : 0;
+
+      /* LOG(LOG_INF,("OPN %d,%d : PAN %x
+       * %x\n",n,c,OPN->PAN[c*2],OPN->PAN[c*2+1]));*/
+    } break;
+    }
+    break;
+  }
+}
+
+/*******************************************************************************/
+/*		YM2612 local section                                                   */
+/*******************************************************************************/
+
+/* here's the virtual YM2612 */
+typedef struct ym2612 {
+  UINT8 REGS[512]; /* registers         */
+  FM_OPN OPN;      /* OPN state       */
+  FM_CH CH[6];     /* channel state */
+  int address1;    /* address register1 */
+  /* dac output (YM2612) */
+  int dacen;
+  INT32 dacout;
+  INT32 out_fm[6]; /* outputs of the channels */
+  FM_ST peek;      /* timers ahead of the chip, see ym2612_peek */
+} YM2612;
+
+/* ---------- mix the channel outputs into sample i ---------- */
+INLINE void ym2612_mix(YM2612 *F2612, FMSAMPLE *bufL, FMSAMPLE *bufR, int i)
+{
+  FM_OPN *OPN = &F2612->OPN;
+  INT32 *out_fm = F2612->out_fm;
+  int lt, rt;
+
+  lt = ((out_fm[0] >> 0) & OPN->PAN[0]);
+  rt = ((out_fm[0] >> 0) & OPN->PAN[1]);
+  lt += ((out_fm[1] >> 0) & OPN->PAN[2]);
+  rt += ((out_fm[1] >> 0) & OPN->PAN[3]);
+  lt += ((out_fm[2] >> 0) & OPN->PAN[4]);
+  rt += ((out_fm[2] >> 0) & OPN->PAN[5]);
+  lt += ((out_fm[3] >> 0) & OPN->PAN[6]);
+  rt += ((out_fm[3] >> 0) & OPN->PAN[7]);
+  lt += ((out_fm[4] >> 0) & OPN->PAN[8]);
+  rt += ((out_fm[4] >> 0) & OPN->PAN[9]);
+  lt += ((out_fm[5] >> 0) & OPN->PAN[10]);
+  rt += ((out_fm[5] >> 0) & OPN->PAN[11]);
+
+
+  lt >>= FINAL_SH;
+  rt >>= FINAL_SH;
+
+  /* Apply YM2612 DAC ladder effect for authentic sound */
+  lt = ym2612_dac_ladder(lt);
+  rt = ym2612_dac_ladder(rt);
+
+  Limit(lt, MAXOUT, MINOUT);
+  Limit(rt, MAXOUT, MINOUT);
+
+  /* buffering */
+  bufL[i] = lt;
+  bufR[i] = rt;
+}
+
+/* ---------- step the LFO after each sample ---------- */
+INLINE void ym2612_lfo(FM_OPN *OPN)
+{
+  /* LFO update AFTER sample output calculation (Genesis Plus GX accuracy fix)
+   * The LFO AM waveform is inverted: LFO_RATE - wave gives correct direction
+   * This fixes audio bugs in Spider-Man & Venom, California Games, etc. */
+  if (OPN->LFOIncr) {
+    UINT32 wave = OPN_LFO_wave[(OPN->LFOCnt += OPN->LFOIncr) >> LFO_SH];
+    /* Inverted AM waveform for correct direction */
+    OPN->lfo_amd = LFO_RATE - wave;
+    OPN->lfo_pmd = wave - (LFO_RATE / 2); /* PM uses original direction */
+  }
+}
+
+/* ---------- calculate a channel unless it is idle or not heard ---------- */
+INLINE void ym2612_calc_ch(YM2612 *F2612, int c)
+{
+  FM_OPN *OPN = &F2612->OPN;
+  FM_CH *CH = &F2612->CH[c];
+
+  if (CH->idle)
+    return;
+  if (OPN->PAN[c * 2] | OPN->PAN[c * 2 + 1])
+    F2612->out_fm[c] = CH->calc(OPN, CH);
+  else
+    FM_CALC_CH_FB(OPN, CH);
+}
+
+/* ---------- every channel idle and no DAC: silence ---------- */
+/* The timers, busy flag and LFO still run.  Returns the samples done, fewer
+   than length if a CSM key on brings channel 3 back. */
+static int ym2612_silence(YM2612 *F2612, FMSAMPLE *bufL, FMSAMPLE *bufR,
+                          int length)
+{
+  FM_OPN *OPN = &F2612->OPN;
+  FM_ST *ST = &OPN->ST;
+  int i;
+
+  if (length <= 0)
+    return 0;
+  /* what ym2612_mix makes of all zero channel outputs */
+  memset(F2612->out_fm, 0, sizeof(F2612->out_fm));
+  ym2612_mix(F2612, bufL, bufR, 0);
+  for (i = 0; i < length;) {
+    bufL[i] = bufL[0];
+    bufR[i] = bufR[0];
+    ym2612_lfo(OPN);
+
+    /* Update busy flag counter */
+    FM_BUSY_UPDATE(ST);
+
+    /* timer A controll */
+    INTERNAL_TIMER_A(ST, &F2612->CH[2])
+    /* timer B controll */
+    INTERNAL_TIMER_B(ST, 1)
+    i++;
+    if (!F2612->CH[2].idle)
+      break;
+  }
+  return i;
+}
+
+/* ---------- per channel update ----------- */
+static void ym2612_calc(YM2612 *F2612, FMSAMPLE *bufL, FMSAMPLE *bufR,
+                        int length)
+{
+  FM_OPN *OPN = &F2612->OPN;
+  FM_ST *ST = &OPN->ST;
+  INT32 *out_fm = F2612->out_fm;
+  INT32 dacout = F2612->dacout;
+  int dacen = F2612->dacen;
+  int i;
+
+  for (i = 0; i < length; i++) {
+    /* clear outputs */
+    out_fm[0] = 0;
+    out_fm[1] = 0;
+    out_fm[2] = 0;
+    out_fm[3] = 0;
+    out_fm[4] = 0;
+    out_fm[5] = 0;
+
+    /* calculate FM */
+    ym2612_calc_ch(F2612, 0);
+    ym2612_calc_ch(F2612, 1);
+    ym2612_calc_ch(F2612, 2);
+    ym2612_calc_ch(F2612, 3);
+    ym2612_calc_ch(F2612, 4);
+    if (dacen)
+      out_fm[5] += dacout;
+    else
+      ym2612_calc_ch(F2612, 5);
+
+    ym2612_mix(F2612, bufL, bufR, i);
+    ym2612_lfo(OPN);
+
+    /* Update busy flag counter */
+    FM_BUSY_UPDATE(ST);
+
+    /* timer A controll */
+    INTERNAL_TIMER_A(ST, &F2612->CH[2])
+    /* timer B controll, a sample at a time so that it does not depend on
+       how the update is split up */
+    INTERNAL_TIMER_B(ST, 1)
+  }
+}
+
+
+/* ---------- update the chip ----------- */
+void ym2612_update(t_ym2612 *F2612, INT16 **buffer, int length)
+{
+  FM_OPN *OPN = &F2612->OPN;
+  FM_CH *CH = F2612->CH;
+  FMSAMPLE *bufL, *bufR;
+  int done, c;
+
+  /* set bufer */
+  bufL = buffer[0];
+  bufR = buffer[1];
+
+  /* the LFO stops with no modulation */
+  if (!OPN->LFOIncr)
+    OPN->lfo_amd = OPN->lfo_pmd = 0;
+
+  /* update frequency counter */
+  OPN_CALC_FCOUNT(&CH[0]);
+  OPN_CALC_FCOUNT(&CH[1]);
+  if ((OPN->ST.mode & 0xc0)) {
+    /* 3SLOT MODE */
+    if (CH[2].SLOT[SLOT1].Incr == -1) {
+      /* 3 slot mode */
+      CALC_FCSLOT(&CH[2].SLOT[SLOT1], OPN->SL3.fc[1], OPN->SL3.kcode[1]);
+      CALC_FCSLOT(&CH[2].SLOT[SLOT2], OPN->SL3.fc[2], OPN->SL3.kcode[2]);
+      CALC_FCSLOT(&CH[2].SLOT[SLOT3], OPN->SL3.fc[0], OPN->SL3.kcode[0]);
+      CALC_FCSLOT(&CH[2].SLOT[SLOT4], CH[2].fc, CH[2].kcode);
+    }
+  } else
+    OPN_CALC_FCOUNT(&CH[2]);
+  OPN_CALC_FCOUNT(&CH[3]);
+  OPN_CALC_FCOUNT(&CH[4]);
+  OPN_CALC_FCOUNT(&CH[5]);
+
+  /* buffering */
+  if (!F2612->dacen && CH[0].idle && CH[1].idle && CH[2].idle &&
+      CH[3].idle && CH[4].idle && CH[5].idle) {
+    done = ym2612_silence(F2612, bufL, bufR, length);
+    bufL += done;
+    bufR += done;
+    length -= done;
+  }
+  if (length > 0) {
+    ym2612_calc(F2612, bufL, bufR, length);
+    for (c = 0; c < 6; c++)
+      CH[c].idle = FM_CH_IDLE(&CH[c]);
+  }
+}
+
+/* ---------- the status ahead of the chip ----------- */
+/* The status only depends on the timers and the busy flag, so it can be
+   followed past the samples made so far without making any more: a copy
+   of them taken by ym2612_peeksync is given the same writes and run for
+   the same samples as the chip will be, and read by ym2612_peek. */
+void ym2612_peeksync(t_ym2612 *F2612)
+{
+  F2612->peek = F2612->OPN.ST;
+  F2612->peek.IRQ_Handler = nullptr; /* the chip raises its own */
+}
+
+void ym2612_peekwrite(t_ym2612 *F2612, int a, UINT8 v)
+{
+  FM_ST *ST = &F2612->peek;
+
+  if (a == 0)
+    ST->address = v;
+  else if (a == 1)
+    FMWriteTimer(ST, ST->address, v);
+}
+
+void ym2612_peekrun(t_ym2612 *F2612, int length)
+{
+  FM_ST *ST = &F2612->peek;
+  int i;
+
+  /* as ym2612_calc does, leaving out CSM key on */
+  for (i = 0; i < length; i++) {
+    FM_BUSY_UPDATE(ST);
+#if FM_INTERNAL_TIMER
+    if (ST->TAC && (ST->Timer_Handler == 0))
+      if ((ST->TAC -= (int)(ST->freqbase * 4096)) <= 0)
+        TimerAOver(ST);
+#endif
+    INTERNAL_TIMER_B(ST, 1)
+  }
+}
+
+UINT8 ym2612_peek(t_ym2612 *F2612)
+{
+  return FM_STATUS_FLAG(&F2612->peek);
+}
+
+/* ---------- rebuild what the saved registers imply ----------- */
+static void ym2612_postload(YM2612 *F2612)
+{
+  int r;
+
+  /* DAC data & port */
+  /* James Ponder 2001-09-30 level setting of 5 found suitable */
+  F2612->dacout = ((int)F2612->REGS[0x2a] - 0x80) << 5; /* level unknown */
+  /* James Ponder 2001-10-19 fix from 0x2d to 0x2b */
+  F2612->dacen = F2612->REGS[0x2b] & 0x80;
+  /* OPN registers */
+  /* DT / MULTI , TL , KS / AR , AMON / DR , SR , SL / RR , SSG-EG */
+  for (r = 0x30; r < 0x9e; r++)
+    if ((r & 3) != 3) {
+      OPNWriteReg(&F2612->OPN, r, F2612->REGS[r]);
+      OPNWriteReg(&F2612->OPN, r | 0x100, F2612->REGS[r | 0x100]);
+    }
+  /* FB / CONNECT , L / R / AMS / PMS */
+  for (r = 0xb0; r < 0xb6; r++)
+    if ((r & 3) != 3) {
+      OPNWriteReg(&F2612->OPN, r, F2612->REGS[r]);
+      OPNWriteReg(&F2612->OPN, r | 0x100, F2612->REGS[r | 0x100]);
+    }
+  /* channels */
+  for (r = 0; r < 6; r++)
+    F2612->CH[r].idle = 0;
+}
+
+/* James Ponder: removed static */
+void ym2612_savestate(t_ym2612 *F2612)
+{
+  int num = F2612->OPN.ST.index;
+  const char statename[] = "YM2612";
+
+  state_save_register_UINT8(statename, num, "regs", F2612->REGS, 512);
+  FMsave_state_st(statename, num, &F2612->OPN.ST);
+  FMsave_state_channel(statename, num, F2612->CH, 6);
+  /* 3slots */
+  state_save_register_UINT32(statename, num, "slot3fc", F2612->OPN.SL3.fc, 3);
+  state_save_register_UINT8(statename, num, "slot3fh", &F2612->OPN.SL3.fn_h,
+                            1);
+  state_save_register_UINT8(statename, num, "slot3kc", F2612->OPN.SL3.kcode,
+                            3);
+  /* address register1 */
+  state_save_register_int(statename, num, "address1", &F2612->address1);
+  /* registered and transferred in one go, so on to the postload */
+  ym2612_postload(F2612);
+}
+
+/* -------------------------- YM2612 ---------------------------------- */
+t_ym2612 *ym2612_init(int index, int clock, int rate,
+                      FM_TIMERHANDLER TimerHandler, FM_IRQHANDLER IRQHandler)
+{
+  static int shared; /* tables set up */
+  YM2612 *F2612;
+
+  if (!shared) {
+    OPNInitTable();
+    shared = 1;
+  }
+
+  /* allocate extend state space */
+  if ((F2612 = calloc(1, sizeof(YM2612))) == nullptr)
+    return nullptr;
+
+  F2612->OPN.ST.index = index;
+  F2612->OPN.P_CH = F2612->CH;
+  F2612->OPN.ST.clock = clock;
+  F2612->OPN.ST.rate = rate;
+  F2612->OPN.ST.timermodel = FM_TIMER_INTERVAL;
+  /* Extend handler */
+  F2612->OPN.ST.Timer_Handler = TimerHandler;
+  F2612->OPN.ST.IRQ_Handler = IRQHandler;
+  ym2612_reset(F2612);
+  return F2612;
+}
+
+/* ---------- shut down emulator ----------- */
+void ym2612_final(t_ym2612 *F2612)
+{
+  free(F2612);
+}
+
+/* ---------- reset the chip ---------- */
+void ym2612_reset(t_ym2612 *F2612)
+{
+  int i;
+  FM_OPN *OPN = &F2612->OPN;
+
+  OPNSetPres(OPN, 6 * 24, 6 * 24);
+  /* status clear */
+  FM_IRQMASK_SET(&OPN->ST, 0x03);
+  FM_BUSY_CLEAR(&OPN->ST);
+  OPNWriteMode(OPN, 0x27, 0x30); /* mode 0 , timer reset */
+
+  reset_channel(&OPN->ST, &F2612->CH[0], 6);
+  for (i = 0xb6; i >= 0xb4; i--) {
+    OPNWriteReg(OPN, i, 0xc0);
+    OPNWriteReg(OPN, i | 0x100, 0xc0);
+  }
+  for (i = 0xb2; i >= 0x30; i--) {
+    OPNWriteReg(OPN, i, 0);
+    OPNWriteReg(OPN, i | 0x100, 0);
+  }
+  for (i = 0x26; i >= 0x20; i--)
+    OPNWriteReg(OPN, i, 0);
+  /* DAC mode clear */
+  F2612->dacen = 0;
+}
+
+/* YM2612 write */
+/* a = address */
+/* v = value   */
+int ym2612_write(t_ym2612 *F2612, int a, UINT8 v)
+{
+  int addr;
+
+  switch (a & 3) {
+  case 0: /* address port 0 */
+    F2612->OPN.ST.address = v & 0xff;
+    break;
+  case 1: /* data port 0    */
+    addr = F2612->OPN.ST.address;
+    F2612->REGS[addr] = v;
+    switch (addr & 0xf0) {
+    case 0x20: /* 0x20-0x2f Mode */
+      switch (addr) {
+      case 0x2a: /* DAC data (YM2612) */
+        /* James Ponder 2001-09-30 level setting of 5 found suitable */
+        F2612->dacout = ((int)v - 0x80) << 5; /* level unknown */
+        break;
+      case 0x2b: /* DAC Sel  (YM2612) */
+        /* b7 = dac enable */
+        F2612->dacen = v & 0x80;
+        break;
+      default: /* OPN section */
+        /* write register */
+        OPNWriteMode(&(F2612->OPN), addr, v);
+      }
+      break;
+    default: /* 0x30-0xff OPN section */
+      /* write register */
+      OPNWriteReg(&(F2612->OPN), addr, v);
+    }
+    break;
+  case 2: /* address port 1 */
+    F2612->address1 = v & 0xff;
+    break;
+  case 3: /* data port 1    */
+    addr = F2612->address1 | 0x100;
+    F2612->REGS[addr] = v;
+    OPNWriteReg(&(F2612->OPN), addr, v);
+    break;
+  }
+  return F2612->OPN.ST.irq;
+}
+
+/* every address reads the status */
+UINT8 ym2612_read(t_ym2612 *F2612, int a)
+{
+  return FM_STATUS_FLAG(&F2612->OPN.ST);
+}
+
+int ym2612_timerover(t_ym2612 *F2612, int c)
+{
+  if (c) { /* Timer B */
+    TimerBOver(&(F2612->OPN.ST));
+  } else { /* Timer A */
+    /* timer update */
+    TimerAOver(&(F2612->OPN.ST));
+    /* CSM mode key,TL controll */
+    if (F2612->OPN.ST.mode &
+        0x80) { /* CSM mode total level latch and auto key on */
+      CSMKeyControll(&(F2612->CH[2]));
+    }
+  }
+  return F2612->OPN.ST.irq;
+}
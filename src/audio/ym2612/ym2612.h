@@ -0,0 +1,83 @@
+/*
+  File: ym2612.h -- header file for the software YM2612 (OPN2)
+
+*/
+#ifndef YM2612_H
+#define YM2612_H
+
+/* compiler dependence */
+#ifndef OSD_CPU_H
+#define OSD_CPU_H
+/* James Ponder: only define these types if they don't already exist */
+#ifndef UINT8
+typedef unsigned char UINT8; /* unsigned  8bit */
+#endif
+#ifndef UINT16
+typedef unsigned short UINT16; /* unsigned 16bit */
+#endif
+#ifndef UINT32
+typedef unsigned int UINT32; /* unsigned 32bit */
+#endif
+#ifndef INT8
+typedef signed char INT8; /* signed  8bit   */
+#endif
+#ifndef INT16
+typedef signed short INT16; /* signed 16bit   */
+#endif
+#ifndef INT32
+typedef signed int INT32; /* signed 32bit   */
+#endif
+#endif
+
+typedef INT16 FMSAMPLE;
+
+typedef void (*FM_TIMERHANDLER)(int n, int c, int cnt, double stepTime);
+typedef void (*FM_IRQHANDLER)(int n, int irq);
+/* FM_TIMERHANDLER : Stop or Start timer         */
+/* int n          = chip index                   */
+/* int c          = Channel 0=TimerA,1=TimerB    */
+/* int count      = timer count (0=stop)         */
+/* doube stepTime = step time of one count (sec.)*/
+
+/* FM_IRQHHANDLER : IRQ level changing sense     */
+/* int n       = chip index                      */
+/* int irq     = IRQ level 0=OFF,1=ON            */
+
+/* a YM2612, all its state is in here */
+typedef struct ym2612 t_ym2612;
+
+/*
+** Create a YM2612.
+**
+** 'index'         is passed to the handlers and names the saved state
+** 'clock'         is the chip clock
+** 'rate'          is sampling rate
+** 'TimerHandler'  timer callback handler when timer start and clear
+** 'IRQHandler'    IRQ callback handler when changed IRQ level
+** return      the chip, nullptr if out of memory
+*/
+t_ym2612 *ym2612_init(int index, int clock, int rate,
+                      FM_TIMERHANDLER TimerHandler, FM_IRQHANDLER IRQHandler);
+/* free the chip, make sure no sound system stuff is still using it */
+void ym2612_final(t_ym2612 *chip);
+/* reset all chip registers */
+void ym2612_reset(t_ym2612 *chip);
+/* make length samples into buffer[0] (left) and buffer[1] (right) */
+void ym2612_update(t_ym2612 *chip, INT16 **buffer, int length);
+/* write v to port a (0-3), returns the interrupt level */
+int ym2612_write(t_ym2612 *chip, int a, UINT8 v);
+/* read the status */
+UINT8 ym2612_read(t_ym2612 *chip, int a);
+/* the status as it will be after writes and samples not yet made: take the
+   chip as it is, make the same writes and run the same samples as will be
+   given to ym2612_write and ym2612_update, then read the status */
+void ym2612_peeksync(t_ym2612 *chip);
+void ym2612_peekwrite(t_ym2612 *chip, int a, UINT8 v);
+void ym2612_peekrun(t_ym2612 *chip, int length);
+UINT8 ym2612_peek(t_ym2612 *chip);
+/* timer c (0 = A, 1 = B) overflowed, for external timers */
+int ym2612_timerover(t_ym2612 *chip, int c);
+/* James Ponder: bits added for Generator */
+void ym2612_savestate(t_ym2612 *chip);
+
+#endif /* YM2612_H */
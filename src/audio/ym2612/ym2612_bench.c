@@ -0,0 +1,161 @@
+/* YM2612 benchmark - times the update (the genfm kernels) on a made up tune,
+   a scanline's worth of samples per call as the emulator does and a whole
+   field per call.
+   Each is timed at 44.1 kHz and at the chip's own rate, which the sound
+   is made at with sound_native on.
+
+   Usage: ym2612-bench [seconds]  (default 20 seconds of audio) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "bench.h"
+#include "support.h"
+#include "ym2612.h"
+#include "state.h"
+
+#define BENCH_CLOCK 7670453 /* NTSC master clock / 7 */
+#define BENCH_RATE 44100
+#define BENCH_NATIVE ((BENCH_CLOCK + 72) / 144)
+#define BENCH_LINES 262
+
+/* ym2612.c registers its state with these, nothing is saved here */
+void state_transfer8(const char *mod, const char *name, uint8 instance,
+                     uint8 *data, uint32 size)
+{
+}
+void state_transfer16(const char *mod, const char *name, uint8 instance,
+                      uint16 *data, uint32 size)
+{
+}
+void state_transfer32(const char *mod, const char *name, uint8 instance,
+                      uint32 *data, uint32 size)
+{
+}
+
+/*** bench_write - write a register on port 0 (regs < 0x100) or port 1 ***/
+
+static void bench_write(t_ym2612 *chip, unsigned int reg, unsigned int data)
+{
+  ym2612_write(chip, reg < 0x100 ? 0 : 2, reg & 0xff);
+  ym2612_write(chip, reg < 0x100 ? 1 : 3, data);
+}
+
+/*** bench_patch - give channel ch (0-5) a voice using algorithm algo ***/
+
+static void bench_patch(t_ym2612 *chip, unsigned int ch, unsigned int algo)
+{
+  unsigned int base = (ch < 3 ? 0 : 0x100) + ch % 3;
+  unsigned int s;
+
+  for (s = 0; s < 4; s++) {
+    unsigned int op = base + s * 4;
+
+    bench_write(chip, 0x30 + op, (s + ch) % 3 << 4 | (1 + s * 3 + ch) % 16);
+    bench_write(chip, 0x40 + op, s == 3 ? 0x08 : 0x18 + s * 6);
+    bench_write(chip, 0x50 + op, 0x1f - s);
+    bench_write(chip, 0x60 + op, (s & 1 ? 0x80 : 0) | (0x08 + s));
+    bench_write(chip, 0x70 + op, 0x04 + s);
+    bench_write(chip, 0x80 + op, 0x27 + s * 0x10);
+    bench_write(chip, 0x90 + op, ch == 4 && s == 3 ? 0x0a : 0); /* one SSG-EG */
+  }
+  bench_write(chip, 0xb0 + base, (ch * 2 % 8) << 3 | algo);
+  bench_write(chip, 0xb4 + base, 0xc0 | (ch & 3) << 4 | ch % 8);
+}
+
+/*** bench_tune - the writes made at the start of field f ***/
+
+static void bench_tune(t_ym2612 *chip, unsigned int f)
+{
+  static const unsigned int fnum[8] = {644, 682, 723, 766,
+                                       811, 859, 910, 965};
+  unsigned int ch, seq = f / 8;
+
+  if (f == 0) {
+    bench_write(chip, 0x22, 0x0b); /* LFO on */
+    for (ch = 0; ch < 6; ch++)
+      bench_patch(chip, ch, ch);
+  }
+  /* every 8 fields a channel changes voice and the DAC comes and goes */
+  if (f % 8 == 0) {
+    bench_patch(chip, seq % 6, (seq + 6) % 8);
+    bench_write(chip, 0x2b, seq % 4 == 3 ? 0x80 : 0);
+  }
+  /* one or two key events per field, hold notes for a few fields */
+  for (ch = f % 3; ch < 6; ch += 3) {
+    unsigned int key = ch < 3 ? ch : ch + 1;
+    unsigned int base = (ch < 3 ? 0 : 0x100) + ch % 3;
+    unsigned int note = (f * 5 + ch * 3) % 8;
+
+    if ((f / 3 + ch) % 4 == 3) {
+      bench_write(chip, 0x28, key); /* key off */
+      continue;
+    }
+    bench_write(chip, 0xa4 + base, (2 + (f + ch) % 4) << 3 | fnum[note] >> 8);
+    bench_write(chip, 0xa0 + base, fnum[note] & 0xff);
+    bench_write(chip, 0x28, 0xf0 | key);
+  }
+}
+
+/*** bench_render - render the tune, calling the chip lines times a field ***/
+
+static void bench_render(INT16 *left, INT16 *right, unsigned int rate,
+                         unsigned int fields, unsigned int lines)
+{
+  t_ym2612 *chip = ym2612_init(0, BENCH_CLOCK, rate, nullptr, nullptr);
+  unsigned int field = rate / 60;
+  unsigned int f, line;
+
+  if (!chip) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  for (f = 0; f < fields; f++) {
+    INT16 *buf[2] = {left + f * field, right + f * field};
+
+    bench_tune(chip, f);
+    for (line = 0; line < lines; line++) {
+      unsigned int s1 = field * line / lines;
+      unsigned int s2 = field * (line + 1) / lines;
+      INT16 *part[2] = {buf[0] + s1, buf[1] + s1};
+
+      /* DAC samples, a sawtooth, while it is on */
+      bench_write(chip, 0x2a, (f * lines + line) * 7 & 0xff);
+      ym2612_update(chip, part, s2 - s1);
+    }
+  }
+  ym2612_final(chip);
+}
+
+int main(int argc, char *argv[])
+{
+  static const unsigned int calls[2] = {BENCH_LINES, 1};
+  static const unsigned int rates[2] = {BENCH_RATE, BENCH_NATIVE};
+  int seconds = argc > 1 ? atoi(argv[1]) : 20;
+  unsigned int fields = seconds * 60;
+  size_t samples = (size_t)fields * (BENCH_NATIVE / 60);
+  INT16 *out[2];
+  unsigned int c, r;
+
+  out[0] = malloc(samples * sizeof(INT16));
+  out[1] = malloc(samples * sizeof(INT16));
+  if (seconds < 1 || !out[0] || !out[1]) {
+    fprintf(stderr, "Usage: %s [seconds]\n", argv[0]);
+    return 1;
+  }
+  printf("YM2612, %d seconds, ms per second of audio\n", seconds);
+  printf(" rate  calls per field      kernels\n");
+  for (r = 0; r < 2; r++) {
+    for (c = 0; c < 2; c++) {
+      double start = bench_now();
+
+      bench_render(out[0], out[1], rates[r], fields, calls[c]);
+      printf("%5u  %15u  %11.3f\n", rates[r], calls[c],
+             (bench_now() - start) * 1000 / seconds);
+    }
+  }
+  free(out[0]);
+  free(out[1]);
+  return 0;
+}
@@ -9,6 +9,7 @@
 #include "vdp.h"
 #include "cpuz80.h"
 #include "gensound.h"
+#include "soundthread.h"
 #include "ui.h"
 
 #undef DEBUG_VDP
@@ -350,6 +351,7 @@ uint8 mem68k_fetch_sram_byte(uint32 addr)
 #ifdef DEBUG_SRAM
   LOG_VERBOSE(("%08X [SRAM] Fetch byte from %X", regs.pc, addr));
 #endif
+  soundthread_sync();
   addr &= 0x1fff;
   return (*(uint8 *)(cpuz80_ram + addr));
 }
@@ -366,6 +368,7 @@ uint16 mem68k_fetch_sram_word(uint32 addr)
 #ifdef DEBUG_SRAM
   LOG_VERBOSE(("%08X [SRAM] Fetch word from %X", regs.pc, addr));
 #endif
+  soundthread_sync();
   addr &= 0x1fff;
   /* sram word fetches are fetched with duplicated low byte data */
   data = *(uint8 *)(cpuz80_ram + addr);
@@ -383,6 +386,7 @@ uint32 mem68k_fetch_sram_long(uint32 addr)
 #ifdef DEBUG_SRAM
   LOG_VERBOSE(("%08X [SRAM] Fetch long from %X", regs.pc, addr));
 #endif
+  soundthread_sync();
   addr &= 0x1fff;
 #ifdef ALIGNLONGS
   return (LOCENDIAN16(*(uint16 *)(cpuz80_ram + addr)) << 16) |
@@ -398,6 +402,10 @@ void mem68k_store_sram_byte(uint32 addr, uint8 data)
   LOG_VERBOSE(("%08X [SRAM] Store byte to %X", regs.pc, addr));
 #endif
   addr &= 0x1fff;
+  if (soundthread_on) {
+    soundthread_push(st_z80ram, addr, data);
+    return;
+  }
   *(uint8 *)(cpuz80_ram + addr) = data;
   return;
 }
@@ -415,6 +423,10 @@ void mem68k_store_sram_word(uint32 addr, uint16 data)
 #endif
   addr &= 0x1fff;
   /* word writes are stored with low byte cleared */
+  if (soundthread_on) {
+    soundthread_push(st_z80ram, addr, data >> 8);
+    return;
+  }
   *(uint8 *)(cpuz80_ram + addr) = data >> 8;
   return;
 }
@@ -431,6 +443,13 @@ void mem68k_store_sram_long(uint32 addr, uint32 data)
   LOG_VERBOSE(("%08X [SRAM] Store byte to %X", regs.pc, addr));
 #endif
   addr &= 0x1fff;
+  if (soundthread_on) {
+    soundthread_push(st_z80ram, addr, data >> 24);
+    soundthread_push(st_z80ram, (addr + 1) & 0x1fff, data >> 16);
+    soundthread_push(st_z80ram, (addr + 2) & 0x1fff, data >> 8);
+    soundthread_push(st_z80ram, (addr + 3) & 0x1fff, data);
+    return;
+  }
 #ifdef ALIGNLONGS
   *(uint16 *)(cpuz80_ram + addr) = LOCENDIAN16((uint16)(data >> 16));
   *(uint16 *)(cpuz80_ram + addr + 2) = LOCENDIAN16((uint16)(data));
@@ -448,6 +467,7 @@ uint8 mem68k_fetch_yam_byte(uint32 addr)
   addr -= 0xA04000;
   /* LOG_USER(("%08X [YAM] fetch (byte) 0x%X", regs.pc, addr)); */
   if (addr < 4) {
+    soundthread_sync();
     return sound_ym2612fetch(addr);
   } else {
     LOG_CRITICAL(("%08X [YAM] Invalid YAM fetch (byte) 0x%X", regs.pc, addr));
@@ -487,7 +507,9 @@ void mem68k_store_yam_byte(uint32 addr, uint8 data)
   addr -= 0xA04000;
   /* LOG_USER(("%08X [YAM] (68k) store (byte) 0x%X (%d)", regs.pc, addr,
      data)); */
-  if (addr < 4)
+  if (addr < 4 && soundthread_on)
+    soundthread_push(st_ym2612, addr, data);
+  else if (addr < 4)
     sound_ym2612store(addr, data);
   else
     LOG_CRITICAL(("%08X [YAM] Invalid YAM store (byte) 0x%X", regs.pc, addr));
@@ -523,6 +545,16 @@ void mem68k_store_yam_long(uint32 addr, uint32 data)
 
 /*** BANK fetch/store ***/
 
+/*** mem68k_z80bank - 68k write to the z80 bank register ***/
+
+static void mem68k_z80bank(uint8 data)
+{
+  if (soundthread_on)
+    soundthread_push(st_z80bank, 0, data);
+  else
+    cpuz80_bankwrite(data);
+}
+
 uint8 mem68k_fetch_bank_byte(uint32 addr)
 {
   /* write only */
@@ -551,7 +583,7 @@ void mem68k_store_bank_byte(uint32 addr, uint8 data)
 #ifdef DEBUG_SRAM
     LOG_VERBOSE(("%08X [BANK] Store byte to %X", regs.pc, addr));
 #endif
-    cpuz80_bankwrite(data);
+    mem68k_z80bank(data);
   } else {
     LOG_CRITICAL(
         ("%08X [BANK] Invalid memory store (byte) 0x%X", regs.pc, addr));
@@ -565,7 +597,7 @@ void mem68k_store_bank_word(uint32 addr, uint16 data)
 #ifdef DEBUG_SRAM
     LOG_VERBOSE(("%08X [BANK] Store word to %X", regs.pc, addr));
 #endif
-    cpuz80_bankwrite(data >> 8);
+    mem68k_z80bank(data >> 8);
   } else {
     LOG_CRITICAL(
         ("%08X [BANK] Invalid memory store (word) 0x%X", regs.pc, addr));
@@ -780,11 +812,41 @@ void mem68k_store_io_long(uint32 addr, uint32 data)
 
 /*** CTRL fetch/store ***/
 
+/*** mem68k_z80busreq - 68k requests or releases the z80 bus ***/
+
+static void mem68k_z80busreq(int request)
+{
+  if (soundthread_on)
+    soundthread_push(st_z80busreq, 0, request ? 1 : 0);
+  else if (request)
+    cpuz80_stop();
+  else
+    cpuz80_start();
+  LOG_DEBUG1(("%08X Z80 %s", regs.pc, request ? "stopped" : "started"));
+}
+
+/*** mem68k_z80reset - 68k asserts or releases the z80 reset line ***/
+
+static void mem68k_z80reset(int hold)
+{
+  if (soundthread_on) {
+    soundthread_push(st_z80reset, 0, hold ? 1 : 0);
+  } else if (hold) {
+    /* cpuz80_stop(); */
+    cpuz80_resetcpu();
+    sound_genreset();
+  } else {
+    cpuz80_unresetcpu();
+  }
+  LOG_DEBUG1(("%08X Z80 %s", regs.pc, hold ? "reset" : "un-reset"));
+}
+
 uint8 mem68k_fetch_ctrl_byte(uint32 addr)
 {
   addr -= 0xA11000;
   /* 0x000 mode (write only), 0x100 z80 busreq, 0x200 z80 reset (write only) */
   if (addr == 0x100) {
+    soundthread_sync();
     return cpuz80_active ? 1 : 0;
   }
   LOG_CRITICAL(("%08X [CTRL] Invalid memory fetch (byte) 0x%X", regs.pc, addr));
@@ -796,6 +858,7 @@ uint16 mem68k_fetch_ctrl_word(uint32 addr)
   addr -= 0xA11000;
   /* 0x000 mode (write only), 0x100 z80 busreq, 0x200 z80 reset (write only) */
   if (addr == 0x100) {
+    soundthread_sync();
     return cpuz80_active ? 0x100 : 0;
   }
   LOG_CRITICAL(("%08X [CTRL] Invalid memory fetch (word) 0x%X", regs.pc, addr));
@@ -818,26 +881,12 @@ void mem68k_store_ctrl_byte(uint32 addr, uint8 data)
     return;
   } else if (addr == 0x100) {
     /* bus request */
-    if (data & 1) {
-      cpuz80_stop();
-      LOG_DEBUG1(("%08X Z80 stopped", regs.pc));
-    } else {
-      cpuz80_start();
-      LOG_DEBUG1(("%08X Z80 started", regs.pc));
-    }
+    mem68k_z80busreq(data & 1);
   } else if (addr == 0x101) {
     return; /* ignore low byte */
   } else if (addr == 0x200) {
     /* z80 reset request */
-    if (!(data & 1)) {
-      /* cpuz80_stop(); */
-      cpuz80_resetcpu();
-      sound_genreset();
-      LOG_DEBUG1(("%08X Z80 reset", regs.pc));
-    } else {
-      cpuz80_unresetcpu();
-      LOG_DEBUG1(("%08X Z80 un-reset", regs.pc));
-    }
+    mem68k_z80reset(!(data & 1));
   } else if (addr == 0x201) {
     return; /* ignore low byte */
   } else {
@@ -854,24 +903,10 @@ void mem68k_store_ctrl_word(uint32 addr, uint16 data)
     return;
   } else if (addr == 0x100) {
     /* bus request */
-    if (data == 0x100) {
-      cpuz80_stop();
-      LOG_DEBUG1(("%08X Z80 stopped", regs.pc));
-    } else {
-      cpuz80_start();
-      LOG_DEBUG1(("%08X Z80 started", regs.pc));
-    }
+    mem68k_z80busreq(data == 0x100);
   } else if (addr == 0x200) {
     /* z80 reset request */
-    if (!(data & 0x100)) {
-      /* cpuz80_stop(); */
-      cpuz80_resetcpu();
-      sound_genreset();
-      LOG_DEBUG1(("%08X Z80 reset", regs.pc));
-    } else {
-      cpuz80_unresetcpu();
-      LOG_DEBUG1(("%08X Z80 un-reset", regs.pc));
-    }
+    mem68k_z80reset(!(data & 0x100));
   } else {
     LOG_CRITICAL(
         ("%08X [CTRL] Invalid memory store (word) 0x%X", regs.pc, addr));
@@ -1026,7 +1061,10 @@ void mem68k_store_vdp_byte(uint32 addr, uint8 data)
     LOG_CRITICAL(("%08X [VDP] Byte store to hv counter 0x%X", regs.pc, addr));
     return;
   case 17:
-    sound_sn76496store(data);
+    if (soundthread_on)
+      soundthread_push(st_sn76496, 0, data);
+    else
+      sound_sn76496store(data);
     return;
   default:
     LOG_CRITICAL(
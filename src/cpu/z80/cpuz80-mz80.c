@@ -7,10 +7,16 @@
 #include "cpuz80.h"
 #include "cpu68k.h"
 #include "memz80.h"
+#include "mem68k.h"
+#include "soundthread.h"
 #include "ui.h"
 
 UINT8 cpuz80_read_actual(UINT32 addr, struct MemoryReadByte *me);
 void cpuz80_write_actual(UINT32 addr, UINT8 data, struct MemoryWriteByte *me);
+UINT8 cpuz80_read_mirror(UINT32 addr, struct MemoryReadByte *me);
+void cpuz80_write_mirror(UINT32 addr, UINT8 data, struct MemoryWriteByte *me);
+UINT8 cpuz80_read_bank(UINT32 addr, struct MemoryReadByte *me);
+void cpuz80_write_bank(UINT32 addr, UINT8 data, struct MemoryWriteByte *me);
 UINT16 cpuz80_ioread_actual(UINT16 addr, struct z80PortRead *me);
 void cpuz80_iowrite_actual(UINT16 addr, UINT8 data, struct z80PortWrite *me);
 
@@ -27,11 +33,28 @@ CONTEXTMZ80 cpuz80_z80;
 
 static unsigned int cpuz80_lastsync = 0;
 
+/* host pointers for the 32k 68k bank window at 0x8000-0xFFFF, or nullptr
+   when the bank has to go through the 68k memory handlers - the write
+   pointer is only set for RAM banks as ROM writes must be dropped */
+static uint8 *cpuz80_bankread = nullptr;
+static uint8 *cpuz80_bankwrite_mem = nullptr;
+
+/* mz80 walks these lists first and falls back to z80Base for anything not
+   covered, so 0x0000-0x1FFF (sound RAM) never leaves the core - only the
+   mirror, the bank window and the 0x4000-0x7FFF I/O area (YM2612, bank
+   register, PSG and unmapped) have entries */
+
 static struct MemoryReadByte cpuz80_read[] = {
-    {0x0000, 0xFFFF, cpuz80_read_actual, nullptr}, {-1, -1, nullptr, nullptr}};
+    {0x2000, 0x3FFF, cpuz80_read_mirror, nullptr},
+    {0x4000, 0x7FFF, cpuz80_read_actual, nullptr},
+    {0x8000, 0xFFFF, cpuz80_read_bank, nullptr},
+    {-1, -1, nullptr, nullptr}};
 
 static struct MemoryWriteByte cpuz80_write[] = {
-    {0x0000, 0xFFFF, cpuz80_write_actual, nullptr}, {-1, -1, nullptr, nullptr}};
+    {0x2000, 0x3FFF, cpuz80_write_mirror, nullptr},
+    {0x4000, 0x7FFF, cpuz80_write_actual, nullptr},
+    {0x8000, 0xFFFF, cpuz80_write_bank, nullptr},
+    {-1, -1, nullptr, nullptr}};
 
 static struct z80PortRead cpuz80_ioread[] = {
     {0x0000, 0x00FF, cpuz80_ioread_actual, nullptr},
@@ -53,6 +76,62 @@ void cpuz80_write_actual(UINT32 addr, UINT8 data, struct MemoryWriteByte *me)
   memz80_storebyte((uint16)addr, (uint8)data);
 }
 
+UINT8 cpuz80_read_mirror(UINT32 addr, struct MemoryReadByte *me)
+{
+  (void)me;
+  return cpuz80_ram[addr & 0x1fff];
+}
+
+void cpuz80_write_mirror(UINT32 addr, UINT8 data, struct MemoryWriteByte *me)
+{
+  (void)me;
+  cpuz80_ram[addr & 0x1fff] = data;
+}
+
+UINT8 cpuz80_read_bank(UINT32 addr, struct MemoryReadByte *me)
+{
+  (void)me;
+  if (cpuz80_bankread)
+    return cpuz80_bankread[addr & 0x7fff];
+  return fetchbyte(cpuz80_bank | (addr & 0x7fff));
+}
+
+void cpuz80_write_bank(UINT32 addr, UINT8 data, struct MemoryWriteByte *me)
+{
+  (void)me;
+  if (cpuz80_bankwrite_mem) {
+    cpuz80_bankwrite_mem[addr & 0x7fff] = data;
+  } else {
+    /* a store to ROM can reach a mapper or SRAM, not safe from the sound
+       thread until the 68k side has stopped */
+    if (soundthread_on)
+      soundthread_fallback();
+    storebyte(cpuz80_bank | (addr & 0x7fff), data);
+  }
+}
+
+/*** cpuz80_bankmap - recalculate the host pointers for the bank window ***/
+
+static void cpuz80_bankmap(void)
+{
+  cpuz80_bankread = nullptr;
+  cpuz80_bankwrite_mem = nullptr;
+  if ((cpuz80_bank & 0xE00000) == 0xE00000) {
+    /* 68k RAM, mirrored every 64k */
+    cpuz80_bankread = cpu68k_ram + (cpuz80_bank & 0xffff);
+    cpuz80_bankwrite_mem = cpuz80_bankread;
+  } else if (cpuz80_bank < 0x400000 && cpu68k_rom &&
+             cpuz80_bank + 0x8000 <= cpu68k_romlen) {
+    /* cartridge ROM, only if the whole window is backed by the image */
+    cpuz80_bankread = cpu68k_rom + cpuz80_bank;
+  }
+  /* only ROM can be shared with the sound thread - 68k RAM changes under
+     it and the handlers have side effects, so go back to running inline,
+     holding the z80 until the 68k side has stopped to let it */
+  if (soundthread_on && (cpuz80_bankwrite_mem || !cpuz80_bankread))
+    soundthread_fallback();
+}
+
 UINT16 cpuz80_ioread_actual(UINT16 addr, struct z80PortRead *me)
 {
   (void)me;
@@ -86,6 +165,7 @@ void cpuz80_reset(void)
   }
   memset(cpuz80_ram, 0, LEN_SRAM);
   cpuz80_bank = 0;
+  cpuz80_bankmap();
   cpuz80_active = 0;
   cpuz80_lastsync = 0;
   cpuz80_resetting = 1;
@@ -103,6 +183,7 @@ void cpuz80_reset(void)
 
 void cpuz80_updatecontext(void)
 {
+  cpuz80_bankmap(); /* cpuz80_bank may have been loaded from a state file */
   mz80SetContext(&cpuz80_z80);
 }
 
@@ -126,6 +207,7 @@ void cpuz80_unresetcpu(void)
 void cpuz80_bankwrite(uint8 data)
 {
   cpuz80_bank = (((cpuz80_bank >> 1) | ((data & 1) << 23)) & 0xff8000);
+  cpuz80_bankmap();
 }
 
 /*** cpuz80_stop - stop the processor ***/
@@ -155,7 +237,14 @@ void cpuz80_endfield(void)
 
 void cpuz80_sync(void)
 {
-  int cpu68k_wanted = cpu68k_clocks - cpuz80_lastsync;
+  cpuz80_syncto(cpu68k_clocks);
+}
+
+/*** cpuz80_syncto - synchronise to a given 68k clock count ***/
+
+void cpuz80_syncto(unsigned int clocks)
+{
+  int cpu68k_wanted = clocks - cpuz80_lastsync;
   int wanted = (cpu68k_wanted < 0 ? 0 : cpu68k_wanted) * 7 / 15;
   int achieved;
 
@@ -166,7 +255,7 @@ void cpuz80_sync(void)
     achieved = mz80GetElapsedTicks(1);
     cpuz80_lastsync = cpuz80_lastsync + achieved * 15 / 7;
   } else {
-    cpuz80_lastsync = cpu68k_clocks;
+    cpuz80_lastsync = clocks;
   }
 }
 
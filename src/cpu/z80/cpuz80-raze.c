@@ -125,7 +125,14 @@ void cpuz80_endfield(void)
 
 void cpuz80_sync(void)
 {
-  int cpu68k_wanted = cpu68k_clocks - cpuz80_lastsync;
+  cpuz80_syncto(cpu68k_clocks);
+}
+
+/*** cpuz80_syncto - synchronise to a given 68k clock count ***/
+
+void cpuz80_syncto(unsigned int clocks)
+{
+  int cpu68k_wanted = clocks - cpuz80_lastsync;
   int wanted = (cpu68k_wanted < 0 ? 0 : cpu68k_wanted) * 7 / 15;
   int achieved;
 
@@ -140,7 +147,7 @@ void cpuz80_sync(void)
     achieved = z80_emulate(wanted);
     cpuz80_lastsync = cpuz80_lastsync + achieved * 15 / 7;
   } else {
-    cpuz80_lastsync = cpu68k_clocks;
+    cpuz80_lastsync = clocks;
   }
 }
 
@@ -0,0 +1,13 @@
+/* bench - shared by the benchmark programs */
+
+#include <time.h>
+
+/*** bench_now - monotonic time in seconds ***/
+
+static inline double bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
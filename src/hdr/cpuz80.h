@@ -21,6 +21,7 @@ void cpuz80_stop(void);
 void cpuz80_start(void);
 void cpuz80_endfield(void);
 void cpuz80_sync(void);
+void cpuz80_syncto(unsigned int clocks);
 void cpuz80_interrupt(void);
 void cpuz80_uninterrupt(void); /* debug */
 uint8 cpuz80_portread(uint8 port);
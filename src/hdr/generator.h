@@ -329,7 +329,7 @@ typedef struct {
 #endif
 
 typedef struct {
-  uint8 *sprite;       /* pointer to sprite data or NULL for end of list */
+  const uint8 *sprite; /* pointer to sprite data or NULL for end of list */
   uint8 hplot;         /* number of cells to plot */
   sint16 hpos, vpos;   /* -128 upwards, top left position */
   uint16 hsize, vsize; /* 1 to 4 for 8 to 32 pixels */
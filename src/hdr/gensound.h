@@ -1,8 +1,3 @@
-#ifndef JFM
-#include "support.h"
-#include "fm.h"
-#endif
-
 #define SOUND_MAXRATE 44100
 #define SOUND_SAMPLERATE \
   44100 /* Increased from 22050 Hz for better audio quality */
@@ -13,6 +8,8 @@ static_assert(SOUND_SAMPLERATE <= SOUND_MAXRATE,
 static_assert(SOUND_SAMPLERATE == 44100,
               "SOUND_SAMPLERATE must be 44100 Hz for CD-quality audio");
 
+#define SOUND_DRCMAX 0.005 /* most sound_drcratio moves from 1, 0.5% */
+
 extern int sound_debug;
 extern int sound_feedback;
 extern unsigned int sound_minfields;
@@ -30,6 +27,10 @@ extern unsigned int sound_psg;
 extern unsigned int sound_fm;
 extern uint16 sound_soundbuf[2][SOUND_MAXRATE / 50];
 extern unsigned int sound_filter;
+extern unsigned int sound_threaded;
+extern unsigned int sound_drc;
+extern double sound_drcratio;
+extern unsigned int sound_native;
 
 int sound_start(void);
 void sound_stop(void);
@@ -38,9 +39,12 @@ void sound_final(void);
 int sound_reset(void);
 void sound_startfield(void);
 void sound_endfield(void);
+void sound_output(void);
 void sound_genreset(void);
+void sound_savestate(void);
 uint8 sound_ym2612fetch(uint8 addr);
 void sound_ym2612store(uint8 addr, uint8 data);
 void sound_sn76496store(uint8 data);
 void sound_genreset(void);
-void sound_line(void);
+void sound_line(unsigned int line);
+void sound_flush(void);
@@ -0,0 +1,55 @@
+/* simd - portable vector types and runtime instruction set dispatch
+
+   Kernels are written once against the compiler's generic vector types
+   (GCC/Clang vector_size), which lower to SSE2 on x86-64 and NEON on
+   AArch64 - both part of the baseline ABI.  The same kernel body can be
+   instantiated a second time at 32 bytes inside an SIMD_AVX2 function and
+   chosen at runtime with simd_avx2(); such functions may also use the
+   immintrin.h intrinsics for what the generic types can't express, such
+   as gathers.  Elsewhere SIMD_VECTORS is 0 and callers keep to their
+   scalar code. */
+
+#if (defined(__GNUC__) || defined(__clang__)) &&                               \
+    (defined(__x86_64__) || defined(__aarch64__))
+#define SIMD_VECTORS 1
+#else
+#define SIMD_VECTORS 0
+#endif
+
+#if SIMD_VECTORS && defined(__x86_64__)
+#define SIMD_HAVE_AVX2 1
+#define SIMD_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#else
+#define SIMD_HAVE_AVX2 0
+#define SIMD_AVX2
+#endif
+
+#if SIMD_VECTORS
+
+typedef uint8 t_simd_u8x16 __attribute__((vector_size(16)));
+typedef uint8 t_simd_u8x32 __attribute__((vector_size(32)));
+typedef sint16 t_simd_s16x8 __attribute__((vector_size(16)));
+typedef uint16 t_simd_u16x8 __attribute__((vector_size(16)));
+typedef uint32 t_simd_u32x4 __attribute__((vector_size(16)));
+typedef uint32 t_simd_u32x8 __attribute__((vector_size(32)));
+typedef sint32 t_simd_s32x4 __attribute__((vector_size(16)));
+typedef sint32 t_simd_s32x8 __attribute__((vector_size(32)));
+typedef float t_simd_f32x4 __attribute__((vector_size(16)));
+
+/*** simd_select - per-lane mask ? a : b, mask lanes all-ones or zero ***/
+
+#define simd_select(mask, a, b) (((mask) & (a)) | (~(mask) & (b)))
+
+#endif
+
+/*** simd_avx2 - whether the cpu we are running on has AVX2 ***/
+
+static inline int simd_avx2(void)
+{
+#if SIMD_HAVE_AVX2
+  return __builtin_cpu_supports("avx2");
+#else
+  return 0;
+#endif
+}
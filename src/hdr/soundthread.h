@@ -0,0 +1,30 @@
+/* sound thread - z80, YM2612 and SN76496 replayed on a second core */
+
+typedef enum {
+  st_line,        /* end of line: sync z80 to clocks, generate samples */
+  st_z80int,      /* vertical interrupt to the z80 */
+  st_z80endfield, /* end of field z80 counter reset */
+  st_output,      /* end of field: hand the field's samples to soundp */
+  st_z80ram,      /* 68k store to z80 RAM */
+  st_z80bank,     /* 68k store to the z80 bank register */
+  st_z80busreq,   /* 68k bus request (data 1) or release (data 0) */
+  st_z80reset,    /* 68k z80 reset assert (data 1) or release (data 0) */
+  st_ym2612,      /* 68k store to the YM2612 */
+  st_sn76496      /* 68k store to the SN76496 */
+} t_soundthread_type;
+
+typedef struct {
+  uint32 clocks; /* cpu68k_clocks when the event was queued */
+  uint16 addr;
+  uint8 data;
+  uint8 type; /* t_soundthread_type */
+} t_soundthread_event;
+
+extern unsigned int soundthread_on;
+
+void soundthread_push(t_soundthread_type type, uint16 addr, uint8 data);
+void soundthread_sync(void);
+void soundthread_startfield(void);
+void soundthread_stop(void);
+void soundthread_reset(void);
+void soundthread_fallback(void);
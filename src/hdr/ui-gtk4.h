@@ -91,22 +91,14 @@ typedef struct {
   guint32 *upscale_src_buffer; /* Pre-allocated source buffer for upscaling */
   guint32
       *upscale_dst_buffer; /* Pre-allocated destination buffer for upscaling */
-  guint32 *scale4x_temp_buffer; /* Pre-allocated intermediate buffer for Scale4x */
   unsigned int upscale_buffer_size; /* Current allocated buffer size */
 
   /* Debug */
   gboolean debug_telemetry; /* Enable debug output (set via GENERATOR_DEBUG env) */
 
   /* Dynamic Rate Control */
-  gboolean dynamic_rate_control; /* Enable/disable dynamic rate control */
-  double rate_adjust;     /* Current rate adjustment factor (1.0 = normal) */
-  double rate_delta;      /* Maximum adjustment delta (default 0.005 = 0.5%) */
-  gint64 fps_times[60];   /* Last 60 frame timestamps for FPS calculation */
-  int fps_index;          /* Current index in fps_times array */
-  double measured_fps;    /* Measured FPS (rolling average) */
-  int frames_recorded;    /* Number of frames recorded so far (max 60) */
-  int debug_counter;      /* Counter for debug output */
-  gint64 last_frame_time; /* Last frame time for timing */
+  gboolean dynamic_rate_control; /* Resample sound, don't skip frames */
+  gint64 last_frame_time; /* Last field due, see ui_tick_callback */
 
   /* SDL and rendering */
   void *screen; /* SDL_Surface pointer */
@@ -116,6 +108,10 @@ typedef struct {
   guint8 *newscreen;
   _Atomic int whichbank; /* Atomic for thread-safe access between render
                             and draw threads */
+  GdkTexture *texture;   /* Last texture handed to the picture */
+  int texture_bank;      /* ... and the screen buffer it shows */
+  GMutex texture_mutex;  /* Protects texture_dirty and bank swaps */
+  cairo_rectangle_int_t texture_dirty; /* Changed since texture, if width */
   gboolean locksurface;
   gboolean plotfield;
   gboolean vdpsimple;
@@ -137,11 +133,12 @@ typedef struct {
 
   /* Emulation Thread */
   GThread *emu_thread;       /* Dedicated emulation thread */
-  GMutex emu_mutex;          /* Protects frame_requested and thread state */
+  GMutex emu_mutex;          /* Protects frames_requested and thread state */
   GCond emu_cond;            /* Signal to run frames */
   gboolean emu_thread_running; /* Thread alive flag */
-  gboolean frame_requested;  /* Main thread requested a frame */
+  guint frames_requested;    /* Frames the main thread requested, not run */
   _Atomic int render_complete; /* Emu thread completed a frame */
+  _Atomic int fps;           /* For the status bar, -1 once shown */
 
   /* Recording */
   int musicfile_fd;
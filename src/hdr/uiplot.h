@@ -3,8 +3,15 @@ extern uint32 uiplot_palcache[192];
 void uiplot_setshifts(int redshift, int greenshift, int blueshift);
 void uiplot_setmasks(uint32 redmask, uint32 greenmask, uint32 bluemask);
 void uiplot_checkpalcache(int flag);
+void uiplot_loadpalcache(const uint8 *cram);
 void uiplot_convertdata16(uint8 *indata, uint16 *outdata, unsigned int pixels);
 void uiplot_convertdata32(uint8 *indata, uint32 *outdata, unsigned int pixels);
+void uiplot_convertframe16(uint8 *indata, unsigned int inpitch,
+                           uint16 *outdata, unsigned int outpitch,
+                           unsigned int pixels, unsigned int lines);
+void uiplot_convertframe32(uint8 *indata, unsigned int inpitch,
+                           uint32 *outdata, unsigned int outpitch,
+                           unsigned int pixels, unsigned int lines);
 void uiplot_render16_x1(uint16 *linedata, uint16 *olddata, uint8 *screen,
                         unsigned int pixels);
 void uiplot_render32_x1(uint32 *linedata, uint32 *olddata, uint8 *screen,
@@ -23,17 +30,41 @@ void uiplot_irender32_weavefilter(uint32 *evendata, uint32 *odddata,
                                   uint8 *screen, unsigned int pixels);
 
 /* Scale2x/EPX upscaling algorithms
-   src_pitch and dst_pitch are in bytes (stride of source/dest buffers) */
+   src_pitch and dst_pitch are in bytes (stride of source/dest buffers),
+   Scale4x takes frames up to UIPLOT_SCALE4X_MAXWIDTH wide */
+#define UIPLOT_SCALE4X_MAXWIDTH 320
 void uiplot_scale2x_frame32(uint32 *srcdata, uint32 *dstdata,
                             unsigned int src_width, unsigned int src_height,
                             unsigned int src_pitch, unsigned int dst_pitch);
 void uiplot_scale3x_frame32(uint32 *srcdata, uint32 *dstdata,
                             unsigned int src_width, unsigned int src_height,
                             unsigned int src_pitch, unsigned int dst_pitch);
-void uiplot_scale4x_frame32(uint32 *srcdata, uint32 *dstdata, uint32 *temp,
+void uiplot_scale4x_frame32(uint32 *srcdata, uint32 *dstdata,
                             unsigned int src_width, unsigned int src_height,
                             unsigned int src_pitch, unsigned int dst_pitch);
 
+/* The same for source rows first to last - 1 only, for redrawing the part
+   of a frame that has changed.  Each output row also depends on the
+   source rows up to UIPLOT_SCALE_REACH (UIPLOT_XBRZ_REACH) either side */
+#define UIPLOT_SCALE_REACH 2
+#define UIPLOT_XBRZ_REACH 2
+void uiplot_scale2x_rows32(uint32 *srcdata, uint32 *dstdata,
+                           unsigned int src_width, unsigned int src_height,
+                           unsigned int first, unsigned int last,
+                           unsigned int src_pitch, unsigned int dst_pitch);
+void uiplot_scale3x_rows32(uint32 *srcdata, uint32 *dstdata,
+                           unsigned int src_width, unsigned int src_height,
+                           unsigned int first, unsigned int last,
+                           unsigned int src_pitch, unsigned int dst_pitch);
+void uiplot_scale4x_rows32(uint32 *srcdata, uint32 *dstdata,
+                           unsigned int src_width, unsigned int src_height,
+                           unsigned int first, unsigned int last,
+                           unsigned int src_pitch, unsigned int dst_pitch);
+
 /* xBRZ high-quality upscaling algorithms */
 void uiplot_xbrz_frame32(int factor, uint32 *srcdata, uint32 *dstdata,
                          unsigned int src_width, unsigned int src_height);
+void uiplot_xbrz_rows32(int factor, uint32 *srcdata, uint32 *dstdata,
+                        unsigned int src_width, unsigned int src_height,
+                        unsigned int first, unsigned int last);
+void uiplot_xbrz_threads(int threads);
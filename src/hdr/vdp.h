@@ -41,6 +41,8 @@ extern uint8 vdp_vsram[];
 extern uint8 vdp_vram[];
 extern unsigned int vdp_cramchange;
 extern uint8 vdp_cramf[];
+extern uint8 vdp_cramchanged[];
+extern unsigned int vdp_cramchanges;
 extern unsigned int vdp_event_start;
 extern unsigned int vdp_event_vint;
 extern unsigned int vdp_event_hint;
@@ -54,6 +56,11 @@ extern t_code vdp_code;
 extern uint8 vdp_ctrlflag;
 extern uint16 vdp_first;
 extern uint16 vdp_second;
+extern unsigned int vdp_tiles_dirtied;
+extern unsigned int vdp_tiles_decoded;
+extern unsigned int vdp_renderthreads;
+extern unsigned int vdp_planecache;
+extern unsigned int vdp_spritesdone;
 
 void vdp_reset(void);
 int vdp_init(void);
@@ -62,6 +69,10 @@ void vdp_storectrl(uint16 data);
 void vdp_storedata(uint16 data);
 uint16 vdp_fetchdata(void);
 void vdp_renderline(unsigned int line, uint8 *linedata, unsigned int odd);
+void vdp_spritestatus(int line, unsigned int odd);
+void vdp_renderline_rgb32(unsigned int line, uint32 *outdata,
+                          const uint32 *palette, unsigned int pixels,
+                          unsigned int odd);
 void vdp_renderline_interlace2(unsigned int line, uint8 *linedata);
 void vdp_showregs(void);
 void vdp_describe(void);
@@ -70,7 +81,36 @@ void vdp_endfield(void);
 void vdp_renderframe(uint8 *framedata, unsigned int lineoffset);
 void vdp_setupvideo(void);
 uint8 vdp_gethpos(void);
+unsigned int vdp_dmarate(void);
 void vdp_fifo_drain(int count);
+void vdp_tilecache_invalidate(void);
+void vdp_logline(unsigned int line, unsigned int odd);
+void vdp_logfield(void);
+void vdp_logfree(void);
+const uint8 *vdp_loggedline(unsigned int line, const uint8 **cram,
+                            unsigned int *width);
+void vdp_renderband(unsigned int band);
+
+#define VDP_MAXLINES 240
+
+/* what changed in a line since the last time it was rendered, as a span of
+   whole 8 pixel cells from left to right - 1; nothing if right is 0.
+   Filled in as each line is rendered, so only good for the lines that
+   have been rendered this field */
+typedef struct {
+  uint16 left;
+  uint16 right;
+} t_vdp_dirty;
+
+typedef struct {
+  unsigned int top, bottom; /* lines top to bottom - 1 */
+  unsigned int left, right; /* pixels left to right - 1 */
+} t_vdp_rect;
+
+extern t_vdp_dirty vdp_dirty[VDP_MAXLINES];
+
+int vdp_dirtyrect(unsigned int lines, t_vdp_rect *rect);
+void vdp_dirtyall(void);
 
 #define LEN_CRAM 128
 #define LEN_VSRAM 80
@@ -0,0 +1,11 @@
+/* render threads - logged field lines rendered on other cores */
+
+#define VDPTHREAD_MAX 8    /* threads */
+#define VDPTHREAD_BANDS 16 /* band slots per field in vdp.c */
+
+extern unsigned int vdpthread_on;
+
+void vdpthread_queue(unsigned int band);
+void vdpthread_wait(void);
+void vdpthread_endfield(void);
+void vdpthread_stop(void);
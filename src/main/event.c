@@ -7,6 +7,7 @@
 #include "reg68k.h"
 #include "ui.h"
 #include "gensound.h"
+#include "soundthread.h"
 #include "gen_context.h"
 #include "gen_ui_callbacks.h"
 #include "mem68k.h"
@@ -136,9 +137,9 @@ void event_nextevent(void)
       LOG_DEBUG1(("post = %d", vdp_hskip_countdown));
     }
 
-    /* DMA (Direct Memory Access) processing: Transfer bytes from 68k RAM/ROM to
-     * VRAM The 68k is frozen during DMA (see event_freeze). DMA transfer rate
-     * depends on:
+    /* DMA (Direct Memory Access) processing: VRAM fill and copy run
+     * alongside the 68k, 68k to VDP transfers freeze it (see event_freeze).
+     * Both use the same per-line rate (vdp_dmarate), which depends on:
      * - Display mode: Active display (slower) vs blank period (faster)
      * - Screen width: 320px (H40 mode) vs 256px (H32 mode)
      *
@@ -146,13 +147,7 @@ void event_nextevent(void)
      * - H40 mode (320px): 18 bytes during active, 205 bytes during blank
      * - H32 mode (256px): 16 bytes during active, 167 bytes during blank */
     if (vdp_dmabytes) {
-      /* Calculate DMA bytes transferred this scanline based on display state */
-      vdp_dmabytes -=
-          (vdp_vblank || !(vdp_reg[1] & 1 << 6)) /* Blank or display off? */
-              ? ((vdp_reg[12] & 1) ? 205
-                                   : 167) /* Fast transfer (blank period) */
-              : ((vdp_reg[12] & 1) ? 18
-                                   : 16); /* Slow transfer (active display) */
+      vdp_dmabytes -= vdp_dmarate();
 
       /* DMA complete when counter reaches 0 */
       if (vdp_dmabytes <= 0) {
@@ -174,8 +169,14 @@ void event_nextevent(void)
 
     /* Notify UI that this scanline is ready to be rendered to the screen.
      * The UI will read vdp_regs[] and vdp_vram[] to render graphics/sprites */
+    vdp_spritesdone = 0;
     GEN_UI_CALL(g_ctx, line, vdp_line - vdp_visstartline + 1);
 
+    /* If the UI skipped the line (frame skip, headless) still work out the
+     * sprite collision and overflow status the 68k can read */
+    if (!vdp_spritesdone)
+      vdp_spritestatus(vdp_line - vdp_visstartline + 1, vdp_oddframe);
+
     /* Calculate cycles until next event (LINE_END). If not enough time, break
      */
     if ((vdp_nextevent = vdp_event_end - cpu68k_clocks) > 0)
@@ -205,9 +206,14 @@ void event_nextevent(void)
 
     /* Synchronize Z80 CPU and generate sound samples for this scanline.
      * The Genesis has a separate Z80 CPU for sound processing that runs
-     * concurrently with the 68k. We sync it here to keep audio in lockstep. */
-    cpuz80_sync();
-    sound_line();
+     * concurrently with the 68k. We sync it here to keep audio in lockstep.
+     * With the sound thread running the same work is queued instead. */
+    if (soundthread_on) {
+      soundthread_push(st_line, vdp_line, 0);
+    } else {
+      cpuz80_sync();
+      sound_line(vdp_line);
+    }
 
     /* Update 6-button controller timeout (resets counter if no TH activity) */
     mem68k_controller_refresh();
@@ -216,8 +222,12 @@ void event_nextevent(void)
     vdp_line++;
 
     /* At end of visible display, trigger Z80 interrupt (used by some games) */
-    if (vdp_line == vdp_visendline)
-      cpuz80_interrupt();
+    if (vdp_line == vdp_visendline) {
+      if (soundthread_on)
+        soundthread_push(st_z80int, 0, 0);
+      else
+        cpuz80_interrupt();
+    }
 
     /* End of frame reached (vdp_totlines = 262 for NTSC, 313 for PAL) */
     if (vdp_line == vdp_totlines) {
@@ -227,7 +237,10 @@ void event_nextevent(void)
       GEN_UI_CALL(g_ctx, end_field); /* Notify UI that frame is complete */
       vdp_endfield(); /* Must be after ui_endfield: Resets VDP state for next
                          frame */
-      cpuz80_endfield(); /* Reset Z80 state */
+      if (soundthread_on) /* Reset Z80 state */
+        soundthread_push(st_z80endfield, 0, 0);
+      else
+        cpuz80_endfield();
       cpu68k_endfield(); /* Reset 68k state */
       cpu68k_frames++;   /* Increment frame counter */
     }
@@ -338,32 +351,29 @@ void event_freeze_clocks(unsigned int clocks)
 
 void event_freeze(unsigned int bytes)
 {
-  int wide = vdp_reg[12] & 1;
-  int clocks, possible;
-  double percent_possible;
+  int clksperline = (int)vdp_clksperline_68k;
+  int clocks, possible, rate;
   int togo = (int)bytes;
 
   cpu68k_frozen = 1; /* prohibit interrupts since PC is not known in the
                         middle of a 68k block due to register mappings */
 
+  /* a line moves vdp_dmarate() bytes in vdp_clksperline_68k clocks, so the
+     rest of this line moves clocks * rate / clksperline of them - the rate
+     is looked up again each time round as a line end may enter or leave
+     vertical blank */
   while (togo > 0) {
     /* clocks will be negative if we're in the middle of a cpu block */
     clocks = vdp_event_end - cpu68k_clocks;
     if (clocks < 0)
       clocks = 0;
-    percent_possible = clocks / vdp_clksperline_68k;
-    if (vdp_reg[1] & 1 << 6 && !vdp_vblank) {
-      /* vdp active */
-      possible = (unsigned int)(percent_possible * (wide ? 18 : 16));
-    } else {
-      /* vdp inactive */
-      possible = (unsigned int)(percent_possible * (wide ? 205 : 167));
-    }
+    rate = (int)vdp_dmarate();
+    possible = clocks * rate / clksperline;
     if (togo >= possible) {
       event_freeze_clocks(clocks);
       togo -= possible;
     } else {
-      event_freeze_clocks(((double)togo / possible) * clocks);
+      event_freeze_clocks(togo * clksperline / rate);
       togo = 0;
     }
   }
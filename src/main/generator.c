@@ -28,6 +28,7 @@
 #include "cpuz80.h"
 #include "vdp.h"
 #include "gensound.h"
+#include "soundthread.h"
 
 #ifdef ALLEGRO
 #include "allegro.h"
@@ -142,6 +143,7 @@ END_OF_MAIN();
 
 void gen_reset(void)
 {
+  soundthread_reset();
   vdp_reset();
   cpu68k_reset();
   cpuz80_reset();
@@ -169,7 +171,8 @@ char *gen_loadimage(const char *filename)
   uint8 *new;
   char *p;
 
-  /* Remove current file */
+  /* Remove current file - the sound thread may be reading the old one */
+  soundthread_stop();
   if (cpu68k_rom) {
     if (gen_freerom)
       free(cpu68k_rom);
@@ -381,6 +384,7 @@ char *gen_loadimage(const char *filename)
 
 void gen_loadmemrom(const char *rom, int romlen)
 {
+  soundthread_stop();
   cpu68k_rom = (char *)rom; /* I won't alter it, promise */
   cpu68k_romlen = romlen;
   gen_freerom = 0;
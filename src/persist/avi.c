@@ -9,6 +9,7 @@
 
 #include "generator.h"
 
+#include "simd.h"
 #include "vdp.h"
 #include "ui.h"
 #include "dib.h"
@@ -354,6 +355,31 @@ int avi_video_jpeg(t_avi *avi, uint8 *video)
 
 #endif
 
+/*** avi_swaprgb - RGB pixels into the BGR order DIBs are stored in ***/
+
+static void avi_swaprgb(uint8 *dst, const uint8 *src, unsigned int pixels)
+{
+  unsigned int x = 0;
+#if SIMD_VECTORS
+  t_simd_u8x16 v;
+
+  /* four pixels a register - 16 bytes are read and written but only 12
+     are whole pixels, the last four are written again by the next round
+     or the loop below, and x + 6 keeps all 16 inside the line */
+  for (; x + 6 <= pixels; x += 4) {
+    memcpy(&v, src + x * 3, sizeof(v));
+    v = __builtin_shufflevector(v, v, 2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 12,
+                                13, 14, 15);
+    memcpy(dst + x * 3, &v, sizeof(v));
+  }
+#endif
+  for (; x < pixels; x++) {
+    dst[x * 3] = src[x * 3 + 2];
+    dst[x * 3 + 1] = src[x * 3 + 1];
+    dst[x * 3 + 2] = src[x * 3];
+  }
+}
+
 int avi_video_raw(t_avi *avi, uint8 *video)
 {
   uint32 size;
@@ -374,13 +400,8 @@ int avi_video_raw(t_avi *avi, uint8 *video)
   /* convert from RGB to BGR */
   for (line = 0; line < avi->info.height; line++) {
     v = video + (avi->info.height - line - 1) * (avi->info.width * 3);
-    p = buf;
-    for (x = 0; x < avi->info.width; x++) {
-      *p++ = v[2];
-      *p++ = v[1];
-      *p++ = v[0];
-      v += 3;
-    }
+    avi_swaprgb(buf, v, avi->info.width);
+    p = buf + avi->info.width * 3;
     /* we should have avi->linebytes of data - pad with zeros */
     for (x = 0; x < (avi->linebytes - (avi->info.width * 3)); x++)
       *p++ = '\0'; /* pad */
@@ -18,7 +18,7 @@
 #include "cpuz80.h"
 #include "vdp.h"
 #include "gensound.h"
-#include "fm.h"
+#include "soundthread.h"
 
 typedef struct _t_statelist {
   struct _t_statelist *next;
@@ -211,6 +211,8 @@ static void state_dotransfer(unsigned int mode)
   uint16 i16;
 
   (void)i8b;
+  soundthread_sync(); /* z80 and sound chip state must be settled */
+  sound_flush();
   state_transfermode = mode; /* 0 = save, 1 = load */
   state_transfer8("ver", "major", 0, &state_major, 1);
   state_transfer8("ver", "minor", 0, &state_minor, 1);
@@ -352,7 +354,7 @@ static void state_dotransfer(unsigned int mode)
     cpuz80_z80.z80halted = i8;
   }
 #endif
-  YM2612_save_state();
+  sound_savestate();
 
   /* Z80 interrupt vector and line state */
 #ifdef RAZE
@@ -477,6 +479,7 @@ int state_loadfile(const char *filename)
   gen_reset();
 
   state_dotransfer(1); /* load into place */
+  vdp_tilecache_invalidate();
 
   /* free memory */
   free(blk);
@@ -20,8 +20,17 @@
 static SDL_AudioStream *soundp_stream = nullptr;
 static SDL_AudioDeviceID soundp_dev = 0;
 
-/* Track samples we've written but not yet confirmed played */
-static _Atomic unsigned int soundp_samples_pending = 0;
+/* Ring of interleaved stereo samples between the emulation, which is the
+   only writer, and SDL's audio thread, which is the only reader.  The two
+   positions count samples and only ever go up, each is stored by one side
+   and read by the other, so write - read is the fill level and neither side
+   takes a lock. */
+static sint16 *soundp_ring = nullptr;
+static unsigned int soundp_ringsize = 0; /* samples, a power of 2 */
+static _Atomic unsigned int soundp_ringwrite = 0;
+static _Atomic unsigned int soundp_ringread = 0;
+static _Atomic unsigned int soundp_underruns = 0;
+static _Atomic unsigned int soundp_overruns = 0;
 
 /*** soundp_detect_audio_backend - Detect audio backend ***/
 
@@ -64,6 +73,37 @@ static const char *soundp_detect_audio_backend(void)
   return "Unknown";
 }
 
+/*** soundp_callback - SDL's audio thread wants more, give it what the ring
+     has and SDL plays silence for anything short ***/
+
+static void SDLCALL soundp_callback(void *userdata, SDL_AudioStream *stream,
+                                    int additional, int total)
+{
+  unsigned int read =
+      atomic_load_explicit(&soundp_ringread, memory_order_relaxed);
+  unsigned int avail =
+      atomic_load_explicit(&soundp_ringwrite, memory_order_acquire) - read;
+  unsigned int want = additional / 4; /* stereo 16-bit = 4 bytes */
+
+  (void)userdata;
+  (void)total;
+  if (want > avail) {
+    atomic_fetch_add_explicit(&soundp_underruns, 1, memory_order_relaxed);
+    want = avail;
+  }
+  while (want > 0) {
+    unsigned int pos = read & (soundp_ringsize - 1);
+    unsigned int n = soundp_ringsize - pos;
+
+    if (n > want)
+      n = want;
+    SDL_PutAudioStreamData(stream, soundp_ring + pos * 2, n * 4);
+    read += n;
+    want -= n;
+  }
+  atomic_store_explicit(&soundp_ringread, read, memory_order_release);
+}
+
 /*** soundp_start - start sound hardware ***/
 
 int soundp_start(void)
@@ -72,9 +112,19 @@ int soundp_start(void)
   int num_devices;
   SDL_AudioDeviceID *devices;
   SDL_AudioDeviceID dev_id;
+  unsigned int fields, frames;
+  char hint[16];
 
   fprintf(stderr, "[AUDIO] soundp_start() called\n");
 
+  /* Ask for a device buffer under a field so that latencies down to two
+     fields don't run dry between callbacks, unless the user chose one */
+  for (frames = 64; frames * 2 <= sound_sampsperfield;)
+    frames <<= 1;
+  snprintf(hint, sizeof(hint), "%u", frames);
+  SDL_SetHintWithPriority(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, hint,
+                          SDL_HINT_DEFAULT);
+
   /* Initialize SDL audio if not already done */
   if (!SDL_WasInit(SDL_INIT_AUDIO)) {
     fprintf(stderr, "[AUDIO] Initializing SDL audio subsystem...\n");
@@ -135,19 +185,45 @@ int soundp_start(void)
     return 1;
   }
 
+  /* The ring holds as much as the frame pacing lets build up, which is up
+     to twice the threshold or sound_maxfields, plus some slack */
+  fields = sound_maxfields > 2 * sound_minfields ? sound_maxfields
+                                                 : 2 * sound_minfields;
+  for (soundp_ringsize = 1;
+       soundp_ringsize < sound_sampsperfield * (fields + 2);)
+    soundp_ringsize <<= 1;
+  soundp_ring = calloc(soundp_ringsize * 2, sizeof(sint16));
+  if (soundp_ring == nullptr) {
+    LOG_CRITICAL(("Failed to allocate %u samples of sound buffer",
+                  soundp_ringsize));
+    soundp_stop();
+    return 1;
+  }
+
+  /* Pre-fill the ring with silence to bootstrap the buffer level.  This
+     prevents the frame-skip logic from starving because the buffer never
+     reaches the threshold when production == consumption rate. */
+  atomic_store(&soundp_ringread, 0);
+  atomic_store(&soundp_ringwrite, sound_threshold);
+  atomic_store(&soundp_underruns, 0);
+  atomic_store(&soundp_overruns, 0);
+
+  /* SDL's audio thread pulls from the ring as the device needs it */
+  if (!SDL_SetAudioStreamGetCallback(soundp_stream, soundp_callback,
+                                     nullptr)) {
+    LOG_CRITICAL(("SDL_SetAudioStreamGetCallback failed: %s",
+                  SDL_GetError()));
+    soundp_stop();
+    return 1;
+  }
+
   /* Bind the stream to the audio device */
   if (!SDL_BindAudioStream(soundp_dev, soundp_stream)) {
     LOG_CRITICAL(("SDL_BindAudioStream failed: %s", SDL_GetError()));
-    SDL_DestroyAudioStream(soundp_stream);
-    soundp_stream = nullptr;
-    SDL_CloseAudioDevice(soundp_dev);
-    soundp_dev = 0;
+    soundp_stop();
     return 1;
   }
 
-  /* Initialize pending samples counter */
-  atomic_store(&soundp_samples_pending, 0);
-
   /* Start audio playback */
   SDL_ResumeAudioDevice(soundp_dev);
 
@@ -165,6 +241,8 @@ int soundp_start(void)
   LOG_VERBOSE(("Threshold = %d bytes (%d fields of sound === %dms latency)",
                sound_threshold * 4, sound_minfields,
                (int)(1000 * (float)sound_minfields / (float)vdp_framerate)));
+  LOG_VERBOSE(("Sound ring of %u samples, asked for %s sample device buffer",
+               soundp_ringsize, hint));
 
   /* Provide helpful information for PulseAudio users */
   if (strstr(backend, "PulseAudio") != nullptr &&
@@ -174,23 +252,6 @@ int soundp_start(void)
         ("     PipeWire provides 3-10ms latency vs PulseAudio's 50-100ms"));
   }
 
-  /* Pre-fill audio buffer with silence to bootstrap the buffer level.
-     This prevents the frame-skip logic from starving because the buffer
-     never reaches the threshold when production == consumption rate.
-     Pre-fill with ~3 frames worth of silence (half the threshold). */
-  {
-    unsigned int prefill_samples = sound_sampsperfield * 3;
-    size_t prefill_bytes = prefill_samples * 4; /* stereo 16-bit = 4 bytes */
-    int16_t *silence = (int16_t *)calloc(prefill_samples * 2, sizeof(int16_t));
-    if (silence) {
-      if (SDL_PutAudioStreamData(soundp_stream, silence, (int)prefill_bytes)) {
-        LOG_VERBOSE(("Pre-filled audio buffer with %u samples of silence",
-                     prefill_samples));
-      }
-      free(silence);
-    }
-  }
-
   return 0;
 }
 
@@ -208,6 +269,15 @@ void soundp_stop(void)
     SDL_CloseAudioDevice(soundp_dev);
     soundp_dev = 0;
   }
+  /* SDL's audio thread is done with the ring once the stream is gone */
+  if (soundp_ring) {
+    if (atomic_load(&soundp_underruns) || atomic_load(&soundp_overruns))
+      LOG_VERBOSE(("Sound ring ran dry %u times and overflowed %u times",
+                   atomic_load(&soundp_underruns),
+                   atomic_load(&soundp_overruns)));
+    free(soundp_ring);
+    soundp_ring = nullptr;
+  }
 }
 
 /*** soundp_pause - pause audio playback ***/
@@ -232,23 +302,14 @@ void soundp_resume(void)
 
 int soundp_samplesbuffered(void)
 {
-  if (!soundp_stream)
+  if (!soundp_ring)
     return 0;
 
-  /* SDL3: Get queued bytes in the audio stream */
-  int queued_bytes = SDL_GetAudioStreamQueued(soundp_stream);
-
-  /* Convert bytes to samples (4 bytes per stereo sample: 2 channels * 2 bytes) */
-  return queued_bytes / 4;
+  /* two atomic loads, no call into SDL */
+  return atomic_load_explicit(&soundp_ringwrite, memory_order_acquire) -
+         atomic_load_explicit(&soundp_ringread, memory_order_acquire);
 }
 
-/*** soundp_output - output samples to SDL3 ***/
-/* Thread Safety: SDL3 audio streams are internally synchronized.
-   SDL_PutAudioStreamData() and SDL_GetAudioStreamQueued() are thread-safe
-   when using bound audio streams, so no additional mutex is needed here.
-   The emulation thread calls this function to push samples, and SDL3's
-   audio callback thread consumes them safely. */
-
 /*** soundp_reset - full audio subsystem restart ***/
 
 int soundp_reset(void)
@@ -271,11 +332,10 @@ int soundp_reset(void)
 
 void soundp_output(uint16 *left, uint16 *right, unsigned int samples)
 {
-  int16_t *interleaved;
-  unsigned int i;
+  unsigned int write, space, i;
   static int debug_count = 0;
 
-  if (!soundp_stream || samples == 0) {
+  if (!soundp_ring || samples == 0) {
     if (debug_count < 3) {
       fprintf(stderr, "[AUDIO] soundp_output: NO STREAM! stream=%p samples=%u\n",
               (void*)soundp_stream, samples);
@@ -297,29 +357,24 @@ void soundp_output(uint16 *left, uint16 *right, unsigned int samples)
     /* Check device state */
     bool paused = SDL_AudioDevicePaused(soundp_dev);
     fprintf(stderr, "[AUDIO] soundp_output: %u samples, has_audio=%d, queued=%d, dev_paused=%d\n",
-            samples, has_audio, SDL_GetAudioStreamQueued(soundp_stream), (int)paused);
+            samples, has_audio, soundp_samplesbuffered(), (int)paused);
     debug_count++;
   }
 
-  /* Allocate interleaved buffer */
-  interleaved = malloc(samples * 2 * sizeof(int16_t));
-  if (!interleaved)
-    return;
-
-  /* Interleave left and right channels */
-  for (i = 0; i < samples; i++) {
-    interleaved[i * 2] = (int16_t)left[i];
-    interleaved[i * 2 + 1] = (int16_t)right[i];
+  /* Interleave straight into the ring, dropping what doesn't fit */
+  write = atomic_load_explicit(&soundp_ringwrite, memory_order_relaxed);
+  space = soundp_ringsize -
+          (write - atomic_load_explicit(&soundp_ringread, memory_order_acquire));
+  if (samples > space) {
+    atomic_fetch_add_explicit(&soundp_overruns, 1, memory_order_relaxed);
+    samples = space;
   }
+  for (i = 0; i < samples; i++) {
+    unsigned int pos = (write + i) & (soundp_ringsize - 1);
 
-  /* Push audio data to the stream */
-  if (!SDL_PutAudioStreamData(soundp_stream, interleaved, samples * 4)) {
-    static int err_count = 0;
-    if (err_count < 3) {
-      fprintf(stderr, "[AUDIO] SDL_PutAudioStreamData FAILED: %s\n", SDL_GetError());
-      err_count++;
-    }
+    soundp_ring[pos * 2] = (sint16)left[i];
+    soundp_ring[pos * 2 + 1] = (sint16)right[i];
   }
-
-  free(interleaved);
+  atomic_store_explicit(&soundp_ringwrite, write + samples,
+                        memory_order_release);
 }
@@ -843,17 +843,14 @@ void ui_line(int line)
 
 static void ui_simpleplot(void)
 {
-  unsigned int line;
   unsigned int width = (vdp_reg[12] & 1) ? 320 : 256;
   uint8 gfx[(320 + 16) * (240 + 16)];
 
   /* cell mode - entire frame done here */
   uiplot_checkpalcache(0);
   vdp_renderframe(gfx + (8 * (320 + 16)) + 8, 320 + 16); /* plot frame */
-  for (line = 0; line < vdp_vislines; line++) {
-    uiplot_convertdata16(gfx + 8 + (line + 8) * (320 + 16),
-                         ui_newscreen + line * 320, width);
-  }
+  uiplot_convertframe16(gfx + 8 + 8 * (320 + 16), 320 + 16, ui_newscreen,
+                        320 * 2, width, vdp_vislines);
 }
 
 /*** ui_endfield - end of field reached ***/
@@ -50,9 +50,19 @@ static t_opts gtkopts_opts[] = {
     {"fm", "on, off", "on", "frequency modulation sound generation"},
     {"psg", "on, off", "on", "programmable sound generation"},
     {"sound_minfields", "integer", "5",
-     "try to buffer this many fields of sound"},
+     "try to buffer this many fields of sound, down to 2"},
     {"sound_maxfields", "integer", "10",
      "maximum buffered sound fields before blocking (waiting)"},
+    {"soundthread", "on, off", "off",
+     "run z80 and sound chips on a second core"},
+    {"soundrate", "output, native", "output",
+     "run the sound chips at their own rate (~53 kHz) and filter down"},
+    {"renderthreads", "0..8", "0",
+     "threads rendering the screen while emulation continues, 0 for none"},
+    {"scalerthreads", "auto, 1..16", "auto",
+     "threads sharing each frame of xBRZ scaling, auto for one per core"},
+    {"planecache", "on, off", "on",
+     "keep scroll planes drawn out and copy lines from them"},
     {"audio_driver", "auto, pulseaudio, pipewire, alsa, jack, dummy", "auto",
      "Preferred SDL audio backend (auto = SDL default)"},
     {"loglevel", "integer (0-7)", "1", "logging level"},
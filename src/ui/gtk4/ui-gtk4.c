@@ -27,6 +27,7 @@
 #include "uiplot.h"
 #include "gtkopts.h"
 #include "vdp.h"
+#include "vdpthread.h"
 #include "gensound.h"
 #include "gensoundp.h"
 #include "cpu68k.h"
@@ -71,6 +72,9 @@ static void ui_newframe(int pending_samples);
 static void ui_simpleplot(void);
 static void ui_sdl_events(void);
 static void ui_rendertoscreen(void);
+static int ui_dirtyframe(t_vdp_rect *rect, unsigned int width,
+                         unsigned int height, unsigned int reach);
+static void ui_plotlogged(void);
 static gboolean ui_gtk4_apply_audio_driver(const char *requested,
                                            gboolean restart_audio,
                                            gboolean persist_config);
@@ -179,22 +183,16 @@ int ui_init(int argc, char *argv[])
   /* Initialize emulation thread state (thread started after GTK activation) */
   gen_ui->emu_thread = nullptr;
   gen_ui->emu_thread_running = FALSE;
-  gen_ui->frame_requested = FALSE;
+  gen_ui->frames_requested = 0;
   atomic_store(&gen_ui->render_complete, 0);
+  atomic_store(&gen_ui->fps, -1);
 
   /* Initialize debug output (set GENERATOR_DEBUG=1 to enable) */
   gen_ui->debug_telemetry = (g_getenv("GENERATOR_DEBUG") != nullptr);
 
   /* Initialize dynamic rate control */
   gen_ui->dynamic_rate_control = TRUE; /* Enable by default */
-  gen_ui->rate_adjust = 1.0;           /* Normal speed */
-  gen_ui->rate_delta = 0.03;           /* ±3% default adjustment window */
-  gen_ui->fps_index = 0;
-  gen_ui->measured_fps = 0.0;
-  gen_ui->frames_recorded = 0;
-  gen_ui->debug_counter = 0;
   gen_ui->last_frame_time = 0;
-  /* fps_times array is zero-initialized by g_new0 */
 
   /* Pre-allocate upscaling buffers to avoid malloc/free per frame
      Maximum size needed: 320x240 @ 4x scale = 1280x960 pixels */
@@ -203,8 +201,6 @@ int ui_init(int argc, char *argv[])
       g_malloc(gen_ui->upscale_buffer_size * sizeof(guint32));
   gen_ui->upscale_dst_buffer =
       g_malloc(gen_ui->upscale_buffer_size * sizeof(guint32));
-  /* Scale4x needs intermediate 2x buffer: 640x480 pixels max */
-  gen_ui->scale4x_temp_buffer = g_malloc(640 * 480 * sizeof(guint32));
 
   /* Allocate screen buffers */
   gen_ui->screen_buffers[0] = g_malloc0(4 * HMAXSIZE * VMAXSIZE);
@@ -267,6 +263,39 @@ int ui_init(int argc, char *argv[])
   /* Apply scaler setting from config */
   ui_gtk4_apply_scaler(gtkopts_getvalue("scaler"));
 
+  /* Z80 and sound chips on a second core - takes effect at the next field */
+  sound_threaded = gtkopts_getvalue("soundthread") &&
+                   g_ascii_strcasecmp(gtkopts_getvalue("soundthread"), "on") == 0;
+
+  /* Sound latency in fields, the sound ring is sized from these when sound
+     starts and two fields is about as low as it goes without dropouts */
+  if (gtkopts_getvalue("sound_minfields"))
+    sound_minfields = atoi(gtkopts_getvalue("sound_minfields"));
+  if (gtkopts_getvalue("sound_maxfields"))
+    sound_maxfields = atoi(gtkopts_getvalue("sound_maxfields"));
+
+  /* Sound chips at their own rate and resampled to the output's, taken up
+     when sound starts and at each reset */
+  sound_native =
+      gtkopts_getvalue("soundrate") &&
+      g_ascii_strcasecmp(gtkopts_getvalue("soundrate"), "native") == 0;
+
+  /* Fields are timed off our clock and the sound resampled to suit, rather
+     than frames skipped to suit the sound */
+  sound_drc = gen_ui->dynamic_rate_control;
+
+  /* Line rendering on other cores - also from the next field */
+  if (gtkopts_getvalue("renderthreads"))
+    vdp_renderthreads = atoi(gtkopts_getvalue("renderthreads"));
+
+  /* xBRZ bands scaled on a pool of threads, auto (0) for one per core */
+  if (gtkopts_getvalue("scalerthreads"))
+    uiplot_xbrz_threads(atoi(gtkopts_getvalue("scalerthreads")));
+
+  /* Pre-drawn scroll planes */
+  vdp_planecache = !gtkopts_getvalue("planecache") ||
+                   g_ascii_strcasecmp(gtkopts_getvalue("planecache"), "off");
+
   /* Initialize SDL for gamepad support only.
    * NOTE: We do NOT initialize SDL_INIT_VIDEO because GTK4 handles all rendering.
    * Initializing SDL video can conflict with GTK4's Wayland/X11 display handling. */
@@ -294,6 +323,9 @@ int ui_init(int argc, char *argv[])
   gen_ui->screen1 = gen_ui->screen_buffers[1];
   gen_ui->newscreen = gen_ui->screen_buffers[2];
   atomic_store(&gen_ui->whichbank, 0);
+  g_mutex_init(&gen_ui->texture_mutex);
+  gen_ui->texture = nullptr;
+  gen_ui->texture_dirty.width = 0;
   gen_ui->musicfile_fd = -1;
 
   /* Set up color conversion for Cairo CAIRO_FORMAT_RGB24
@@ -425,6 +457,7 @@ static void ui_shutdown(GtkApplication *app, gpointer user_data)
 
   /* Stop the emulation thread */
   ui_stop_emu_thread();
+  g_clear_object(&gen_ui->texture);
 
   /* Close all gamepads */
   for (int i = 0; i < MAX_GAMEPADS; i++) {
@@ -438,6 +471,7 @@ static void ui_shutdown(GtkApplication *app, gpointer user_data)
   /* Stop and cleanup sound system - this will close SDL3 audio device
      and stop the audio callback thread, preventing sound from continuing */
   sound_final();
+  vdpthread_stop();
 
   /* Shutdown core and destroy context */
   if (gen_ui->ctx != nullptr) {
@@ -867,6 +901,12 @@ void ui_action_quit(GSimpleAction *action, GVariant *parameter,
 static void ui_update_texture(void)
 {
   uint8 *screen_data;
+  GdkTexture *texture, *previous;
+  cairo_rectangle_int_t dirty;
+#if GTK_CHECK_VERSION(4, 16, 0)
+  GdkMemoryTextureBuilder *builder;
+  cairo_region_t *region = nullptr;
+#endif
   unsigned int base_width = (gen_ctx_vdp_reg()[12] & 1) ? 320 : 256;
   unsigned int base_height = gen_ctx_vdp_vislines();
   unsigned int xoffset = (gen_ctx_vdp_reg()[12] & 1) ? 0 : 32;
@@ -885,9 +925,24 @@ static void ui_update_texture(void)
   /* Double buffering: display the buffer indicated by whichbank
    * whichbank is updated atomically by ui_rendertoscreen() after each frame
    * completes, so we're always reading from a stable, complete frame. */
+  g_mutex_lock(&gen_ui->texture_mutex);
   int current_bank = atomic_load(&gen_ui->whichbank);
+  dirty = gen_ui->texture_dirty;
+  gen_ui->texture_dirty.width = 0;
+  g_mutex_unlock(&gen_ui->texture_mutex);
   screen_data = (current_bank == 0) ? gen_ui->screen0 : gen_ui->screen1;
 
+  /* The new texture is the last one with just the dirty area changed, so
+   * if nothing has changed and it would show the same buffer there's no
+   * need for a new one at all */
+  previous = gen_ui->texture;
+  if (previous &&
+      (gdk_texture_get_width(previous) != (int)display_width ||
+       gdk_texture_get_height(previous) != (int)display_height))
+    previous = nullptr;
+  if (previous && dirty.width == 0 && gen_ui->texture_bank == current_bank)
+    return;
+
   /* Calculate pointer to actual display region within the buffer */
   uint8 *display_start = screen_data +
       (scaled_yoffset * HMAXSIZE + scaled_xoffset) * 4;
@@ -900,20 +955,42 @@ static void ui_update_texture(void)
   /* Create texture with stride (HMAXSIZE * 4 bytes per row)
    * Format: GDK_MEMORY_B8G8R8X8 matches our buffer layout
    * (Blue at byte 0, Green at byte 1, Red at byte 2, unused at byte 3) */
-  GdkTexture *texture = gdk_memory_texture_new(
+#if GTK_CHECK_VERSION(4, 16, 0)
+  /* Marked as an update of the last texture so only the dirty area needs
+   * uploading again */
+  builder = gdk_memory_texture_builder_new();
+  gdk_memory_texture_builder_set_bytes(builder, bytes);
+  gdk_memory_texture_builder_set_stride(builder, HMAXSIZE * 4);
+  gdk_memory_texture_builder_set_width(builder, display_width);
+  gdk_memory_texture_builder_set_height(builder, display_height);
+  gdk_memory_texture_builder_set_format(builder, GDK_MEMORY_B8G8R8X8);
+  if (previous) {
+    region = cairo_region_create_rectangle(&dirty);
+    gdk_memory_texture_builder_set_update_texture(builder, previous);
+    gdk_memory_texture_builder_set_update_region(builder, region);
+  }
+  texture = gdk_memory_texture_builder_build(builder);
+  g_object_unref(builder);
+  if (region)
+    cairo_region_destroy(region);
+#else
+  texture = gdk_memory_texture_new(
       display_width,
       display_height,
       GDK_MEMORY_B8G8R8X8,
       bytes,
       HMAXSIZE * 4  /* stride: full buffer width including borders */
   );
+#endif
 
   /* Update the GtkPicture with the new texture */
   gtk_picture_set_paintable(GTK_PICTURE(gen_ui->picture),
                             GDK_PAINTABLE(texture));
 
-  /* Release our references - GtkPicture holds its own reference */
-  g_object_unref(texture);
+  /* Keep ours for the next update - GtkPicture holds its own reference */
+  g_clear_object(&gen_ui->texture);
+  gen_ui->texture = texture;
+  gen_ui->texture_bank = current_bank;
   g_bytes_unref(bytes);
 }
 
@@ -1038,8 +1115,6 @@ static gboolean ui_tick_callback(GtkWidget *widget, GdkFrameClock *frame_clock,
   if (!gen_ui->running) {
     /* Keep timestamps in sync so we don't try to "catch up" when resuming. */
     gen_ui->last_frame_time = 0;
-    gen_ui->frames_recorded = 0;
-    gen_ui->fps_index = 0;
     return G_SOURCE_CONTINUE;
   }
 
@@ -1057,16 +1132,19 @@ static gboolean ui_tick_callback(GtkWidget *widget, GdkFrameClock *frame_clock,
   /* Calculate frame duration based on Genesis timing
      NTSC: 60Hz = 16666.67 microseconds per frame
      PAL:  50Hz = 20000 microseconds per frame
-     Apply dynamic rate adjustment if enabled */
-  if (gen_ui->dynamic_rate_control) {
-    /* Apply rate adjustment: higher rate_adjust means slower emulation (longer
-     * frame time) */
-    frame_duration_us = (gen_ctx_vdp_pal() ? 20000 : 16667) * gen_ui->rate_adjust;
-  } else {
-    frame_duration_us = gen_ctx_vdp_pal() ? 20000 : 16667;
-  }
+     last_frame_time moves on a field at a time as fields are requested, not
+     to the tick that sees one done, so fields come at this rate on average
+     whatever the display refreshes at - with dynamic rate control the sound
+     resampler then only has the sound card's clock to take up */
+  frame_duration_us = gen_ctx_vdp_pal() ? 20000 : 16667;
 
   elapsed_us = current_time - gen_ui->last_frame_time;
+  if (elapsed_us > frame_duration_us * 4) {
+    /* stalled (a resize, a slow machine) - start again from now rather than
+       run the missed fields back to back */
+    gen_ui->last_frame_time = current_time - frame_duration_us;
+    elapsed_us = frame_duration_us;
+  }
 
   /* Check sound buffer status to prevent overflow
      This provides backpressure to maintain audio/video sync */
@@ -1081,7 +1159,7 @@ static gboolean ui_tick_callback(GtkWidget *widget, GdkFrameClock *frame_clock,
       fprintf(stderr,
               "GTK4 audio telemetry: min_buffer=%d threshold=%u feedback=%d "
               "rate=%.4f\n",
-              min_pending, gen_ctx_sound_threshold(), gen_ctx_sound_feedback(), gen_ui->rate_adjust);
+              min_pending, gen_ctx_sound_threshold(), gen_ctx_sound_feedback(), sound_drcratio);
       min_pending = INT_MAX;
       frames_tracked = 0;
     }
@@ -1090,6 +1168,10 @@ static gboolean ui_tick_callback(GtkWidget *widget, GdkFrameClock *frame_clock,
   /* If sound buffer is too full (more than 2x threshold), skip this frame
      to let audio catch up and prevent buffer overflow */
   if (pending_samples > (int)(gen_ctx_sound_threshold() * 2)) {
+    while (elapsed_us >= frame_duration_us) {
+      gen_ui->last_frame_time += frame_duration_us;
+      elapsed_us -= frame_duration_us;
+    }
     return G_SOURCE_CONTINUE;
   }
 
@@ -1109,80 +1191,47 @@ static gboolean ui_tick_callback(GtkWidget *widget, GdkFrameClock *frame_clock,
        * Buffer swap already done in gtk4_cb_end_field via ui_rendertoscreen */
       ui_update_texture();
 
-      /* Update timing for rate control */
-      gen_ui->last_frame_time = current_time;
       pending_samples = soundp_samplesbuffered();
-
-      /* Record frame for FPS measurement */
-      if (gen_ui->dynamic_rate_control) {
-        gen_ui->fps_times[gen_ui->fps_index] = current_time;
-        if (gen_ui->frames_recorded < 60)
-          gen_ui->frames_recorded++;
-        gen_ui->fps_index = (gen_ui->fps_index + 1) % 60;
-
-        /* Calculate rate adjustment */
-        if (gen_ui->frames_recorded >= 60) {
-          int oldest_idx = gen_ui->fps_index;
-          int newest_idx = (gen_ui->fps_index + 59) % 60;
-          gint64 time_span =
-              gen_ui->fps_times[newest_idx] - gen_ui->fps_times[oldest_idx];
-
-          if (time_span > 1000) {
-            gen_ui->measured_fps = 59.0 * 1000000.0 / (double)time_span;
-            double target_fps = gen_ctx_vdp_pal() ? 50.0 : 59.94;
-            double fps_error = (gen_ui->measured_fps - target_fps) / target_fps;
-            double buffer_ratio =
-                (double)pending_samples / (double)gen_ctx_sound_threshold();
-            double buffer_error = buffer_ratio - 1.0;
-            double total_error = (fps_error * 0.25) + (buffer_error * 0.75);
-
-            double adaptive_delta = gen_ui->rate_delta;
-            if (buffer_error < -0.40)
-              adaptive_delta = 0.08;
-            else if (buffer_error < -0.20 && adaptive_delta < 0.05)
-              adaptive_delta = 0.05;
-            else if (buffer_error > 0.50 && adaptive_delta < 0.05)
-              adaptive_delta = 0.05;
-
-            double new_rate_adjust =
-                gen_ui->rate_adjust * (1.0 + total_error * 0.25);
-            double min_rate = 1.0 - adaptive_delta;
-            double max_rate = 1.0 + adaptive_delta;
-            if (new_rate_adjust < min_rate)
-              new_rate_adjust = min_rate;
-            if (new_rate_adjust > max_rate)
-              new_rate_adjust = max_rate;
-
-            gen_ui->rate_adjust =
-                gen_ui->rate_adjust * 0.9 + new_rate_adjust * 0.1;
-
-            if (gen_ui->debug_telemetry) {
-              gen_ui->debug_counter++;
-              if (gen_ui->debug_counter >= 60) {
-                fprintf(stderr,
-                        "DRC: FPS=%.2f (target=%.2f) buffer=%d/%d "
-                        "rate_adjust=%.4f\n",
-                        gen_ui->measured_fps, target_fps, pending_samples,
-                        gen_ctx_sound_threshold(), gen_ui->rate_adjust);
-                gen_ui->debug_counter = 0;
-              }
-            }
-          }
-        }
-      }
     }
 
-    /* Determine if we should request more frames from the emulation thread */
-    gboolean should_request =
-        (elapsed_us >= frame_duration_us) ||
-        (pending_samples < (int)(gen_ctx_sound_threshold() * 0.80));
+    /* ui_newframe runs on the emulation thread, the label is set here */
+    int fps = atomic_exchange(&gen_ui->fps, -1);
 
-    if (should_request && !gen_ui->frame_requested) {
-      /* Prepare frame parameters and signal emulation thread */
-      ui_newframe(pending_samples);
+    if (fps >= 0 && gen_ui->statusbar_enabled) {
+      char fps_string[64];
 
+      snprintf(fps_string, sizeof(fps_string), "FPS: %d", fps);
+      gtk_label_set_text(GTK_LABEL(gen_ui->status_label), fps_string);
+    }
+
+    /* Request every field that has come due, up to two ahead of the
+       emulation thread - a display slower than the field rate gets two
+       some refreshes */
+    guint requested, due = 0;
+
+    g_mutex_lock(&gen_ui->emu_mutex);
+    requested = gen_ui->frames_requested;
+    g_mutex_unlock(&gen_ui->emu_mutex);
+    while (elapsed_us >= frame_duration_us && requested + due < 2) {
+      gen_ui->last_frame_time += frame_duration_us;
+      elapsed_us -= frame_duration_us;
+      due++;
+    }
+
+    /* Safety net: the sound running short with no rate control, or with
+       the resampler already stretching it all it can (the emulation falling
+       behind), gets a field now */
+    if (!due && !requested &&
+        pending_samples < (int)(gen_ctx_sound_threshold() * 0.80) &&
+        (!gen_ui->dynamic_rate_control ||
+         sound_drcratio > 1.0 + SOUND_DRCMAX * 0.9))
+      due = 1;
+
+    if (due) {
+      /* Signal the emulation thread, which calls ui_newframe as it starts
+         each field so every field gets its own plot decision */
       g_mutex_lock(&gen_ui->emu_mutex);
-      gen_ui->frame_requested = TRUE;
+      gen_ui->frames_requested += due;
       g_cond_signal(&gen_ui->emu_cond);
       g_mutex_unlock(&gen_ui->emu_mutex);
     }
@@ -1204,7 +1253,6 @@ static void ui_newframe(int pending_samples)
   static unsigned int consecutive_skips = 0;
   unsigned int i;
   int fps;
-  char fps_string[64];
 
   if (frameplots_i > gen_ctx_vdp_framerate())
     frameplots_i = 0;
@@ -1229,7 +1277,10 @@ static void ui_newframe(int pending_samples)
   } else {
     /* Not in interlace mode, or in interlace mode on even field */
     gen_ui->plotfield = FALSE;
-    if (gen_ui->frameskip == 0) {
+    if (gen_ui->frameskip == 0 && gen_ui->dynamic_rate_control) {
+      /* The sound is resampled to keep up, every field is shown */
+      gen_ui->plotfield = TRUE;
+    } else if (gen_ui->frameskip == 0) {
       /* Dynamic frame skipping based on audio buffer level.
          Use cached pending_samples from caller to avoid redundant polling. */
 
@@ -1243,7 +1294,7 @@ static void ui_newframe(int pending_samples)
         /* After startup: Use adaptive threshold based on samples per field.
            Allow rendering if buffer has at least 1 field worth of audio.
            This is much more achievable than 50% of threshold (2.5 fields). */
-        unsigned int min_buffer = gen_ctx_sound_threshold() / 5; /* ~1 field */
+        unsigned int min_buffer = sound_sampsperfield; /* 1 field */
         if (pending_samples >= (int)min_buffer) {
           gen_ui->plotfield = TRUE;
           consecutive_skips = 0;
@@ -1284,16 +1335,13 @@ static void ui_newframe(int pending_samples)
   }
   frameplots[frameplots_i++] = 1;
 
-  if (gen_ui->statusbar_enabled) {
-    snprintf(fps_string, sizeof(fps_string), "FPS: %d", fps);
-    gtk_label_set_text(GTK_LABEL(gen_ui->status_label), fps_string);
-  }
+  /* for ui_tick_callback to show, GTK is only used from the main thread */
+  atomic_store(&gen_ui->fps, fps);
   skipcount = 0;
 }
 
 void ui_line(int line)
 {
-  static uint8 gfx[320];
   unsigned int width = (gen_ctx_vdp_reg()[12] & 1) ? 320 : 256;
 
   if (!gen_ui->plotfield)
@@ -1309,21 +1357,20 @@ void ui_line(int line)
   }
 
   /* We are plotting this frame, and we're not doing a simple plot */
-  switch ((gen_ctx_vdp_reg()[12] >> 1) & 3) {
-  case 0: /* normal */
-  case 1: /* interlace simply doubled up */
-  case 2: /* invalid */
-    vdp_renderline(line, gfx, 0);
-    break;
-  case 3: /* interlace with double resolution */
-    vdp_renderline(line, gfx, gen_ctx_vdp_oddframe());
-    break;
+  if (vdpthread_on) {
+    /* render threads - converted in ui_endfield once they've finished */
+    vdp_logline(line, ((gen_ctx_vdp_reg()[12] >> 1) & 3) == 3
+                          ? gen_ctx_vdp_oddframe()
+                          : 0);
+    return;
   }
-
+  /* Render and convert 8-bit palette indices to 32-bit RGBA in one go */
   uiplot_checkpalcache(0);
-  /* Convert 8-bit palette indices to 32-bit RGBA and write to newscreen */
-  uiplot_convertdata32(gfx, (uint32 *)(gen_ui->newscreen + line * 384 * 4),
-                       width);
+  vdp_renderline_rgb32(line, (uint32 *)(gen_ui->newscreen + line * 384 * 4),
+                       uiplot_palcache, width,
+                       ((gen_ctx_vdp_reg()[12] >> 1) & 3) == 3
+                           ? gen_ctx_vdp_oddframe()
+                           : 0);
 }
 
 void ui_endfield(void)
@@ -1331,6 +1378,7 @@ void ui_endfield(void)
   static int counter = 0;
 
   if (gen_ui->plotfield) {
+    ui_plotlogged();
     ui_rendertoscreen(); /* plot newscreen to screen */
 
     /* NOTE: Frame rate limiting is handled by ui_tick_callback() using
@@ -1359,8 +1407,66 @@ void ui_endfield(void)
   }
 }
 
+/*** ui_plotlogged - convert the lines the render threads produced ***/
+
+static void ui_plotlogged(void)
+{
+  const uint8 *gfx;
+  const uint8 *cram;
+  unsigned int line, width;
+
+  if (!vdpthread_on)
+    return;
+  vdp_logfield();
+  for (line = 0; line < gen_ctx_vdp_vislines(); line++) {
+    if (!(gfx = vdp_loggedline(line, &cram, &width)))
+      continue;
+    if (cram)
+      uiplot_loadpalcache(cram);
+    /* an unchanged line is still there from last time */
+    if (vdp_dirty[line].right)
+      uiplot_convertdata32((uint8 *)gfx,
+                           (uint32 *)(gen_ui->newscreen + line * 384 * 4),
+                           width);
+  }
+}
+
+/*** ui_dirtyframe - the part of the frame that needs drawing again ***/
+
+/* the area the VDP says changed since the frame before, widened by reach
+   for filters that look at the pixels around, or all of it if the frame is
+   laid out or filtered differently from last time.  Returns 0 if nothing
+   changed */
+
+static int ui_dirtyframe(t_vdp_rect *rect, unsigned int width,
+                         unsigned int height, unsigned int reach)
+{
+  static unsigned int lastlayout;
+  unsigned int mode = (gen_ctx_vdp_reg()[12] >> 1) & 3;
+  unsigned int layout = width | height << 9 | mode << 18 |
+                        gen_ui->filter_type << 20 | gen_ui->scale_factor << 26;
+
+  if (layout != lastlayout || mode == 3) {
+    /* double resolution interlace - alternate fields differ anyway */
+    lastlayout = layout;
+    rect->top = 0;
+    rect->bottom = height;
+    rect->left = 0;
+    rect->right = width;
+    return 1;
+  }
+  if (!vdp_dirtyrect(height, rect))
+    return 0;
+  rect->top = rect->top > reach ? rect->top - reach : 0;
+  rect->bottom = rect->bottom + reach < height ? rect->bottom + reach : height;
+  rect->left = rect->left > reach ? rect->left - reach : 0;
+  rect->right = rect->right + reach < width ? rect->right + reach : width;
+  return 1;
+}
+
 static void ui_rendertoscreen(void)
 {
+  static t_vdp_rect lastdirty;
   uint32 *newlinedata, *oldlinedata;
   unsigned int line;
   unsigned int nominalwidth = (gen_ctx_vdp_reg()[12] & 1) ? 320 : 256;
@@ -1371,6 +1477,12 @@ static void ui_rendertoscreen(void)
   uint8 *display_buffer; /* buffer currently being displayed */
   uint32 *evenscreen;    /* interlace: lines 0,2,etc. */
   uint32 *oddscreen;     /*            lines 1,3,etc. */
+  unsigned int vislines = gen_ctx_vdp_vislines();
+  int scale = (gen_ui->filter_type != FILTER_NONE && gen_ui->scale_factor > 1)
+                  ? gen_ui->scale_factor
+                  : 1;
+  t_vdp_rect dirty = {0, 0, 0, 0}; /* source area to filter again */
+  unsigned int copytop, copybottom; /* source rows to copy out */
 
   /* Double buffering: write to the buffer NOT currently being displayed
    * whichbank indicates which buffer is being displayed:
@@ -1385,6 +1497,27 @@ static void ui_rendertoscreen(void)
     write_buffer = gen_ui->screen0;
   }
 
+  /* Only what has changed is filtered and copied.  The write buffer last
+   * had a frame two frames ago, so it also needs what changed last frame */
+  ui_dirtyframe(&dirty, nominalwidth, vislines,
+                scale == 1 ? 0
+                : (gen_ui->filter_type == FILTER_XBRZ2X ||
+                   gen_ui->filter_type == FILTER_XBRZ3X ||
+                   gen_ui->filter_type == FILTER_XBRZ4X)
+                    ? UIPLOT_XBRZ_REACH
+                    : UIPLOT_SCALE_REACH);
+  copytop = dirty.top;
+  copybottom = dirty.bottom;
+  if (lastdirty.top < lastdirty.bottom) {
+    if (copytop == copybottom || lastdirty.top < copytop)
+      copytop = lastdirty.top;
+    if (lastdirty.bottom > copybottom)
+      copybottom = lastdirty.bottom;
+  }
+  if (copybottom > vislines)
+    copybottom = vislines;
+  lastdirty = dirty;
+
   /* Render based on interlace mode */
   switch ((gen_ctx_vdp_reg()[12] >> 1) & 3) {
   case 0: /* normal */
@@ -1394,7 +1527,6 @@ static void ui_rendertoscreen(void)
     if (gen_ui->filter_type != FILTER_NONE && gen_ui->scale_factor > 1) {
       /* Calculate scaled dimensions */
       unsigned int scaled_width = nominalwidth * gen_ui->scale_factor;
-      unsigned int scaled_height = gen_ctx_vdp_vislines() * gen_ui->scale_factor;
 
       /* Apply the selected upscaling filter
        * Scale2x/3x/4x: read directly from newscreen using stride parameter
@@ -1402,47 +1534,43 @@ static void ui_rendertoscreen(void)
       switch (gen_ui->filter_type) {
       case FILTER_SCALE2X:
         /* Read directly from newscreen with stride (384 pixels = 1536 bytes) */
-        uiplot_scale2x_frame32((uint32 *)gen_ui->newscreen,
-                               gen_ui->upscale_dst_buffer, nominalwidth,
-                               gen_ctx_vdp_vislines(), 384 * 4, scaled_width * 4);
+        uiplot_scale2x_rows32((uint32 *)gen_ui->newscreen,
+                              gen_ui->upscale_dst_buffer, nominalwidth,
+                              vislines, dirty.top, dirty.bottom, 384 * 4,
+                              scaled_width * 4);
         break;
       case FILTER_SCALE3X:
-        uiplot_scale3x_frame32((uint32 *)gen_ui->newscreen,
-                               gen_ui->upscale_dst_buffer, nominalwidth,
-                               gen_ctx_vdp_vislines(), 384 * 4, scaled_width * 4);
+        uiplot_scale3x_rows32((uint32 *)gen_ui->newscreen,
+                              gen_ui->upscale_dst_buffer, nominalwidth,
+                              vislines, dirty.top, dirty.bottom, 384 * 4,
+                              scaled_width * 4);
         break;
       case FILTER_SCALE4X:
-        uiplot_scale4x_frame32((uint32 *)gen_ui->newscreen,
-                               gen_ui->upscale_dst_buffer,
-                               gen_ui->scale4x_temp_buffer, nominalwidth,
-                               gen_ctx_vdp_vislines(), 384 * 4, scaled_width * 4);
+        uiplot_scale4x_rows32((uint32 *)gen_ui->newscreen,
+                              gen_ui->upscale_dst_buffer, nominalwidth,
+                              vislines, dirty.top, dirty.bottom, 384 * 4,
+                              scaled_width * 4);
         break;
       case FILTER_XBRZ2X:
       case FILTER_XBRZ3X:
       case FILTER_XBRZ4X:
-        /* xBRZ needs packed input - copy with stride removal first */
-        for (line = 0; line < gen_ctx_vdp_vislines(); line++) {
+        /* xBRZ needs packed input - copy with stride removal first.  The
+         * rows either side that xBRZ also reads haven't changed */
+        for (line = dirty.top; line < dirty.bottom; line++) {
           newlinedata = (uint32 *)(gen_ui->newscreen + line * 384 * 4);
           memcpy(gen_ui->upscale_src_buffer + line * nominalwidth, newlinedata,
                  nominalwidth * sizeof(uint32));
         }
-        if (gen_ui->filter_type == FILTER_XBRZ2X) {
-          uiplot_xbrz_frame32(2, gen_ui->upscale_src_buffer,
-                              gen_ui->upscale_dst_buffer, nominalwidth,
-                              gen_ctx_vdp_vislines());
-        } else if (gen_ui->filter_type == FILTER_XBRZ3X) {
-          uiplot_xbrz_frame32(3, gen_ui->upscale_src_buffer,
-                              gen_ui->upscale_dst_buffer, nominalwidth,
-                              gen_ctx_vdp_vislines());
-        } else {
-          uiplot_xbrz_frame32(4, gen_ui->upscale_src_buffer,
-                              gen_ui->upscale_dst_buffer, nominalwidth,
-                              gen_ctx_vdp_vislines());
-        }
+        uiplot_xbrz_rows32(gen_ui->filter_type == FILTER_XBRZ2X   ? 2
+                           : gen_ui->filter_type == FILTER_XBRZ3X ? 3
+                                                                  : 4,
+                           gen_ui->upscale_src_buffer,
+                           gen_ui->upscale_dst_buffer, nominalwidth, vislines,
+                           dirty.top, dirty.bottom);
         break;
       default:
         /* Fallback: simple copy without scaling */
-        for (line = 0; line < gen_ctx_vdp_vislines(); line++) {
+        for (line = dirty.top; line < dirty.bottom; line++) {
           newlinedata = (uint32 *)(gen_ui->newscreen + line * 384 * 4);
           memcpy(gen_ui->upscale_dst_buffer + line * scaled_width, newlinedata,
                  nominalwidth * sizeof(uint32));
@@ -1453,7 +1581,7 @@ static void ui_rendertoscreen(void)
       /* Copy scaled data to write buffer with proper offsets */
       unsigned int scaled_yoffset = yoffset * gen_ui->scale_factor;
       unsigned int scaled_xoffset = xoffset * gen_ui->scale_factor;
-      for (line = 0; line < scaled_height; line++) {
+      for (line = copytop * scale; line < copybottom * scale; line++) {
         screen = write_buffer +
                  ((line + scaled_yoffset) * HMAXSIZE + scaled_xoffset) * 4;
         memcpy(screen, gen_ui->upscale_dst_buffer + line * scaled_width,
@@ -1461,7 +1589,7 @@ static void ui_rendertoscreen(void)
       }
     } else {
       /* No upscaling - simple rendering */
-      for (line = 0; line < gen_ctx_vdp_vislines(); line++) {
+      for (line = copytop; line < copybottom; line++) {
         newlinedata = (uint32 *)(gen_ui->newscreen + line * 384 * 4);
         screen = write_buffer + ((line + yoffset) * HMAXSIZE + xoffset) * 4;
         memcpy(screen, newlinedata, nominalwidth * 4);
@@ -1506,14 +1634,25 @@ static void ui_rendertoscreen(void)
   /* Swap buffers: the buffer we just wrote to becomes the display buffer
    * This ensures Cairo reads from a complete, stable frame while we render
    * the next frame to the other buffer. This eliminates tearing and stuttering.
-   */
+   * What changed goes with it for ui_update_texture, in display pixels */
+  g_mutex_lock(&gen_ui->texture_mutex);
+  if (dirty.top < dirty.bottom) {
+    cairo_rectangle_int_t area = {
+        dirty.left * scale, dirty.top * scale,
+        (dirty.right - dirty.left) * scale, (dirty.bottom - dirty.top) * scale};
+    if (gen_ui->texture_dirty.width)
+      gdk_rectangle_union(&gen_ui->texture_dirty, &area,
+                          &gen_ui->texture_dirty);
+    else
+      gen_ui->texture_dirty = area;
+  }
   int old_bank = atomic_load(&gen_ui->whichbank);
   atomic_store(&gen_ui->whichbank, (old_bank == 0) ? 1 : 0);
+  g_mutex_unlock(&gen_ui->texture_mutex);
 }
 
 static void ui_simpleplot(void)
 {
-  unsigned int line;
   unsigned int width = (gen_ctx_vdp_reg()[12] & 1) ? 320 : 256;
   uint8 gfx[(320 + 16) * (240 + 16)];
 
@@ -1521,10 +1660,9 @@ static void ui_simpleplot(void)
   uiplot_checkpalcache(0);
   vdp_renderframe(gfx + (8 * (320 + 16)) + 8, 320 + 16); /* plot frame */
 
-  for (line = 0; line < gen_ctx_vdp_vislines(); line++) {
-    uiplot_convertdata32(gfx + 8 + (line + 8) * (320 + 16),
-                         (uint32 *)(gen_ui->newscreen + line * 384 * 4), width);
-  }
+  uiplot_convertframe32(gfx + 8 + 8 * (320 + 16), 320 + 16,
+                        (uint32 *)gen_ui->newscreen, 384 * 4, width,
+                        gen_ctx_vdp_vislines());
 }
 
 static void ui_sdl_events(void)
@@ -2156,7 +2294,6 @@ void ui_musiclog(uint8 *data, unsigned int length)
 static void gtk4_cb_line(gen_context_t *ctx, int line)
 {
   (void)ctx; /* Use gen_ui directly for now */
-  static uint8 gfx[320];
   unsigned int width = (gen_ctx_vdp_reg()[12] & 1) ? 320 : 256;
 
   if (!gen_ui->plotfield)
@@ -2170,20 +2307,18 @@ static void gtk4_cb_line(gen_context_t *ctx, int line)
     return;
   }
 
-  switch ((gen_ctx_vdp_reg()[12] >> 1) & 3) {
-  case 0:
-  case 1:
-  case 2:
-    vdp_renderline(line, gfx, 0);
-    break;
-  case 3:
-    vdp_renderline(line, gfx, gen_ctx_vdp_oddframe());
-    break;
+  if (vdpthread_on) {
+    vdp_logline(line, ((gen_ctx_vdp_reg()[12] >> 1) & 3) == 3
+                          ? gen_ctx_vdp_oddframe()
+                          : 0);
+    return;
   }
-
   uiplot_checkpalcache(0);
-  uiplot_convertdata32(gfx, (uint32 *)(gen_ui->newscreen + line * 384 * 4),
-                       width);
+  vdp_renderline_rgb32(line, (uint32 *)(gen_ui->newscreen + line * 384 * 4),
+                       uiplot_palcache, width,
+                       ((gen_ctx_vdp_reg()[12] >> 1) & 3) == 3
+                           ? gen_ctx_vdp_oddframe()
+                           : 0);
 }
 
 /* End of field callback - called after each frame completes */
@@ -2193,6 +2328,7 @@ static void gtk4_cb_end_field(gen_context_t *ctx)
   static int counter = 0;
 
   if (gen_ui->plotfield) {
+    ui_plotlogged();
     ui_rendertoscreen();
   }
 
@@ -2277,8 +2413,9 @@ static gpointer ui_emu_thread_func(gpointer data)
   GenUI *ui = (GenUI *)data;
 
   /* Frame timing for autonomous operation during UI blocking (e.g., resize)
-   * NTSC: ~16.7ms, PAL: ~20ms. Use 18ms as safe middle ground. */
-  const gint64 FRAME_TIMEOUT_US = 18000;
+   * Three NTSC fields: longer than the tick callback ever leaves between
+   * requests, so fields it times are never doubled up by the timeout. */
+  const gint64 FRAME_TIMEOUT_US = 50000;
 
   while (ui->emu_thread_running) {
     g_mutex_lock(&ui->emu_mutex);
@@ -2286,13 +2423,13 @@ static gpointer ui_emu_thread_func(gpointer data)
     /* Use timed wait instead of indefinite wait to prevent audio starvation
      * when the main thread is blocked (e.g., during fullscreen resize).
      * If timeout expires, we run a frame anyway to keep audio flowing. */
-    gboolean frame_was_requested = ui->frame_requested;
+    gboolean frame_was_requested = ui->frames_requested > 0;
 
     if (!frame_was_requested && ui->emu_thread_running) {
       gint64 end_time = g_get_monotonic_time() + FRAME_TIMEOUT_US;
       /* Wait for signal OR timeout */
       g_cond_wait_until(&ui->emu_cond, &ui->emu_mutex, end_time);
-      frame_was_requested = ui->frame_requested;
+      frame_was_requested = ui->frames_requested > 0;
     }
 
     if (!ui->emu_thread_running) {
@@ -2300,7 +2437,8 @@ static gpointer ui_emu_thread_func(gpointer data)
       break;
     }
 
-    ui->frame_requested = FALSE;
+    if (frame_was_requested)
+      ui->frames_requested--;
     g_mutex_unlock(&ui->emu_mutex);
 
     /* Run frame if:
@@ -2315,6 +2453,7 @@ static gpointer ui_emu_thread_func(gpointer data)
 
       /* Run frame if requested, or if audio buffer is getting low */
       if (frame_was_requested || pending < threshold * 2) {
+        ui_newframe(pending);
         gen_core_run_frame(ui->ctx);
       }
     }
@@ -2332,8 +2471,9 @@ static void ui_start_emu_thread(void)
   g_cond_init(&gen_ui->emu_cond);
 
   gen_ui->emu_thread_running = TRUE;
-  gen_ui->frame_requested = FALSE;
+  gen_ui->frames_requested = 0;
   atomic_store(&gen_ui->render_complete, 0);
+  atomic_store(&gen_ui->fps, -1);
 
   gen_ui->emu_thread = g_thread_new("generator-emu", ui_emu_thread_func, gen_ui);
   fprintf(stderr, "Emulation thread started\n");
@@ -11,6 +11,7 @@
 #include "gen_core.h"
 #include "gen_ui_callbacks.h"
 #include "generator.h"
+#include "gensound.h"
 
 /* Version info */
 #ifndef VERSION
@@ -29,6 +30,7 @@ static struct option long_options[] = {
   {"quiet",      no_argument,       0, 'q'},
   {"load-state", required_argument, 0, 'l'},
   {"save-state", required_argument, 0, 's'},
+  {"sound-thread", no_argument,     0, 't'},
   {0, 0, 0, 0}
 };
 
@@ -45,6 +47,7 @@ static void print_usage(const char *progname)
   printf("  -f, --frames N      Run N frames (default: %d)\n", DEFAULT_FRAMES);
   printf("  -l, --load-state F  Load state from file before running\n");
   printf("  -s, --save-state F  Save state to file after running\n");
+  printf("  -t, --sound-thread  Run Z80 and sound chips on a second thread\n");
   printf("  -V, --verbose       Enable verbose output\n");
   printf("  -q, --quiet         Suppress all output except errors\n");
   printf("\n");
@@ -119,7 +122,7 @@ int main(int argc, char *argv[])
   double elapsed;
 
   /* Parse command line options */
-  while ((opt = getopt_long(argc, argv, "hvf:Vql:s:", long_options, nullptr)) != -1) {
+  while ((opt = getopt_long(argc, argv, "hvf:Vql:s:t", long_options, nullptr)) != -1) {
     switch (opt) {
     case 'h':
       print_usage(argv[0]);
@@ -140,6 +143,9 @@ int main(int argc, char *argv[])
     case 's':
       save_state_file = optarg;
       break;
+    case 't':
+      sound_threaded = 1;
+      break;
     case 'V':
       verbose_mode = 1;
       break;
@@ -4,8 +4,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "generator.h"
 #include "vdp.h"
+#include "simd.h"
 
 #include "uiplot.h"
 #include "xbrz_wrapper.h" /* xBRZ high-quality upscaling */
@@ -19,6 +21,30 @@ static uint32 uiplot_redmask;
 static uint32 uiplot_greenmask;
 static uint32 uiplot_bluemask;
 
+/* kernels for this cpu, picked by uiplot_select on first use */
+typedef void t_uiplot_palmap16(uint16 *outdata, const uint8 *indata,
+                               unsigned int pixels);
+typedef void t_uiplot_palmap32(uint32 *outdata, const uint8 *indata,
+                               unsigned int pixels);
+typedef void t_uiplot_scale2x(const uint32 *n, const uint32 *c,
+                              const uint32 *s, uint32 *out1, uint32 *out2,
+                              unsigned int width);
+typedef void t_uiplot_scale3x(const uint32 *n, const uint32 *c,
+                              const uint32 *s, uint32 *out1, uint32 *out2,
+                              uint32 *out3, unsigned int width);
+
+static t_uiplot_palmap16 uiplot_palmap16_scalar;
+static t_uiplot_palmap32 uiplot_palmap32_scalar;
+static t_uiplot_scale2x uiplot_scale2x_scalar;
+static t_uiplot_scale3x uiplot_scale3x_scalar;
+static void uiplot_select(void);
+
+static unsigned int uiplot_selected;
+static t_uiplot_palmap16 *uiplot_palmap16 = uiplot_palmap16_scalar;
+static t_uiplot_palmap32 *uiplot_palmap32 = uiplot_palmap32_scalar;
+static t_uiplot_scale2x *uiplot_scale2x_row = uiplot_scale2x_scalar;
+static t_uiplot_scale3x *uiplot_scale3x_row = uiplot_scale3x_scalar;
+
 void uiplot_setshifts(int redshift, int greenshift, int blueshift)
 {
   uiplot_redshift = redshift;
@@ -33,18 +59,12 @@ void uiplot_setmasks(uint32 redmask, uint32 greenmask, uint32 bluemask)
   uiplot_bluemask = bluemask;
 }
 
-/* uiplot_checkpalcache goes through the CRAM memory in the Genesis and
-   converts it to the uiplot_palcache table.  The Genesis has 64 colours,
-   but we store three versions of the colour table into uiplot_palcache - a
-   normal, hilighted and dim version.  The vdp_cramf buffer has 64
-   entries and is set to 1 when the game writes to CRAM, this means this
-   code skips entries that have not changed, unless 'flag' is set to 1 in
-   which case this updates all entries regardless. */
+/*** uiplot_palentry - convert one CRAM entry into uiplot_palcache ***/
 
-void uiplot_checkpalcache(int flag)
+/* col = colour number (0-63), p = its two-byte CRAM entry */
+
+static void uiplot_palentry(unsigned int col, const uint8 *p)
 {
-  unsigned int col;
-  uint8 *p;
   uint8 r, g, b;
   uint8 r8, g8, b8;
 
@@ -53,127 +73,219 @@ void uiplot_checkpalcache(int flag)
      when we do a dim or bright colour, i.e. this code works with 12bpp
      upwards */
 
+  /* Extract 3-bit Genesis colors (values 0-14)
+     Genesis CRAM format (16-bit big-endian word): 0000_BBB0_GGG0_RRR0
+     Bit layout: [15-12: 0000] [11-9: Blue] [8: 0] [7-5: Green] [4: 0] [3-1:
+     Red] [0: 0]
+
+     IMPORTANT: vdp_cram is stored in NATIVE byte order (not swapped to
+     little-endian) So on x86 (little-endian), when we read as bytes: p[0] =
+     high byte (bits 15-8) = 0000_BBB0  ← Blue is here! p[1] = low byte  (bits
+     7-0)  = GGG0_RRR0  ← Red & Green are here!
+
+     Therefore:
+       Red:   bits 3-1 of p[1]
+       Green: bits 7-5 of p[1]
+       Blue:  bits 3-1 of p[0] */
+  r = (p[1] & 0x0E); /* Red:   bits 3-1 of p[1] → mask 0x0E */
+  g = (p[1] & 0xE0) >>
+      4;             /* Green: bits 7-5 of p[1] → mask 0xE0, shift right 4 */
+  b = (p[0] & 0x0E); /* Blue:  bits 3-1 of p[0] → mask 0x0E */
+
+  /* Expand 3-bit to 8-bit: (value << 4) | (value >> 1)
+     Maps: 0→0, 2→36, 4→73, 6→109, 8→146, 10→182, 12→219, 14→255 */
+  b8 = (b << 4) | (b >> 1);
+  r8 = (r << 4) | (r >> 1);
+  g8 = (g << 4) | (g >> 1);
+
+  /* Normal brightness
+     For 16-bit formats: need 5 bits for R/B (shift 8-bit down by 3)
+     For RGB888: all stay at 8 bits (no shift needed)
+
+     We detect the format by checking the green mask to distinguish RGB565 vs
+     RGB555:
+       - greenmask == 0x07E0: RGB565 or BGR565 (green has 6 bits)
+       - greenmask == 0x03E0: RGB555 or BGR555 (green has 5 bits)
+       - Otherwise: 24/32-bit format
+  */
+  int green_bits;
+  if (uiplot_greenmask == 0x07E0) {
+    green_bits = 6; /* RGB565/BGR565 */
+  } else if (uiplot_greenmask == 0x03E0) {
+    green_bits = 5; /* RGB555/BGR555 */
+  } else {
+    green_bits = 8; /* RGB888/RGBA8888 */
+  }
+
+  if (green_bits < 8) {
+    /* 16-bit format - scale down to 5 or 6 bits */
+    int green_shift_amount = 8 - green_bits; /* 2 for 6-bit, 3 for 5-bit */
+
+    uiplot_palcache[col] =
+        ((b8 >> 3) << uiplot_blueshift) | /* 8-bit to 5-bit blue */
+        ((r8 >> 3) << uiplot_redshift) |  /* 8-bit to 5-bit red */
+        ((g8 >> green_shift_amount)
+         << uiplot_greenshift); /* 8-bit to 5 or 6-bit green */
+
+    /* Highlight (add 16 to each 8-bit component, then scale down, saturated)
+     */
+    uiplot_palcache[col + 64] =
+        (((b8 + 16 > 255 ? 255 : b8 + 16) >> 3) << uiplot_blueshift) |
+        (((r8 + 16 > 255 ? 255 : r8 + 16) >> 3) << uiplot_redshift) |
+        (((g8 + 16 > 255 ? 255 : g8 + 16) >> green_shift_amount)
+         << uiplot_greenshift);
+
+    /* Shadow (divide by 2, then scale down) */
+    uiplot_palcache[col + 128] =
+        (((b8 >> 1) >> 3) << uiplot_blueshift) |
+        (((r8 >> 1) >> 3) << uiplot_redshift) |
+        (((g8 >> 1) >> green_shift_amount) << uiplot_greenshift);
+  } else {
+    /* Higher bit depth (24/32-bit) - use full 8-bit values */
+    uiplot_palcache[col] = (b8 << uiplot_blueshift) |
+                           (r8 << uiplot_redshift) |
+                           (g8 << uiplot_greenshift);
+
+    /* Highlight (add 16 to each component, saturated) */
+    uiplot_palcache[col + 64] =
+        ((b8 + 16 > 255 ? 255 : b8 + 16) << uiplot_blueshift) |
+        ((r8 + 16 > 255 ? 255 : r8 + 16) << uiplot_redshift) |
+        ((g8 + 16 > 255 ? 255 : g8 + 16) << uiplot_greenshift);
+
+    /* Shadow (divide by 2) */
+    uiplot_palcache[col + 128] = ((b8 >> 1) << uiplot_blueshift) |
+                                 ((r8 >> 1) << uiplot_redshift) |
+                                 ((g8 >> 1) << uiplot_greenshift);
+  }
+}
+
+/* uiplot_checkpalcache goes through the CRAM memory in the Genesis and
+   converts it to the uiplot_palcache table.  The Genesis has 64 colours,
+   but we store three versions of the colour table into uiplot_palcache - a
+   normal, hilighted and dim version.  The vdp_cramf buffer has 64
+   entries and is set to 1 when the game writes to CRAM, with the entries
+   set listed in vdp_cramchanged, this means this code only converts the
+   entries written since it was last called, unless 'flag' is set to 1 in
+   which case this updates all entries regardless. */
+
+void uiplot_checkpalcache(int flag)
+{
+  unsigned int col, i;
+
   /* the flag forces it to do the update despite the vdp_cramf buffer */
 
-  for (col = 0; col < 64; col++) { /* the CRAM has 64 colours */
-    if (!flag && !vdp_cramf[col])
-      continue;
-    vdp_cramf[col] = 0;
-    p = (uint8 *)vdp_cram + 2 * col; /* point p to the two-byte CRAM entry */
-
-    /* Extract 3-bit Genesis colors (values 0-14)
-       Genesis CRAM format (16-bit big-endian word): 0000_BBB0_GGG0_RRR0
-       Bit layout: [15-12: 0000] [11-9: Blue] [8: 0] [7-5: Green] [4: 0] [3-1:
-       Red] [0: 0]
-
-       IMPORTANT: vdp_cram is stored in NATIVE byte order (not swapped to
-       little-endian) So on x86 (little-endian), when we read as bytes: p[0] =
-       high byte (bits 15-8) = 0000_BBB0  ← Blue is here! p[1] = low byte  (bits
-       7-0)  = GGG0_RRR0  ← Red & Green are here!
-
-       Therefore:
-         Red:   bits 3-1 of p[1]
-         Green: bits 7-5 of p[1]
-         Blue:  bits 3-1 of p[0] */
-    r = (p[1] & 0x0E); /* Red:   bits 3-1 of p[1] → mask 0x0E */
-    g = (p[1] & 0xE0) >>
-        4;             /* Green: bits 7-5 of p[1] → mask 0xE0, shift right 4 */
-    b = (p[0] & 0x0E); /* Blue:  bits 3-1 of p[0] → mask 0x0E */
-
-    /* Expand 3-bit to 8-bit: (value << 4) | (value >> 1)
-       Maps: 0→0, 2→36, 4→73, 6→109, 8→146, 10→182, 12→219, 14→255 */
-    b8 = (b << 4) | (b >> 1);
-    r8 = (r << 4) | (r >> 1);
-    g8 = (g << 4) | (g >> 1);
-
-    /* Normal brightness
-       For 16-bit formats: need 5 bits for R/B (shift 8-bit down by 3)
-       For RGB888: all stay at 8 bits (no shift needed)
-
-       We detect the format by checking the green mask to distinguish RGB565 vs
-       RGB555:
-         - greenmask == 0x07E0: RGB565 or BGR565 (green has 6 bits)
-         - greenmask == 0x03E0: RGB555 or BGR555 (green has 5 bits)
-         - Otherwise: 24/32-bit format
-    */
-    int green_bits;
-    if (uiplot_greenmask == 0x07E0) {
-      green_bits = 6; /* RGB565/BGR565 */
-    } else if (uiplot_greenmask == 0x03E0) {
-      green_bits = 5; /* RGB555/BGR555 */
-    } else {
-      green_bits = 8; /* RGB888/RGBA8888 */
+  if (flag) {
+    for (col = 0; col < 64; col++) { /* the CRAM has 64 colours */
+      vdp_cramf[col] = 0;
+      /* point at the two-byte CRAM entry */
+      uiplot_palentry(col, vdp_cram + 2 * col);
     }
-
-    if (green_bits < 8) {
-      /* 16-bit format - scale down to 5 or 6 bits */
-      int green_shift_amount = 8 - green_bits; /* 2 for 6-bit, 3 for 5-bit */
-
-      uiplot_palcache[col] =
-          ((b8 >> 3) << uiplot_blueshift) | /* 8-bit to 5-bit blue */
-          ((r8 >> 3) << uiplot_redshift) |  /* 8-bit to 5-bit red */
-          ((g8 >> green_shift_amount)
-           << uiplot_greenshift); /* 8-bit to 5 or 6-bit green */
-
-      /* Highlight (add 16 to each 8-bit component, then scale down, saturated)
-       */
-      uiplot_palcache[col + 64] =
-          (((b8 + 16 > 255 ? 255 : b8 + 16) >> 3) << uiplot_blueshift) |
-          (((r8 + 16 > 255 ? 255 : r8 + 16) >> 3) << uiplot_redshift) |
-          (((g8 + 16 > 255 ? 255 : g8 + 16) >> green_shift_amount)
-           << uiplot_greenshift);
-
-      /* Shadow (divide by 2, then scale down) */
-      uiplot_palcache[col + 128] =
-          (((b8 >> 1) >> 3) << uiplot_blueshift) |
-          (((r8 >> 1) >> 3) << uiplot_redshift) |
-          (((g8 >> 1) >> green_shift_amount) << uiplot_greenshift);
-    } else {
-      /* Higher bit depth (24/32-bit) - use full 8-bit values */
-      uiplot_palcache[col] = (b8 << uiplot_blueshift) |
-                             (r8 << uiplot_redshift) |
-                             (g8 << uiplot_greenshift);
-
-      /* Highlight (add 16 to each component, saturated) */
-      uiplot_palcache[col + 64] =
-          ((b8 + 16 > 255 ? 255 : b8 + 16) << uiplot_blueshift) |
-          ((r8 + 16 > 255 ? 255 : r8 + 16) << uiplot_redshift) |
-          ((g8 + 16 > 255 ? 255 : g8 + 16) << uiplot_greenshift);
-
-      /* Shadow (divide by 2) */
-      uiplot_palcache[col + 128] = ((b8 >> 1) << uiplot_blueshift) |
-                                   ((r8 >> 1) << uiplot_redshift) |
-                                   ((g8 >> 1) << uiplot_greenshift);
+  } else {
+    for (i = 0; i < vdp_cramchanges; i++) {
+      col = vdp_cramchanged[i];
+      vdp_cramf[col] = 0;
+      uiplot_palentry(col, vdp_cram + 2 * col);
     }
   }
+  vdp_cramchanges = 0;
 }
 
+/*** uiplot_loadpalcache - convert all of a saved copy of CRAM ***/
+
+/* used for lines rendered from the VDP line log, which carry the CRAM
+   contents from when they were logged; vdp_cramf is left alone */
+
+void uiplot_loadpalcache(const uint8 *cram)
+{
+  unsigned int col;
+
+  for (col = 0; col < 64; col++)
+    uiplot_palentry(col, cram + 2 * col);
+}
+
+/*** uiplot_palmap - genesis data through uiplot_palcache ***/
+
+/* The scalar versions are the reference.  With AVX2 eight entries at a
+   time are fetched with a gather, and for 16 bit colour two registers of
+   those are packed down into one - the entries fit in 16 bits, so the
+   saturating pack leaves them alone.  SSE2 and NEON have no lookup that
+   reaches across 192 entries (a byte shuffle covers 16), so without AVX2
+   the scalar loop is as good as it gets. */
+
+static void uiplot_palmap16_scalar(uint16 *outdata, const uint8 *indata,
+                                   unsigned int pixels)
+{
+  unsigned int i;
+
+  for (i = 0; i < pixels; i++)
+    outdata[i] = uiplot_palcache[indata[i]];
+}
+
+static void uiplot_palmap32_scalar(uint32 *outdata, const uint8 *indata,
+                                   unsigned int pixels)
+{
+  unsigned int i;
+
+  for (i = 0; i < pixels; i++)
+    outdata[i] = uiplot_palcache[indata[i]];
+}
+
+#if SIMD_HAVE_AVX2
+
+static SIMD_AVX2 void uiplot_palmap16_avx2(uint16 *outdata,
+                                           const uint8 *indata,
+                                           unsigned int pixels)
+{
+  unsigned int i;
+  __m256i lo, hi;
+
+  for (i = 0; i + 16 <= pixels; i += 16) {
+    lo = _mm256_i32gather_epi32(
+        (const int *)uiplot_palcache,
+        _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(indata + i))),
+        4);
+    hi = _mm256_i32gather_epi32(
+        (const int *)uiplot_palcache,
+        _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((const __m128i *)(indata + i + 8))),
+        4);
+    /* the pack works within each 128 bit half, put the quarters back in
+       order afterwards */
+    _mm256_storeu_si256(
+        (__m256i *)(outdata + i),
+        _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xd8));
+  }
+  uiplot_palmap16_scalar(outdata + i, indata + i, pixels - i);
+}
+
+static SIMD_AVX2 void uiplot_palmap32_avx2(uint32 *outdata,
+                                           const uint8 *indata,
+                                           unsigned int pixels)
+{
+  unsigned int i;
+
+  for (i = 0; i + 8 <= pixels; i += 8) {
+    _mm256_storeu_si256(
+        (__m256i *)(outdata + i),
+        _mm256_i32gather_epi32((const int *)uiplot_palcache,
+                               _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+                                   (const __m128i *)(indata + i))),
+                               4));
+  }
+  uiplot_palmap32_scalar(outdata + i, indata + i, pixels - i);
+}
+
+#endif
+
 /*** uiplot_convertdata - convert genesis data to 16 bit colour */
 
 /* must call uiplot_checkpalcache first */
 
 void uiplot_convertdata16(uint8 *indata, uint16 *outdata, unsigned int pixels)
 {
-  unsigned int ui;
-  uint32 outdata1;
-  uint32 outdata2;
-  uint32 indata_val;
-
-  /* not scaled, 16bpp - we do 4 pixels at a time */
-  for (ui = 0; ui < (pixels >> 2); ui++) {
-    indata_val = ((uint32 *)indata)[ui]; /* 4 bytes of in data */
-    outdata1 = (uiplot_palcache[indata_val & 0xff] |
-                uiplot_palcache[(indata_val >> 8) & 0xff] << 16);
-    outdata2 = (uiplot_palcache[(indata_val >> 16) & 0xff] |
-                uiplot_palcache[(indata_val >> 24) & 0xff] << 16);
-#ifdef WORDS_BIGENDIAN
-    ((uint32 *)outdata)[(ui << 1)] = outdata2;
-    ((uint32 *)outdata)[(ui << 1) + 1] = outdata1;
-#else
-    ((uint32 *)outdata)[(ui << 1)] = outdata1;
-    ((uint32 *)outdata)[(ui << 1) + 1] = outdata2;
-#endif
-  }
+  if (!uiplot_selected)
+    uiplot_select();
+  uiplot_palmap16(outdata, indata, pixels);
 }
 
 /*** uiplot_convertdata - convert genesis data to 32 bit colour ***/
@@ -182,32 +294,43 @@ void uiplot_convertdata16(uint8 *indata, uint16 *outdata, unsigned int pixels)
 
 void uiplot_convertdata32(uint8 *indata, uint32 *outdata, unsigned int pixels)
 {
-  unsigned int ui;
-  uint32 outdata1;
-  uint32 outdata2;
-  uint32 outdata3;
-  uint32 outdata4;
-  uint32 indata_val;
-
-  /* not scaled, 32bpp - we do 4 pixels at a time */
-  for (ui = 0; ui < pixels >> 2; ui++) {
-    indata_val = ((uint32 *)indata)[ui]; /* 4 bytes of in data */
-    outdata1 = uiplot_palcache[indata_val & 0xff];
-    outdata2 = uiplot_palcache[(indata_val >> 8) & 0xff];
-    outdata3 = uiplot_palcache[(indata_val >> 16) & 0xff];
-    outdata4 = uiplot_palcache[(indata_val >> 24) & 0xff];
-#ifdef WORDS_BIGENDIAN
-    ((uint32 *)outdata)[(ui << 2)] = outdata4;
-    ((uint32 *)outdata)[(ui << 2) + 1] = outdata3;
-    ((uint32 *)outdata)[(ui << 2) + 2] = outdata2;
-    ((uint32 *)outdata)[(ui << 2) + 3] = outdata1;
-#else
-    ((uint32 *)outdata)[(ui << 2)] = outdata1;
-    ((uint32 *)outdata)[(ui << 2) + 1] = outdata2;
-    ((uint32 *)outdata)[(ui << 2) + 2] = outdata3;
-    ((uint32 *)outdata)[(ui << 2) + 3] = outdata4;
-#endif
-  }
+  if (!uiplot_selected)
+    uiplot_select();
+  uiplot_palmap32(outdata, indata, pixels);
+}
+
+/*** uiplot_convertframe - convert lines of genesis data, 16 bit colour ***/
+
+/* pitches are in bytes, must call uiplot_checkpalcache first */
+
+void uiplot_convertframe16(uint8 *indata, unsigned int inpitch,
+                           uint16 *outdata, unsigned int outpitch,
+                           unsigned int pixels, unsigned int lines)
+{
+  unsigned int line;
+
+  if (!uiplot_selected)
+    uiplot_select();
+  for (line = 0; line < lines; line++)
+    uiplot_palmap16((uint16 *)((uint8 *)outdata + line * outpitch),
+                    indata + line * inpitch, pixels);
+}
+
+/*** uiplot_convertframe - convert lines of genesis data, 32 bit colour ***/
+
+/* pitches are in bytes, must call uiplot_checkpalcache first */
+
+void uiplot_convertframe32(uint8 *indata, unsigned int inpitch,
+                           uint32 *outdata, unsigned int outpitch,
+                           unsigned int pixels, unsigned int lines)
+{
+  unsigned int line;
+
+  if (!uiplot_selected)
+    uiplot_select();
+  for (line = 0; line < lines; line++)
+    uiplot_palmap32((uint32 *)((uint8 *)outdata + line * outpitch),
+                    indata + line * inpitch, pixels);
 }
 
 /*** uiplot_render16_x1 - copy to screen with delta changes (16 bit) ***/
@@ -450,44 +573,300 @@ void uiplot_irender32_weavefilter(uint32 *evendata, uint32 *odddata,
    This preserves diagonal edges while smoothing jaggy lines.
 */
 
+/* The kernels work a row at a time from the source rows above (n), at (c)
+   and below (s) - the caller passes c for n or s at the top or bottom of
+   the frame, which gives the same result as the C substitution above.  The
+   scalar versions are the reference; the vector ones do the compares and
+   selects for a whole register of pixels at once and must match them
+   pixel for pixel.  Only the first and last pixels of a row, whose W or E
+   neighbour is C itself, and whatever doesn't fill a register are left to
+   the scalar code. */
+
+/*** uiplot_scale2x_span - Scale2x pixels x0 to x1 - 1 of a row ***/
+
+static void uiplot_scale2x_span(const uint32 *n, const uint32 *c,
+                                const uint32 *s, uint32 *out1, uint32 *out2,
+                                unsigned int width, unsigned int x0,
+                                unsigned int x1)
+{
+  unsigned int x;
+  uint32 N, S, E, W, C;
+
+  for (x = x0; x < x1; x++) {
+    C = c[x];
+    N = n[x];
+    S = s[x];
+    W = (x > 0) ? c[x - 1] : C;
+    E = (x < width - 1) ? c[x + 1] : C;
+
+    /* Apply Scale2x rules */
+    out1[x * 2] = (W == N && W != S && W != E) ? W : C;
+    out1[x * 2 + 1] = (N == E && N != W && N != S) ? N : C;
+    out2[x * 2] = (W == S && W != N && W != E) ? W : C;
+    out2[x * 2 + 1] = (S == E && S != W && S != N) ? S : C;
+  }
+}
+
+/*** uiplot_scale3x_span - Scale3x pixels x0 to x1 - 1 of a row ***/
+
+static void uiplot_scale3x_span(const uint32 *n, const uint32 *c,
+                                const uint32 *s, uint32 *out1, uint32 *out2,
+                                uint32 *out3, unsigned int width,
+                                unsigned int x0, unsigned int x1)
+{
+  unsigned int x;
+  uint32 B, D, E, F, H;
+
+  for (x = x0; x < x1; x++) {
+    /* The corners of the 3x3 neighbourhood don't take part:
+         . B .
+         D E F
+         . H .
+    */
+    E = c[x];
+    B = n[x];
+    H = s[x];
+    D = (x > 0) ? c[x - 1] : E;
+    F = (x < width - 1) ? c[x + 1] : E;
+
+    /* Apply Scale3x rules (simplified)
+       E0 E1 E2
+       E3 E4 E5
+       E6 E7 E8
+    */
+    out1[x * 3] = (D == B && D != H && D != F) ? D : E;
+    out1[x * 3 + 1] =
+        ((D == B && D != H && D != F) || (B == F && B != D && B != H)) ? B : E;
+    out1[x * 3 + 2] = (B == F && B != D && B != H) ? F : E;
+    out2[x * 3] =
+        ((D == B && D != H && D != F) || (D == H && D != B && D != F)) ? D : E;
+    out2[x * 3 + 1] = E;
+    out2[x * 3 + 2] =
+        ((B == F && B != D && B != H) || (F == H && F != B && F != D)) ? F : E;
+    out3[x * 3] = (D == H && D != B && D != F) ? D : E;
+    out3[x * 3 + 1] =
+        ((D == H && D != B && D != F) || (H == F && H != D && H != B)) ? H : E;
+    out3[x * 3 + 2] = (H == F && H != D && H != B) ? F : E;
+  }
+}
+
+static void uiplot_scale2x_scalar(const uint32 *n, const uint32 *c,
+                                  const uint32 *s, uint32 *out1, uint32 *out2,
+                                  unsigned int width)
+{
+  uiplot_scale2x_span(n, c, s, out1, out2, width, 0, width);
+}
+
+static void uiplot_scale3x_scalar(const uint32 *n, const uint32 *c,
+                                  const uint32 *s, uint32 *out1, uint32 *out2,
+                                  uint32 *out3, unsigned int width)
+{
+  uiplot_scale3x_span(n, c, s, out1, out2, out3, width, 0, width);
+}
+
+#if SIMD_VECTORS
+
+/* Interleaving lanes back into output order: ZIP2 takes the first (LO) or
+   second (HI) halves of a and b alternately, ZIP3 builds output register 0,
+   1 or 2 of a0 b0 c0 a1 b1 c1 ... in two steps, a and b then c */
+
+#define UIPLOT_ZIP2LO_4(a, b) __builtin_shufflevector(a, b, 0, 4, 1, 5)
+#define UIPLOT_ZIP2HI_4(a, b) __builtin_shufflevector(a, b, 2, 6, 3, 7)
+#define UIPLOT_ZIP3_0_4(a, b, c)                                              \
+  __builtin_shufflevector(__builtin_shufflevector(a, b, 0, 4, 0, 1), c, 0, 1, \
+                          4, 3)
+#define UIPLOT_ZIP3_1_4(a, b, c)                                              \
+  __builtin_shufflevector(__builtin_shufflevector(a, b, 5, 0, 2, 6), c, 0, 5, \
+                          2, 3)
+#define UIPLOT_ZIP3_2_4(a, b, c)                                              \
+  __builtin_shufflevector(__builtin_shufflevector(a, b, 0, 3, 7, 0), c, 6, 1, \
+                          2, 7)
+
+#define UIPLOT_ZIP2LO_8(a, b)                                                 \
+  __builtin_shufflevector(a, b, 0, 8, 1, 9, 2, 10, 3, 11)
+#define UIPLOT_ZIP2HI_8(a, b)                                                 \
+  __builtin_shufflevector(a, b, 4, 12, 5, 13, 6, 14, 7, 15)
+#define UIPLOT_ZIP3_0_8(a, b, c)                                              \
+  __builtin_shufflevector(                                                    \
+      __builtin_shufflevector(a, b, 0, 8, 0, 1, 9, 0, 2, 10), c, 0, 1, 8, 3,  \
+      4, 9, 6, 7)
+#define UIPLOT_ZIP3_1_8(a, b, c)                                              \
+  __builtin_shufflevector(                                                    \
+      __builtin_shufflevector(a, b, 0, 3, 11, 0, 4, 12, 0, 5), c, 10, 1, 2,   \
+      11, 4, 5, 12, 7)
+#define UIPLOT_ZIP3_2_8(a, b, c)                                              \
+  __builtin_shufflevector(                                                    \
+      __builtin_shufflevector(a, b, 13, 0, 6, 14, 0, 7, 15, 0), c, 0, 13, 2,  \
+      3, 14, 5, 6, 15)
+
+#define UIPLOT_SCALE2X(V, L)                                                  \
+  {                                                                           \
+    const unsigned int lanes = sizeof(V) / 4;                                 \
+    unsigned int x;                                                           \
+                                                                              \
+    uiplot_scale2x_span(n, c, s, out1, out2, width, 0, 1);                    \
+    for (x = 1; x + lanes < width; x += lanes) {                              \
+      V vn, vs, vc, vw, ve, e0, e1, e2, e3, o;                                \
+                                                                              \
+      memcpy(&vn, n + x, sizeof(V));                                          \
+      memcpy(&vs, s + x, sizeof(V));                                          \
+      memcpy(&vc, c + x, sizeof(V));                                          \
+      memcpy(&vw, c + x - 1, sizeof(V));                                      \
+      memcpy(&ve, c + x + 1, sizeof(V));                                      \
+      e0 = simd_select((V)(vw == vn) & (V)(vw != vs) & (V)(vw != ve), vw,     \
+                       vc);                                                   \
+      e1 = simd_select((V)(vn == ve) & (V)(vn != vw) & (V)(vn != vs), vn,     \
+                       vc);                                                   \
+      e2 = simd_select((V)(vw == vs) & (V)(vw != vn) & (V)(vw != ve), vw,     \
+                       vc);                                                   \
+      e3 = simd_select((V)(vs == ve) & (V)(vs != vw) & (V)(vs != vn), vs,     \
+                       vc);                                                   \
+      o = UIPLOT_ZIP2LO_##L(e0, e1);                                          \
+      memcpy(out1 + x * 2, &o, sizeof(V));                                    \
+      o = UIPLOT_ZIP2HI_##L(e0, e1);                                          \
+      memcpy(out1 + x * 2 + lanes, &o, sizeof(V));                            \
+      o = UIPLOT_ZIP2LO_##L(e2, e3);                                          \
+      memcpy(out2 + x * 2, &o, sizeof(V));                                    \
+      o = UIPLOT_ZIP2HI_##L(e2, e3);                                          \
+      memcpy(out2 + x * 2 + lanes, &o, sizeof(V));                            \
+    }                                                                         \
+    uiplot_scale2x_span(n, c, s, out1, out2, width, x, width);                \
+  }
+
+#define UIPLOT_SCALE3X(V, L)                                                  \
+  {                                                                           \
+    const unsigned int lanes = sizeof(V) / 4;                                 \
+    unsigned int x;                                                           \
+                                                                              \
+    uiplot_scale3x_span(n, c, s, out1, out2, out3, width, 0, 1);              \
+    for (x = 1; x + lanes < width; x += lanes) {                              \
+      V vb, vh, ve, vd, vf, db, bf, dh, hf, e0, e1, e2, e3, e5, e6, e7, e8;   \
+      V o;                                                                    \
+                                                                              \
+      memcpy(&vb, n + x, sizeof(V));                                          \
+      memcpy(&vh, s + x, sizeof(V));                                          \
+      memcpy(&ve, c + x, sizeof(V));                                          \
+      memcpy(&vd, c + x - 1, sizeof(V));                                      \
+      memcpy(&vf, c + x + 1, sizeof(V));                                      \
+      db = (V)(vd == vb) & (V)(vd != vh) & (V)(vd != vf);                     \
+      bf = (V)(vb == vf) & (V)(vb != vd) & (V)(vb != vh);                     \
+      dh = (V)(vd == vh) & (V)(vd != vb) & (V)(vd != vf);                     \
+      hf = (V)(vh == vf) & (V)(vh != vd) & (V)(vh != vb);                     \
+      e0 = simd_select(db, vd, ve);                                           \
+      e1 = simd_select(db | bf, vb, ve);                                      \
+      e2 = simd_select(bf, vf, ve);                                           \
+      e3 = simd_select(db | dh, vd, ve);                                      \
+      e5 = simd_select(bf | hf, vf, ve);                                      \
+      e6 = simd_select(dh, vd, ve);                                           \
+      e7 = simd_select(dh | hf, vh, ve);                                      \
+      e8 = simd_select(hf, vf, ve);                                           \
+      o = UIPLOT_ZIP3_0_##L(e0, e1, e2);                                      \
+      memcpy(out1 + x * 3, &o, sizeof(V));                                    \
+      o = UIPLOT_ZIP3_1_##L(e0, e1, e2);                                      \
+      memcpy(out1 + x * 3 + lanes, &o, sizeof(V));                            \
+      o = UIPLOT_ZIP3_2_##L(e0, e1, e2);                                      \
+      memcpy(out1 + x * 3 + lanes * 2, &o, sizeof(V));                        \
+      o = UIPLOT_ZIP3_0_##L(e3, ve, e5);                                      \
+      memcpy(out2 + x * 3, &o, sizeof(V));                                    \
+      o = UIPLOT_ZIP3_1_##L(e3, ve, e5);                                      \
+      memcpy(out2 + x * 3 + lanes, &o, sizeof(V));                            \
+      o = UIPLOT_ZIP3_2_##L(e3, ve, e5);                                      \
+      memcpy(out2 + x * 3 + lanes * 2, &o, sizeof(V));                        \
+      o = UIPLOT_ZIP3_0_##L(e6, e7, e8);                                      \
+      memcpy(out3 + x * 3, &o, sizeof(V));                                    \
+      o = UIPLOT_ZIP3_1_##L(e6, e7, e8);                                      \
+      memcpy(out3 + x * 3 + lanes, &o, sizeof(V));                            \
+      o = UIPLOT_ZIP3_2_##L(e6, e7, e8);                                      \
+      memcpy(out3 + x * 3 + lanes * 2, &o, sizeof(V));                        \
+    }                                                                         \
+    uiplot_scale3x_span(n, c, s, out1, out2, out3, width, x, width);          \
+  }
+
+/*** uiplot_scale2x_vec4 - 4 pixels at a time, SSE2 or NEON ***/
+
+static void uiplot_scale2x_vec4(const uint32 *n, const uint32 *c,
+                                const uint32 *s, uint32 *out1, uint32 *out2,
+                                unsigned int width)
+UIPLOT_SCALE2X(t_simd_u32x4, 4)
+
+/*** uiplot_scale3x_vec4 - 4 pixels at a time, SSE2 or NEON ***/
+
+static void uiplot_scale3x_vec4(const uint32 *n, const uint32 *c,
+                                const uint32 *s, uint32 *out1, uint32 *out2,
+                                uint32 *out3, unsigned int width)
+UIPLOT_SCALE3X(t_simd_u32x4, 4)
+
+#if SIMD_HAVE_AVX2
+
+/*** uiplot_scale2x_avx2 - 8 pixels at a time ***/
+
+SIMD_AVX2 static void uiplot_scale2x_avx2(const uint32 *n, const uint32 *c,
+                                          const uint32 *s, uint32 *out1,
+                                          uint32 *out2, unsigned int width)
+UIPLOT_SCALE2X(t_simd_u32x8, 8)
+
+/*** uiplot_scale3x_avx2 - 8 pixels at a time ***/
+
+SIMD_AVX2 static void uiplot_scale3x_avx2(const uint32 *n, const uint32 *c,
+                                          const uint32 *s, uint32 *out1,
+                                          uint32 *out2, uint32 *out3,
+                                          unsigned int width)
+UIPLOT_SCALE3X(t_simd_u32x8, 8)
+
+#endif
+#endif
+
+/*** uiplot_select - choose the kernels for this cpu ***/
+
+static void uiplot_select(void)
+{
+  uiplot_selected = 1;
+#if SIMD_HAVE_AVX2
+  if (simd_avx2()) {
+    uiplot_palmap16 = uiplot_palmap16_avx2;
+    uiplot_palmap32 = uiplot_palmap32_avx2;
+    uiplot_scale2x_row = uiplot_scale2x_avx2;
+    uiplot_scale3x_row = uiplot_scale3x_avx2;
+    return;
+  }
+#endif
+#if SIMD_VECTORS
+  uiplot_scale2x_row = uiplot_scale2x_vec4;
+  uiplot_scale3x_row = uiplot_scale3x_vec4;
+#endif
+}
+
 /* Scale2x for full frame (32-bit) - processes entire 2D image at once
    src_pitch and dst_pitch are in bytes (stride of source/dest buffers) */
 void uiplot_scale2x_frame32(uint32 *srcdata, uint32 *dstdata,
                             unsigned int src_width, unsigned int src_height,
                             unsigned int src_pitch, unsigned int dst_pitch)
 {
-  unsigned int x, y;
-  uint32 *dst_line1, *dst_line2;
-  uint32 N, S, E, W, C;
-  uint32 E0, E1, E2, E3;
+  uiplot_scale2x_rows32(srcdata, dstdata, src_width, src_height, 0,
+                        src_height, src_pitch, dst_pitch);
+}
+
+/* Scale2x for source rows first to last - 1 of a frame, the output for
+   the rest of the frame is left alone */
+void uiplot_scale2x_rows32(uint32 *srcdata, uint32 *dstdata,
+                           unsigned int src_width, unsigned int src_height,
+                           unsigned int first, unsigned int last,
+                           unsigned int src_pitch, unsigned int dst_pitch)
+{
+  unsigned int y;
   unsigned int src_stride = src_pitch / 4; /* Convert bytes to pixels */
   unsigned int dst_stride = dst_pitch / 4;
+  const uint32 *c;
 
-  for (y = 0; y < src_height; y++) {
-    dst_line1 = dstdata + (y * 2) * dst_stride;
-    dst_line2 = dstdata + (y * 2 + 1) * dst_stride;
-
-    for (x = 0; x < src_width; x++) {
-      C = srcdata[y * src_stride + x];
-
-      /* Get neighbors (with boundary checks) */
-      N = (y > 0) ? srcdata[(y - 1) * src_stride + x] : C;
-      S = (y < src_height - 1) ? srcdata[(y + 1) * src_stride + x] : C;
-      W = (x > 0) ? srcdata[y * src_stride + (x - 1)] : C;
-      E = (x < src_width - 1) ? srcdata[y * src_stride + (x + 1)] : C;
-
-      /* Apply Scale2x rules */
-      E0 = (W == N && W != S && W != E) ? W : C;
-      E1 = (N == E && N != W && N != S) ? N : C;
-      E2 = (W == S && W != N && W != E) ? W : C;
-      E3 = (S == E && S != W && S != N) ? S : C;
-
-      /* Write 2x2 output pixels */
-      dst_line1[x * 2] = E0;
-      dst_line1[x * 2 + 1] = E1;
-      dst_line2[x * 2] = E2;
-      dst_line2[x * 2 + 1] = E3;
-    }
+  if (!uiplot_selected)
+    uiplot_select();
+
+  for (y = first; y < last; y++) {
+    c = srcdata + y * src_stride;
+    uiplot_scale2x_row(y > 0 ? c - src_stride : c, c,
+                       y < src_height - 1 ? c + src_stride : c,
+                       dstdata + (y * 2) * dst_stride,
+                       dstdata + (y * 2 + 1) * dst_stride, src_width);
   }
 }
 
@@ -496,93 +875,95 @@ void uiplot_scale3x_frame32(uint32 *srcdata, uint32 *dstdata,
                             unsigned int src_width, unsigned int src_height,
                             unsigned int src_pitch, unsigned int dst_pitch)
 {
-  unsigned int x, y;
+  uiplot_scale3x_rows32(srcdata, dstdata, src_width, src_height, 0,
+                        src_height, src_pitch, dst_pitch);
+}
+
+/* Scale3x for source rows first to last - 1 of a frame */
+void uiplot_scale3x_rows32(uint32 *srcdata, uint32 *dstdata,
+                           unsigned int src_width, unsigned int src_height,
+                           unsigned int first, unsigned int last,
+                           unsigned int src_pitch, unsigned int dst_pitch)
+{
+  unsigned int y;
   unsigned int src_stride = src_pitch / 4; /* Convert bytes to pixels */
-  uint32 *dst_line1, *dst_line2, *dst_line3;
-  uint32 A, B, C, D, E, F, G, H, I;
-  uint32 E0, E1, E2, E3, E4, E5, E6, E7, E8;
-
-  for (y = 0; y < src_height; y++) {
-    dst_line1 = dstdata + (y * 3) * (dst_pitch / 4);
-    dst_line2 = dstdata + (y * 3 + 1) * (dst_pitch / 4);
-    dst_line3 = dstdata + (y * 3 + 2) * (dst_pitch / 4);
-
-    for (x = 0; x < src_width; x++) {
-      /* Get 3x3 neighborhood:
-         A B C
-         D E F
-         G H I
-      */
-      E = srcdata[y * src_stride + x];
-
-      A = (y > 0 && x > 0) ? srcdata[(y - 1) * src_stride + (x - 1)] : E;
-      B = (y > 0) ? srcdata[(y - 1) * src_stride + x] : E;
-      C = (y > 0 && x < src_width - 1) ? srcdata[(y - 1) * src_stride + (x + 1)]
-                                       : E;
-      D = (x > 0) ? srcdata[y * src_stride + (x - 1)] : E;
-      F = (x < src_width - 1) ? srcdata[y * src_stride + (x + 1)] : E;
-      G = (y < src_height - 1 && x > 0) ? srcdata[(y + 1) * src_stride + (x - 1)]
-                                        : E;
-      H = (y < src_height - 1) ? srcdata[(y + 1) * src_stride + x] : E;
-      I = (y < src_height - 1 && x < src_width - 1)
-              ? srcdata[(y + 1) * src_stride + (x + 1)]
-              : E;
-
-      /* Apply Scale3x rules (simplified)
-         E0 E1 E2
-         E3 E4 E5
-         E6 E7 E8
-      */
-      E0 = (D == B && D != H && D != F) ? D : E;
-      E1 = ((D == B && D != H && D != F) || (B == F && B != D && B != H)) ? B
-                                                                          : E;
-      E2 = (B == F && B != D && B != H) ? F : E;
-      E3 = ((D == B && D != H && D != F) || (D == H && D != B && D != F)) ? D
-                                                                          : E;
-      E4 = E;
-      E5 = ((B == F && B != D && B != H) || (F == H && F != B && F != D)) ? F
-                                                                          : E;
-      E6 = (D == H && D != B && D != F) ? D : E;
-      E7 = ((D == H && D != B && D != F) || (H == F && H != D && H != B)) ? H
-                                                                          : E;
-      E8 = (H == F && H != D && H != B) ? F : E;
-
-      /* Write 3x3 output pixels */
-      dst_line1[x * 3] = E0;
-      dst_line1[x * 3 + 1] = E1;
-      dst_line1[x * 3 + 2] = E2;
-      dst_line2[x * 3] = E3;
-      dst_line2[x * 3 + 1] = E4;
-      dst_line2[x * 3 + 2] = E5;
-      dst_line3[x * 3] = E6;
-      dst_line3[x * 3 + 1] = E7;
-      dst_line3[x * 3 + 2] = E8;
-    }
+  unsigned int dst_stride = dst_pitch / 4;
+  const uint32 *c;
+
+  if (!uiplot_selected)
+    uiplot_select();
+
+  for (y = first; y < last; y++) {
+    c = srcdata + y * src_stride;
+    uiplot_scale3x_row(y > 0 ? c - src_stride : c, c,
+                       y < src_height - 1 ? c + src_stride : c,
+                       dstdata + (y * 3) * dst_stride,
+                       dstdata + (y * 3 + 1) * dst_stride,
+                       dstdata + (y * 3 + 2) * dst_stride, src_width);
   }
 }
 
-/* Scale4x for full frame (32-bit) - Double application of Scale2x
-   temp: Pre-allocated intermediate buffer (must be at least src_width*2 *
-   src_height*2 * 4 bytes) */
-void uiplot_scale4x_frame32(uint32 *srcdata, uint32 *dstdata, uint32 *temp,
+/* Scale4x for full frame (32-bit) - Scale2x applied twice */
+void uiplot_scale4x_frame32(uint32 *srcdata, uint32 *dstdata,
                             unsigned int src_width, unsigned int src_height,
                             unsigned int src_pitch, unsigned int dst_pitch)
 {
-  /* Scale4x = Scale2x applied twice
-     First: src -> temp (2x)
-     Second: temp -> dst (2x again = 4x total) */
-
-  unsigned int temp_width = src_width * 2;
-  unsigned int temp_height = src_height * 2;
-  unsigned int temp_pitch = temp_width * 4; /* Temp buffer is packed */
+  uiplot_scale4x_rows32(srcdata, dstdata, src_width, src_height, 0,
+                        src_height, src_pitch, dst_pitch);
+}
 
-  /* First pass: Scale2x from src to temp */
-  uiplot_scale2x_frame32(srcdata, temp, src_width, src_height, src_pitch,
-                         temp_pitch);
+/* Scale4x for source rows first to last - 1 of a frame
+
+   Scale2x applied twice, in one pass down the frame: the 2x rows of each
+   source row are made once, into a ring of three source rows' worth, just
+   before the second pass needs them - output rows 4y to 4y + 3 come from
+   2x rows 2y - 1 to 2y + 2, i.e. from source rows y - 1 to y + 1.  At the
+   top and bottom of the frame the 2x row itself stands in for the missing
+   one, just as Scale2x does with the source. */
+void uiplot_scale4x_rows32(uint32 *srcdata, uint32 *dstdata,
+                           unsigned int src_width, unsigned int src_height,
+                           unsigned int first, unsigned int last,
+                           unsigned int src_pitch, unsigned int dst_pitch)
+{
+  uint32 ring[3][2][UIPLOT_SCALE4X_MAXWIDTH * 2];
+  unsigned int src_stride = src_pitch / 4; /* Convert bytes to pixels */
+  unsigned int dst_stride = dst_pitch / 4;
+  unsigned int y, made;
+  const uint32 *above, *below;
+  uint32 *dst;
+
+  if (!uiplot_selected)
+    uiplot_select();
+
+  if (first >= last || src_width > UIPLOT_SCALE4X_MAXWIDTH)
+    return;
+
+  /* first pass for one source row, into its place in the ring */
+#define UIPLOT_SCALE4X_MAKE(row)                                              \
+  {                                                                           \
+    const uint32 *c = srcdata + (row) * src_stride;                           \
+    uiplot_scale2x_row((row) > 0 ? c - src_stride : c, c,                     \
+                       (row) < src_height - 1 ? c + src_stride : c,           \
+                       ring[(row) % 3][0], ring[(row) % 3][1], src_width);    \
+  }
 
-  /* Second pass: Scale2x from temp to dst */
-  uiplot_scale2x_frame32(temp, dstdata, temp_width, temp_height, temp_pitch,
-                         dst_pitch);
+  made = first ? first - 1 : 0;
+  UIPLOT_SCALE4X_MAKE(made);
+  for (y = first; y < last; y++) {
+    while (made < y + 1 && made < src_height - 1) {
+      made++;
+      UIPLOT_SCALE4X_MAKE(made);
+    }
+    above = y > 0 ? ring[(y - 1) % 3][1] : ring[y % 3][0];
+    below = y < src_height - 1 ? ring[(y + 1) % 3][0] : ring[y % 3][1];
+    dst = dstdata + (y * 4) * dst_stride;
+    uiplot_scale2x_row(above, ring[y % 3][0], ring[y % 3][1], dst,
+                       dst + dst_stride, src_width * 2);
+    uiplot_scale2x_row(ring[y % 3][0], ring[y % 3][1], below,
+                       dst + dst_stride * 2, dst + dst_stride * 3,
+                       src_width * 2);
+  }
+#undef UIPLOT_SCALE4X_MAKE
 }
 
 /*** xBRZ High-Quality Upscaling Algorithm ***/
@@ -607,3 +988,21 @@ void uiplot_xbrz_frame32(int factor, uint32 *srcdata, uint32 *dstdata,
   /* Call the C++ xBRZ library through our C wrapper */
   xbrz_scale(factor, srcdata, dstdata, src_width, src_height);
 }
+
+/* Threads sharing each xBRZ frame including the caller, 0 for one per core */
+void uiplot_xbrz_threads(int threads)
+{
+  xbrz_set_threads(threads);
+}
+
+/* xBRZ for source rows first to last - 1 of a frame */
+void uiplot_xbrz_rows32(int factor, uint32 *srcdata, uint32 *dstdata,
+                        unsigned int src_width, unsigned int src_height,
+                        unsigned int first, unsigned int last)
+{
+  if (factor < 2 || factor > 6 || first >= last)
+    return;
+
+  xbrz_scale_rows(factor, srcdata, dstdata, src_width, src_height, first,
+                  last);
+}
@@ -23,6 +23,8 @@
 #include "cpu68k.h"
 #include "ui.h"
 #include "event.h"
+#include "simd.h"
+#include "vdpthread.h"
 
 #undef DEBUG_VDP
 #undef DEBUG_VDPDMA
@@ -61,6 +63,8 @@ uint8 vdp_cram[LEN_CRAM];
 uint8 vdp_vsram[LEN_VSRAM];
 uint8 vdp_vram[LEN_VRAM];
 uint8 vdp_cramf[LEN_CRAM / 2];
+uint8 vdp_cramchanged[LEN_CRAM / 2]; /* entries flagged in vdp_cramf */
+unsigned int vdp_cramchanges;        /* ... and how many there are */
 unsigned int vdp_event_start;
 unsigned int vdp_event_vint;
 unsigned int vdp_event_hint;
@@ -74,11 +78,15 @@ t_code vdp_code;    /* code number for data/dma transfers CD3-CD0 */
 uint8 vdp_ctrlflag; /* set inbetween ctrl writes */
 uint16 vdp_first;   /* first word of address set */
 uint16 vdp_second;  /* second word of address set */
+unsigned int vdp_tiles_dirtied = 0; /* tiles written to last field */
+unsigned int vdp_tiles_decoded = 0; /* tiles decoded last field */
+unsigned int vdp_renderthreads = 0; /* render threads wanted, 0 for none */
 
 /*** global variables ***/
 
 uint8 vdp_reg[25];
 static int vdp_collision;  /* set during a sprite collision */
+unsigned int vdp_spritesdone; /* sprite status found for this line */
 static int vdp_overflow;   /* set when too many sprites in one line */
 static int vdp_fifofull;   /* set when write fifo full (4 entries) */
 static int vdp_fifoempty;  /* set when write fifo empty (0 entries) */
@@ -86,6 +94,149 @@ static int vdp_fifo_count; /* number of entries in FIFO (0-4) */
 #define VDP_FIFO_SIZE 4    /* Genesis VDP has 4-entry FIFO */
 static int vdp_complex;    /* set when simple routines can't cope */
 
+/* DMA bytes transferred per line, [H40][blanked] (p36) - blanked means
+   vertical blank or display disabled */
+static const uint8 vdp_dmaslots[2][2] = {{16, 167}, {18, 205}};
+
+/* pre-decoded pattern cache - every 8x8 tile in VRAM as one byte (0-15) per
+   pixel, [0] as stored and [1] horizontally flipped.  VRAM writes mark tiles
+   dirty and the renderer decodes them again the first time it uses them */
+#define VDP_TILES (LEN_VRAM / 32)
+static uint8 vdp_tilecache[2][VDP_TILES][64];
+static uint8 vdp_tiledirty[VDP_TILES];
+static unsigned int vdp_tilecount_dirtied; /* this field */
+
+/* decoded sprite attribute table - the link list as the walk from sprite 0
+   finds it, and for each line the entries of that list which cross it in
+   list order, so vdp_sprites needn't walk the list on every line.  VRAM
+   writes inside the table make it stale and vdp_sprites decodes it again
+   the next time it is used */
+#define VDP_SATWALK 255  /* list entries walked before giving up */
+#define VDP_SATLEN 0x400 /* 128 sprites of 8 bytes */
+#define VDP_SATLINES 512 /* lines in interlace mode 2, ample otherwise */
+#define VDP_SPRLINE 21   /* most sprites on one line in any mode, plus one
+                            to see overflow */
+
+typedef struct {
+  t_spriteinfo entry[VDP_SATWALK];         /* in list order */
+  uint8 bucket[VDP_SATLINES][VDP_SPRLINE]; /* entries crossing each line */
+  uint8 count[VDP_SATLINES];
+  uint16 base;     /* VRAM address it was decoded from */
+  uint8 interlace; /* interlace mode it was decoded for */
+  uint8 valid;     /* clear when stale */
+} t_vdp_sat;
+
+static t_vdp_sat vdp_livesat;
+
+/* pre-drawn scroll planes - with full screen vertical scroll a line of
+   layer A or B is one row of its plane, wrapped at the plane's width, so
+   each plane is kept drawn out at 8bpp beside a priority bitmap.  Cells
+   are checked as lines pass over them against the name table entry they
+   were drawn from and the generation of its pattern (bumped whenever the
+   pattern is marked dirty) and drawn again where either has changed */
+#define VDP_PLANECELLS 4096 /* 64x64, 32x128 or 128x32 */
+
+typedef struct {
+  uint16 base;                       /* name table it was drawn from */
+  uint8 hwidth, vwidth;              /* in cells, 0 if never drawn */
+  uint8 valid[VDP_PLANECELLS];       /* cell has been drawn */
+  uint16 info[VDP_PLANECELLS];       /* name table entry drawn */
+  uint32 gen[VDP_PLANECELLS];        /* tilegen of its pattern then */
+  uint8 pixel[VDP_PLANECELLS * 64];  /* as vdp_newlayer's outdata */
+  uint8 pri[VDP_PLANECELLS * 64];    /* layer's PRIBIT or 0 */
+} t_vdp_plane;
+
+unsigned int vdp_planecache = 1; /* use the plane cache where possible */
+static uint32 vdp_tilegen[VDP_TILES];
+static t_vdp_plane vdp_liveplane[2];
+
+/* what the line renderer reads - the live VDP state, or a copy of it taken
+   when a line was logged (see vdp_logline) */
+typedef struct {
+  const uint8 *reg;
+  const uint8 *vsram;
+  const uint8 *vram;
+  uint8 (*tilecache)[VDP_TILES][64]; /* [2] as vdp_tilecache */
+  uint8 *tiledirty;
+  t_vdp_sat *sat;
+  uint32 *tilegen;    /* bumped when tiledirty is set */
+  t_vdp_plane *plane; /* [2] for layers A and B, or nullptr */
+  unsigned int layers; /* VDP_SHOW_* */
+  unsigned int decoded; /* tiles decoded */
+  int collision;        /* set during a sprite collision */
+  int overflow;         /* set when a line had too many sprites */
+} t_vdp_view;
+
+#define VDP_SHOW_S 1 /* vdp_layerS or vdp_layerSp */
+#define VDP_SHOW_A 2
+#define VDP_SHOW_W 4
+#define VDP_SHOW_B 8
+
+/* line log for the render threads - lines are grouped into bands of up to
+   VDP_BANDLINES, each band holding VRAM as it was when its first line was
+   logged, the VRAM words written since, and the registers and VSRAM of
+   every line.  A band is queued as soon as it is full so it renders while
+   the 68k carries on.  The band slots are allocated when the first line
+   is logged and freed when the render threads stop, as between them they
+   hold a few copies of everything.  CRAM is only needed to turn the output
+   into colours, so that is kept per field line for the UI */
+#define VDP_BANDLINES 32
+#define VDP_BANDWRITES (1 << 14) /* VRAM words logged before a band closes */
+
+typedef struct {
+  uint8 reg[25];
+  uint8 vsram[LEN_VSRAM];
+  uint8 line;
+  uint8 odd;
+  uint8 layers;  /* VDP_SHOW_* */
+  uint32 writes; /* band VRAM writes before this line */
+} t_vdp_logline;
+
+typedef struct {
+  uint8 vram[LEN_VRAM];
+  uint8 tilecache[2][VDP_TILES][64];
+  uint8 tiledirty[VDP_TILES]; /* tilecache matches vram where clear */
+  t_vdp_sat sat;
+  uint32 tilegen[VDP_TILES];
+  t_vdp_plane plane[2];
+  t_vdp_logline line[VDP_BANDLINES];
+  unsigned int lines;
+  uint32 write[VDP_BANDWRITES]; /* address << 16 | word */
+  unsigned int writes;
+} t_vdp_band;
+
+static t_vdp_band *vdp_bands;     /* [VDPTHREAD_BANDS], or nullptr */
+static t_vdp_band *vdp_logband;   /* band being logged into, if any */
+static unsigned int vdp_logbands; /* band slots used this field */
+static uint8 vdp_logout[VDP_MAXLINES][320];
+static uint8 vdp_logcram[VDP_MAXLINES][LEN_CRAM];
+static uint8 vdp_logstate[VDP_MAXLINES]; /* VDP_LOGGED_* */
+static uint8 vdp_logprevcram[LEN_CRAM];  /* CRAM of the last line logged */
+static unsigned int vdp_logfirst = 1;    /* no lines logged this field yet */
+
+/* the last output of each line, and what it was drawn with, for
+   vdp_dirty */
+t_vdp_dirty vdp_dirty[VDP_MAXLINES];
+static uint8 vdp_dirtyout[VDP_MAXLINES][320];
+static uint8 vdp_dirtycram[VDP_MAXLINES][LEN_CRAM];
+static uint16 vdp_dirtywidth[VDP_MAXLINES]; /* 0 if not known */
+static unsigned int vdp_dirtyfield[VDP_MAXLINES]; /* when last rendered */
+static unsigned int vdp_fields = 1;                /* fields so far */
+
+#define VDP_LOGGED 1      /* line logged this field */
+#define VDP_LOGGED_CRAM 2 /* ... and CRAM differs from the line before */
+#define VDP_LOGGED_H40 4  /* ... in 320 pixel mode */
+
+/* compositor for vdp_renderline, vdp_init picks the widest the cpu has */
+typedef void t_vdp_composite(uint8 *linedata, const uint8 *sprite,
+                             const uint8 *layerA, const uint8 *layerB,
+                             const uint8 *priorities, uint8 bg,
+                             unsigned int ste);
+
+/* palette lookup for vdp_renderline_rgb32 */
+typedef void t_vdp_palmap(uint32 *outdata, const uint8 *linedata,
+                          const uint32 *palette, unsigned int pixels);
+
 /*** forward references ***/
 
 void vdp_ramcopy_vram(int type);
@@ -94,21 +245,41 @@ void vdp_dma_fill(uint8 data);
 void vdp_showregs(void);
 void vdp_describe(void);
 void vdp_eventinit(void);
+static void vdp_logclose(void);
+static void vdp_logsnapshot(t_vdp_band *b);
+static t_vdp_composite vdp_composite_scalar;
+static t_vdp_palmap vdp_palmap_scalar;
+static void vdp_composite_select(void);
+static void vdp_livestatus(void);
+static void vdp_renderlive(unsigned int line, uint8 *linedata,
+                           unsigned int odd);
+static void vdp_dirtystate(unsigned int line);
+static void vdp_dirtypixels(unsigned int line, const uint8 *linedata);
 void vdp_layer_simple(unsigned int layer, unsigned int priority,
                       uint8 *fielddata, unsigned int lineoffset);
 /* C17 migration: removed 'inline' to provide external linkage */
 void vdp_plotcell(uint8 *patloc, uint8 palette, uint8 flags, uint8 *cellloc,
                   unsigned int lineoffset);
-void vdp_sprites(unsigned int line, uint8 *pridata, uint8 *outdata);
+void vdp_sprites(t_vdp_view *v, unsigned int line, uint8 *pridata,
+                 uint8 *outdata);
 int vdp_sprite_simple(unsigned int priority, uint8 *framedata,
                       unsigned int lineoffset, unsigned int number,
                       uint8 *spritelist, uint8 *sprite);
 void vdp_sprites_simple(unsigned int priority, uint8 *framedata,
                         unsigned int lineoffset);
 void vdp_shadow_simple(uint8 *framedata, unsigned int lineoffset);
-void vdp_newlayer(unsigned int line, uint8 *pridata, uint8 *outdata,
-                  unsigned int layer);
-void vdp_newwindow(unsigned int line, uint8 *pridata, uint8 *outdata);
+void vdp_newlayer(t_vdp_view *v, unsigned int line, uint8 *pridata,
+                  uint8 *outdata, unsigned int layer);
+void vdp_newwindow(t_vdp_view *v, unsigned int line, uint8 *pridata,
+                   uint8 *outdata);
+static void vdp_renderview(t_vdp_view *v, unsigned int line, uint8 *linedata,
+                           unsigned int odd);
+
+static t_vdp_composite *vdp_composite = vdp_composite_scalar;
+static t_vdp_palmap *vdp_palmap = vdp_palmap_scalar;
+static t_vdp_view vdp_live = {vdp_reg,       vdp_vsram,     vdp_vram,
+                              vdp_tilecache, vdp_tiledirty, &vdp_livesat,
+                              vdp_tilegen};
 
 #define PRIBIT_LAYERB 0
 #define PRIBIT_LAYERA 1
@@ -137,10 +308,129 @@ void vdp_fifo_drain(int count)
   vdp_fifofull = (vdp_fifo_count >= VDP_FIFO_SIZE) ? 1 : 0;
 }
 
+/*** vdp_vramstored - VRAM byte at addr has been written ***/
+
+/* marks the tile dirty, and the sprite table if addr is inside it, and
+   while lines are being logged for the render threads logs the word it is
+   in so the band's copy of VRAM can follow */
+
+static inline void vdp_vramstored(uint16 addr)
+{
+  t_vdp_band *b = vdp_logband;
+
+  if (!vdp_tiledirty[addr >> 5]) {
+    vdp_tiledirty[addr >> 5] = 1;
+    vdp_tilegen[addr >> 5]++;
+    vdp_tilecount_dirtied++;
+  }
+  if ((uint16)(addr - vdp_livesat.base) < VDP_SATLEN)
+    vdp_livesat.valid = 0;
+  if (b) {
+    addr &= 0xfffe;
+    b->write[b->writes++] = addr << 16 | vdp_vram[addr] << 8 |
+                            vdp_vram[addr + 1];
+    if (b->writes == VDP_BANDWRITES)
+      vdp_logclose();
+  }
+}
+
+/*** vdp_vramrange - VRAM bytes addr to addr + bytes - 1 have been written ***/
+
+/* vdp_vramstored for a block, which must be whole words and not wrap.  A
+   band being logged into gets the words logged if they fit, otherwise it
+   is closed and the next band takes a copy of VRAM with them in */
+
+static void vdp_vramrange(uint16 addr, unsigned int bytes)
+{
+  t_vdp_band *b = vdp_logband;
+  unsigned int a, tile, end = addr + bytes;
+
+  for (tile = addr >> 5; tile <= (end - 1) >> 5; tile++) {
+    if (!vdp_tiledirty[tile]) {
+      vdp_tiledirty[tile] = 1;
+      vdp_tilegen[tile]++;
+      vdp_tilecount_dirtied++;
+    }
+  }
+  if ((uint16)(addr - vdp_livesat.base) < VDP_SATLEN ||
+      (uint16)(vdp_livesat.base - addr) < bytes)
+    vdp_livesat.valid = 0;
+  if (b) {
+    if (b->writes + bytes / 2 > VDP_BANDWRITES) {
+      vdp_logclose();
+    } else {
+      for (a = addr; a < end; a += 2)
+        b->write[b->writes++] = a << 16 | vdp_vram[a] << 8 | vdp_vram[a + 1];
+    }
+  }
+}
+
+/*** vdp_cramstored - CRAM entry col has been written ***/
+
+/* flags it for the UI's palette conversion and lists it, so the UI only
+   looks at the entries written since it last looked */
+
+static inline void vdp_cramstored(unsigned int col)
+{
+  if (!vdp_cramf[col]) {
+    vdp_cramf[col] = 1;
+    vdp_cramchanged[vdp_cramchanges++] = col;
+  }
+}
+
+/*** vdp_tilecache_invalidate - all of VRAM has changed ***/
+
+void vdp_tilecache_invalidate(void)
+{
+  unsigned int tile;
+
+  memset(vdp_tiledirty, 1, sizeof(vdp_tiledirty));
+  for (tile = 0; tile < VDP_TILES; tile++)
+    vdp_tilegen[tile]++;
+  vdp_tilecount_dirtied += VDP_TILES;
+  vdp_livesat.valid = 0;
+  vdp_logclose(); /* the next band takes a fresh copy */
+}
+
+/*** vdp_tiledecode - unpack a tile's nibbles into the cache ***/
+
+static void vdp_tiledecode(t_vdp_view *v, unsigned int tile)
+{
+  const uint8 *src = v->vram + tile * 32;
+  uint8 *dst = v->tilecache[0][tile];
+  uint8 *flip = v->tilecache[1][tile];
+  int y, x;
+
+  for (y = 0; y < 8; y++, src += 4, dst += 8, flip += 8) {
+    for (x = 0; x < 4; x++) {
+      dst[x * 2] = flip[7 - x * 2] = src[x] >> 4;
+      dst[x * 2 + 1] = flip[6 - x * 2] = src[x] & 15;
+    }
+  }
+  v->tiledirty[tile] = 0;
+  v->decoded++;
+}
+
+/*** vdp_tilerow - decoded pixels for the pattern row at VRAM offset ***/
+
+/* offset is the address the 4bpp row would be read from, so the callers'
+   interlace and vertical flip arithmetic carries over unchanged */
+
+static inline const uint8 *vdp_tilerow(t_vdp_view *v, unsigned int offset,
+                                       unsigned int hflip)
+{
+  unsigned int tile = (offset >> 5) & (VDP_TILES - 1);
+
+  if (v->tiledirty[tile])
+    vdp_tiledecode(v, tile);
+  return v->tilecache[hflip ? 1 : 0][tile] + ((offset >> 2) & 7) * 8;
+}
+
 /*** vdp_init - initialise this sub-unit ***/
 
 int vdp_init(void)
 {
+  vdp_composite_select();
   vdp_reset();
   return 0;
 }
@@ -206,13 +496,14 @@ void vdp_reset(void)
   memset(vdp_cram, 0, LEN_CRAM);
   memset(vdp_vsram, 0, LEN_VSRAM);
   memset(vdp_vram, 0, LEN_VRAM);
+  vdp_tilecache_invalidate();
 
   /* clear CRAM */
 
   for (i = 0; i < 64; i++) {
     (vdp_cram + i * 2)[0] = (i & 7) << 1;
     (vdp_cram + i * 2)[1] = (i & 7) << 5 | (i & 7) << 1;
-    vdp_cramf[i] = 1;
+    vdp_cramstored(i);
   }
   vdp_eventinit();
   LOG_VERBOSE(
@@ -340,6 +631,73 @@ void vdp_storectrl(uint16 data)
   }
 }
 
+/*** vdp_copyswapped - copy words swapping the bytes of each ***/
+
+static void vdp_copyswapped(uint8 *dst, const uint8 *src, unsigned int words)
+{
+  unsigned int i = 0;
+#if SIMD_VECTORS
+  t_simd_u16x8 v;
+
+  for (; i + 8 <= words; i += 8) {
+    memcpy(&v, src + i * 2, sizeof(v));
+    v = v << 8 | v >> 8;
+    memcpy(dst + i * 2, &v, sizeof(v));
+  }
+#endif
+  for (; i < words; i++) {
+    dst[i * 2] = src[i * 2 + 1];
+    dst[i * 2 + 1] = src[i * 2];
+  }
+}
+
+/*** vdp_ramcopy_bulk - 68k memory to VRAM, CRAM or VSRAM, increment 2 ***/
+
+/* the transfer is split wherever the source (64k or 128k) or the
+   destination wraps, and each piece copied in one go - both sides hold
+   words high byte first, so a straight copy unless the VRAM address is
+   odd, when the VDP swaps the bytes of every word */
+
+static void vdp_ramcopy_bulk(int type, const uint8 *srcmemory, uint16 srcmask,
+                             uint16 srcoffset, unsigned int length)
+{
+  uint16 address = vdp_address;
+  unsigned int n, dst, col;
+  const uint8 *src;
+
+  while (length) {
+    dst = type == 0 ? (address & 0xfffe) : (address & 0x7e);
+    n = srcmask + 1 - (srcoffset & srcmask);
+    if (n > ((type == 0 ? 0x10000 : 0x80) - dst) / 2)
+      n = ((type == 0 ? 0x10000 : 0x80) - dst) / 2;
+    if (n > length)
+      n = length;
+    src = srcmemory + (srcoffset & srcmask) * 2;
+    switch (type) {
+    case 0: /* VRAM */
+      if (address & 1)
+        vdp_copyswapped(vdp_vram + dst, src, n);
+      else
+        memcpy(vdp_vram + dst, src, n * 2);
+      vdp_vramrange(dst, n * 2);
+      break;
+    case 1: /* CRAM */
+      memcpy(vdp_cram + dst, src, n * 2);
+      for (col = dst >> 1; col < (dst >> 1) + n; col++)
+        vdp_cramstored(col);
+      break;
+    case 2: /* VSRAM */
+      if (dst < LEN_VSRAM)
+        memcpy(vdp_vsram + dst, src,
+               n * 2 < LEN_VSRAM - dst ? n * 2 : LEN_VSRAM - dst);
+      break;
+    }
+    srcoffset += n;
+    address += n * 2;
+    length -= n;
+  }
+}
+
 void vdp_ramcopy_vram(int type)
 {
   uint16 length = vdp_reg[19] | vdp_reg[20] << 8;
@@ -369,30 +727,39 @@ void vdp_ramcopy_vram(int type)
     srcmemory = (uint16 *)(cpu68k_rom + srcbank * 0x20000);
     srcmask = 0xffff; /* 64k words = 128k */
   }
-  for (i = 0; i < length; i++) {
-    data = LOCENDIAN16(srcmemory[srcoffset & srcmask]);
-    switch (type) {
-    case 0: /* VRAM */
-      vdp_vram[vdp_address] = data >> 8;
-      vdp_vram[vdp_address ^ 1] = data & 0xff;
-      break;
-    case 1: /* CRAM */
-      vdp_cram[vdp_address & 0x7e] = data >> 8;
-      vdp_cram[(vdp_address & 0x7e) | 1] = data & 0xff;
-      vdp_cramf[(vdp_address & 0x7e) >> 1] = 1;
+  if (increment == 2) {
+    /* the usual case - whole blocks at a time */
+    vdp_ramcopy_bulk(type, (const uint8 *)srcmemory, srcmask, srcoffset,
+                     length);
+    srcoffset += length;
+    vdp_address += length * 2;
+  } else {
+    for (i = 0; i < length; i++) {
+      data = LOCENDIAN16(srcmemory[srcoffset & srcmask]);
+      switch (type) {
+      case 0: /* VRAM */
+        vdp_vram[vdp_address] = data >> 8;
+        vdp_vram[vdp_address ^ 1] = data & 0xff;
+        vdp_vramstored(vdp_address);
+        break;
+      case 1: /* CRAM */
+        vdp_cram[vdp_address & 0x7e] = data >> 8;
+        vdp_cram[(vdp_address & 0x7e) | 1] = data & 0xff;
+        vdp_cramstored((vdp_address & 0x7e) >> 1);
 #ifdef DEBUG_VDPCRAM
-      LOG_VERBOSE(("%08X CRAM %X = %04X", regs.pc, vdp_address >> 1, data));
+        LOG_VERBOSE(("%08X CRAM %X = %04X", regs.pc, vdp_address >> 1, data));
 #endif
-      break;
-    case 2: /* VSRAM */
-      if ((vdp_address & 0x7e) < LEN_VSRAM) {
-        vdp_vsram[vdp_address & 0x7e] = data >> 8;
-        vdp_vsram[(vdp_address & 0x7e) | 1] = data & 0xff;
+        break;
+      case 2: /* VSRAM */
+        if ((vdp_address & 0x7e) < LEN_VSRAM) {
+          vdp_vsram[vdp_address & 0x7e] = data >> 8;
+          vdp_vsram[(vdp_address & 0x7e) | 1] = data & 0xff;
+        }
+        break;
       }
-      break;
+      srcoffset += 1;
+      vdp_address += increment;
     }
-    srcoffset += 1;
-    vdp_address += increment;
   }
   vdp_reg[19] = 0;
   vdp_reg[20] = 0;
@@ -402,6 +769,35 @@ void vdp_ramcopy_vram(int type)
   event_freeze(type == 0 ? length * 2 : length);
 }
 
+/*** vdp_dma_vramcopy_bulk - VRAM to VRAM, increment 1 ***/
+
+/* split where either address wraps; a destination just above the source
+   repeats the bytes in between, as copying a byte at a time would */
+
+static void vdp_dma_vramcopy_bulk(uint16 srcaddr, unsigned int length)
+{
+  uint16 address = vdp_address;
+  unsigned int n, i, first, last;
+
+  while (length) {
+    n = 0x10000 - (address > srcaddr ? address : srcaddr);
+    if (n > length)
+      n = length;
+    if (address > srcaddr && address < srcaddr + n) {
+      for (i = 0; i < n; i++)
+        vdp_vram[address + i] = vdp_vram[srcaddr + i];
+    } else {
+      memmove(vdp_vram + address, vdp_vram + srcaddr, n);
+    }
+    first = address & 0xfffe;
+    last = (address + n + 1) & ~1u;
+    vdp_vramrange(first, last - first);
+    srcaddr += n;
+    address += n;
+    length -= n;
+  }
+}
+
 void vdp_dma_vramcopy()
 {
   uint32 length = vdp_reg[19] | vdp_reg[20] << 8;
@@ -419,9 +815,16 @@ void vdp_dma_vramcopy()
                regs.pc, length, vdp_address, increment, srcaddr));
 #endif
 
-  for (i = 0; i < length; i++) {
-    vdp_vram[vdp_address] = vdp_vram[srcaddr++];
-    vdp_address += increment;
+  if (increment == 1) {
+    vdp_dma_vramcopy_bulk(srcaddr, length);
+    srcaddr += length;
+    vdp_address += length;
+  } else {
+    for (i = 0; i < length; i++) {
+      vdp_vram[vdp_address] = vdp_vram[srcaddr++];
+      vdp_vramstored(vdp_address);
+      vdp_address += increment;
+    }
   }
 
   vdp_reg[19] = 0;
@@ -431,6 +834,35 @@ void vdp_dma_vramcopy()
   vdp_dmabytes = length * 2; /* factor of 2 vram copy to vram fill (p36) */
 }
 
+/*** vdp_dma_fill_bulk - the DMA part of a fill, increment 1 ***/
+
+/* each address fills the other byte of its word, so whole words starting
+   at an even address fill themselves and only odd ends are done singly */
+
+static void vdp_dma_fill_bulk(uint8 data, unsigned int length)
+{
+  uint16 address = vdp_address;
+  unsigned int n;
+
+  while (length) {
+    if ((address & 1) || length == 1) {
+      vdp_vram[address ^ 1] = data;
+      vdp_vramrange(address & 0xfffe, 2);
+      address++;
+      length--;
+      continue;
+    }
+    n = 0x10000 - address;
+    if (n > length)
+      n = length;
+    n &= ~1u;
+    memset(vdp_vram + address, data, n);
+    vdp_vramrange(address, n);
+    address += n;
+    length -= n;
+  }
+}
+
 /*** vdp_dma_fill - implement the DMA part of the fill operation - note
      that the low byte of the 16 bit word has already been written in the
      non-dma stage ***/
@@ -444,9 +876,15 @@ void vdp_dma_fill(uint8 data)
   if (increment != 1 && increment != 2 && increment != 4)
     LOG_NORMAL(("VDP fill used with strange increment %d", increment));
 
-  for (i = 0; i < length; i++) {
-    vdp_vram[vdp_address ^ 1] = data;
-    vdp_address += increment; /* 16 bit wrap */
+  if (increment == 1) {
+    vdp_dma_fill_bulk(data, length);
+    vdp_address += length;
+  } else {
+    for (i = 0; i < length; i++) {
+      vdp_vram[vdp_address ^ 1] = data;
+      vdp_vramstored(vdp_address);
+      vdp_address += increment; /* 16 bit wrap */
+    }
   }
   vdp_reg[19] = 0;
   vdp_reg[20] = 0;
@@ -480,12 +918,13 @@ void vdp_storedata(uint16 data)
   case cd_vram_store:
     sdata = (vdp_address & 1) ? SWAP16(data) : data; /* only for VRAM */
     *(uint16 *)(vdp_vram + (vdp_address & 0xfffe)) = LOCENDIAN16(sdata);
+    vdp_vramstored(vdp_address);
     vdp_fifo_add(); /* Track FIFO entry */
     break;
   case cd_cram_store:
     address = vdp_address & 0x7e; /* address lines used */
     *(uint16 *)(vdp_cram + address) = LOCENDIAN16(data);
-    vdp_cramf[address >> 1] = 1;
+    vdp_cramstored(address >> 1);
     vdp_fifo_add(); /* Track FIFO entry */
     break;
   case cd_vsram_store:
@@ -563,7 +1002,7 @@ uint16 vdp_fetchdata(void)
 #define LINEDATASPR(offset, value, palette, priority) \
   if (value) {                                        \
     if (outdata[offset] < 62)                         \
-      vdp_collision = 1;                              \
+      v->collision = 1;                               \
     if (priority)                                     \
       pridata[offset] |= 1 << PRIBIT_SPRITE;          \
     else                                              \
@@ -571,60 +1010,112 @@ uint16 vdp_fetchdata(void)
     outdata[offset] = (palette) * 16 + value;         \
   }
 
-#define LINEDATALAYER(offset, value, palette, priority)                 \
-  if (priority)                                                         \
-    pridata[offset] |= layer ? 1 << PRIBIT_LAYERB : 1 << PRIBIT_LAYERA; \
-  if (value)                                                            \
-    outdata[offset] = (palette) * 16 + value;                           \
-  else                                                                  \
-    outdata[offset] = 0;
+/*** vdp_spritecell - plot pixels of a decoded sprite row ***/
 
-void vdp_sprites(unsigned int line, uint8 *pridata, uint8 *outdata)
+static inline void vdp_spritecell(t_vdp_view *v, const uint8 *row, int pixels,
+                                  uint8 palette, uint8 priority,
+                                  uint8 *outdata, uint8 *pridata)
+{
+  int i;
+
+  for (i = 0; i < pixels; i++) {
+    LINEDATASPR(i, row[i], palette, priority);
+  }
+}
+
+/*** vdp_layercell - plot pixels of a decoded layer row ***/
+
+/* pribit is the layer's priority bit if the cell has priority, else 0 */
+
+static inline void vdp_layercell(const uint8 *row, int pixels, uint8 palette,
+                                 uint8 pribit, uint8 *outdata, uint8 *pridata)
 {
-  uint8 interlace = (vdp_reg[12] >> 1) & 3;
-  uint8 *spritelist = vdp_vram + ((vdp_reg[5] & 0x7F) << 9);
-  t_spriteinfo si[128]; /* 128 - max sprites supported per line */
-  unsigned int sprites;
-  unsigned int idx;
   int i;
-  uint8 link;
-  uint8 *sprite = spritelist;
-  int plotter; /* flag */
-  unsigned int screencells = (vdp_reg[12] & 1) ? 40 : 32;
-  unsigned int maxspl = (vdp_reg[12] & 1) ? 20 : 16; /* max sprs/line */
-  unsigned int cells;
-  uint8 loops = 0;
 
-  for (idx = 0; loops < 255 && idx < maxspl; loops++) {
+  palette <<= 4;
+  for (i = 0; i < pixels; i++) {
+    outdata[i] = row[i] ? (palette | row[i]) : 0;
+    pridata[i] |= pribit;
+  }
+}
+
+/*** vdp_satdecode - decode the sprite table and sort it into lines ***/
+
+static void vdp_satdecode(t_vdp_view *v, uint16 base, uint8 interlace)
+{
+  t_vdp_sat *sat = v->sat;
+  const uint8 *spritelist = v->vram + base;
+  const uint8 *sprite = spritelist;
+  t_spriteinfo *si;
+  unsigned int n, link;
+  int line, top, bottom;
+
+  memset(sat->count, 0, sizeof(sat->count));
+  for (n = 0; n < VDP_SATWALK; n++) {
+    si = &sat->entry[n];
     link = sprite[3] & 0x7F;
-    si[idx].sprite = sprite;
+    si->sprite = sprite;
     if (interlace == 3)
-      si[idx].vpos = (LOCENDIAN16(*(uint16 *)(sprite)) & 0x3FF) - 0x100;
+      si->vpos = (LOCENDIAN16(*(uint16 *)(sprite)) & 0x3FF) - 0x100;
     else
-      si[idx].vpos = (LOCENDIAN16(*(uint16 *)(sprite)) & 0x1FF) - 0x080;
-    if ((signed int)line < si[idx].vpos)
-      goto next;
-    si[idx].vsize = 1 + (sprite[2] & 3);
+      si->vpos = (LOCENDIAN16(*(uint16 *)(sprite)) & 0x1FF) - 0x080;
+    si->vsize = 1 + (sprite[2] & 3);
     if (interlace == 3)
-      si[idx].vsize <<= 1;
-    si[idx].vmax = si[idx].vpos + si[idx].vsize * 8;
-    if ((signed int)line >= si[idx].vmax)
-      goto next;
-    si[idx].hpos = (LOCENDIAN16(*(uint16 *)(sprite + 6)) & 0x1FF) - 0x80;
-    si[idx].hsize = 1 + ((sprite[2] >> 2) & 3);
-    si[idx].hplot = si[idx].hsize;
-    si[idx].hmax = si[idx].hpos + si[idx].hsize * 8;
-    idx++;
-  next:
+      si->vsize <<= 1;
+    si->vmax = si->vpos + si->vsize * 8;
+    si->hpos = (LOCENDIAN16(*(uint16 *)(sprite + 6)) & 0x1FF) - 0x80;
+    si->hsize = 1 + ((sprite[2] >> 2) & 3);
+    si->hplot = si->hsize;
+    si->hmax = si->hpos + si->hsize * 8;
+    /* vdp_sprites never looks past the first VDP_SPRLINE on a line */
+    top = si->vpos < 0 ? 0 : si->vpos;
+    bottom = si->vmax > VDP_SATLINES ? VDP_SATLINES : si->vmax;
+    for (line = top; line < bottom; line++) {
+      if (sat->count[line] < VDP_SPRLINE)
+        sat->bucket[line][sat->count[line]++] = n;
+    }
     if (!link)
       break;
     sprite = spritelist + (link << 3);
   }
+  sat->base = base;
+  sat->interlace = interlace;
+  /* a table hanging off the end of VRAM is decoded every time */
+  sat->valid = base + VDP_SATLEN <= LEN_VRAM;
+}
+
+/*** vdp_spriteline - the sprites on a line, masked and limited ***/
+
+/* fills si with the sprites to plot on line in priority order, hplot set
+   to the cells of each that survive masking and the per-line cell limit,
+   and returns how many there are */
+
+static unsigned int vdp_spriteline(t_vdp_view *v, unsigned int line,
+                                   t_spriteinfo *si)
+{
+  uint8 interlace = (v->reg[12] >> 1) & 3;
+  uint16 base = (v->reg[5] & 0x7F) << 9;
+  t_vdp_sat *sat = v->sat;
+  unsigned int sprites;
+  unsigned int idx;
+  int i;
+  int plotter; /* flag */
+  unsigned int maxspl = (v->reg[12] & 1) ? 20 : 16; /* max sprs/line */
+  unsigned int cells;
+
+  if (!sat->valid || sat->base != base || sat->interlace != interlace)
+    vdp_satdecode(v, base, interlace);
+  if (line >= VDP_SATLINES)
+    return 0;
+  if (sat->count[line] > maxspl)
+    v->overflow = 1;
+  for (idx = 0; idx < sat->count[line] && idx < maxspl; idx++)
+    si[idx] = sat->entry[sat->bucket[line][idx]];
   if (idx < 1)
-    return;
+    return 0;
   sprites = idx;
   plotter = 1;
-  cells = (vdp_reg[12] & 1) ? 40 : 32; /* 320 or 256 pixels */
+  cells = (v->reg[12] & 1) ? 40 : 32; /* 320 or 256 pixels */
   /* loop masking */
   for (i = 0; i < (signed int)sprites; i++) {
     if (plotter == 0) {
@@ -657,6 +1148,17 @@ void vdp_sprites(unsigned int line, uint8 *pridata, uint8 *outdata)
       cells = 0;
     }
   }
+  return sprites;
+}
+
+void vdp_sprites(t_vdp_view *v, unsigned int line, uint8 *pridata,
+                 uint8 *outdata)
+{
+  uint8 interlace = (v->reg[12] >> 1) & 3;
+  t_spriteinfo si[VDP_SPRLINE];
+  int sprites = vdp_spriteline(v, line, si);
+  int i;
+  unsigned int screencells = (v->reg[12] & 1) ? 40 : 32;
 
   {
     sint16 hpos, vpos;
@@ -665,11 +1167,10 @@ void vdp_sprites(unsigned int line, uint8 *pridata, uint8 *outdata)
     uint16 cellinfo;
     uint16 pattern;
     uint8 palette;
-    uint8 *cellline;
-    uint32 data;
-    uint8 pixel;
+    unsigned int cellline;
+    const uint8 *row;
     uint8 priority;
-    int j, k;
+    int k, skip, width;
 
     /* loop around sprites until end of list marker or no more */
     for (i = sprites - 1; i >= 0; i--) {
@@ -685,70 +1186,25 @@ void vdp_sprites(unsigned int line, uint8 *pridata, uint8 *outdata)
       palette = (cellinfo >> 13) & 3;
       priority = (cellinfo >> 15) & 1;
 
-      cellline =
-          vdp_vram + ((interlace == 3) ? (pattern << 6) : (pattern << 5));
+      cellline = (interlace == 3) ? (pattern << 6) : (pattern << 5);
       if (cellinfo & 1 << 12) /* vertical flip */
         cellline += (vmax - line - 1) * 4;
       else
         cellline += (line - vpos) * 4;
       for (k = 0; k < hsize && hplot--; k++) {
-        if (hpos > -8 && hpos < 0) {
-          if (cellinfo & 1 << 11) {
-            /* horizontal flip */
-            data = LOCENDIAN32(
-                *(uint32 *)(cellline + (hsize - k * 2 - 1) * (vsize << 5)));
-            data >>= (-hpos) * 4; /* get first pixel in bottom 4 bits */
-            for (j = 0; j < 8 + hpos; j++) {
-              pixel = data & 15;
-              LINEDATASPR(j, pixel, palette, priority);
-              data >>= 4;
-            }
-          } else {
-            data = LOCENDIAN32(*(uint32 *)cellline);
-            data <<= (-hpos) * 4; /* get first pixel in top 4 bits */
-            for (j = 0; j < 8 + hpos; j++) {
-              pixel = (data >> 28) & 15;
-              LINEDATASPR(j, pixel, palette, priority);
-              data <<= 4;
-            }
-          }
-        } else if (hpos >= 0 && hpos <= (signed int)(screencells - 1) * 8) {
-          if (cellinfo & 1 << 11) {
-            /* horizontal flip */
-            data = LOCENDIAN32(
-                *(uint32 *)(cellline + (hsize - k * 2 - 1) * (vsize << 5)));
-            for (j = 0; j < 8; j++) {
-              pixel = data & 15;
-              LINEDATASPR(hpos + j, pixel, palette, priority);
-              data >>= 4;
-            }
-          } else {
-            data = LOCENDIAN32(*(uint32 *)cellline);
-            for (j = 0; j < 8; j++) {
-              pixel = (data >> 28) & 15;
-              LINEDATASPR(hpos + j, pixel, palette, priority);
-              data <<= 4;
-            }
-          }
-        } else if (hpos > (signed int)(screencells - 1) * 8 &&
-                   hpos < (signed int)screencells * 8) {
-          if (cellinfo & 1 << 11) {
-            /* horizontal flip */
-            data = LOCENDIAN32(
-                *(uint32 *)(cellline + (hsize - k * 2 - 1) * (vsize << 5)));
-            for (j = 0; j < (signed int)(screencells * 8 - hpos); j++) {
-              pixel = data & 15;
-              LINEDATASPR(hpos + j, pixel, palette, priority);
-              data >>= 4;
-            }
-          } else {
-            data = LOCENDIAN32(*(uint32 *)cellline);
-            for (j = 0; j < (signed int)(screencells * 8 - hpos); j++) {
-              pixel = (data >> 28) & 15;
-              LINEDATASPR(hpos + j, pixel, palette, priority);
-              data <<= 4;
-            }
-          }
+        if (hpos > -8 && hpos < (signed int)screencells * 8) {
+          if (cellinfo & 1 << 11) /* horizontal flip - cells right to left */
+            row = vdp_tilerow(
+                v, cellline + (hsize - k * 2 - 1) * (vsize << 5), 1);
+          else
+            row = vdp_tilerow(v, cellline, 0);
+          /* clip to the left and right edges of the screen */
+          skip = hpos < 0 ? -hpos : 0;
+          width = (signed int)screencells * 8 - hpos;
+          if (width > 8)
+            width = 8;
+          vdp_spritecell(v, row + skip, width - skip, palette, priority,
+                         outdata + hpos + skip, pridata + hpos + skip);
         }
         cellline += vsize << 5; /* 32 bytes per cell (note vsize is doubled
                                    when interlaced) */
@@ -758,39 +1214,175 @@ void vdp_sprites(unsigned int line, uint8 *pridata, uint8 *outdata)
   }
 }
 
+/*** vdp_spritehit - whether vdp_sprites would plot anything on a line ***/
+
+/* vdp_sprites flags a collision for every sprite pixel it plots over one
+   below colour 62, and no pixel has been plotted yet when the first goes
+   down - so there is a collision exactly when any sprite pixel is plotted.
+   This finds that out the same way but without plotting */
+
+static int vdp_spritehit(t_vdp_view *v, unsigned int line)
+{
+  uint8 interlace = (v->reg[12] >> 1) & 3;
+  t_spriteinfo si[VDP_SPRLINE];
+  int sprites = vdp_spriteline(v, line, si);
+  int screenpixels = (v->reg[12] & 1) ? 320 : 256;
+  int i, k, x, skip, width;
+  sint16 hpos;
+  uint16 hsize, vsize, hplot;
+  uint16 cellinfo;
+  unsigned int cellline;
+  const uint8 *row;
+
+  for (i = 0; i < sprites; i++) {
+    hpos = si[i].hpos;
+    vsize = si[i].vsize;
+    hsize = si[i].hsize;
+    hplot = si[i].hplot;
+    cellinfo = LOCENDIAN16(*(uint16 *)(si[i].sprite + 4));
+    cellline = (interlace == 3) ? ((cellinfo & 0x7FF) << 6)
+                                : ((cellinfo & 0x7FF) << 5);
+    if (cellinfo & 1 << 12) /* vertical flip */
+      cellline += (si[i].vmax - line - 1) * 4;
+    else
+      cellline += (line - si[i].vpos) * 4;
+    for (k = 0; k < hsize && hplot--; k++) {
+      if (hpos > -8 && hpos < screenpixels) {
+        if (cellinfo & 1 << 11)
+          row = vdp_tilerow(v, cellline + (hsize - k * 2 - 1) * (vsize << 5),
+                            1);
+        else
+          row = vdp_tilerow(v, cellline, 0);
+        skip = hpos < 0 ? -hpos : 0;
+        width = screenpixels - hpos;
+        if (width > 8)
+          width = 8;
+        for (x = skip; x < width; x++) {
+          if (row[x])
+            return 1;
+        }
+      }
+      cellline += vsize << 5;
+      hpos += 8;
+    }
+  }
+  return 0;
+}
+
+/*** vdp_planecell - draw a cell of the plane cache ***/
+
+static void vdp_planecell(t_vdp_view *v, t_vdp_plane *p, unsigned int cx,
+                          unsigned int cy, uint16 cellinfo, uint8 pribit)
+{
+  unsigned int pw = p->hwidth * 8;
+  unsigned int offset = (cy * 8) * pw + cx * 8;
+  unsigned int pattern = (cellinfo & 2047) << 5;
+  uint8 palette = ((cellinfo >> 13) & 3) << 4;
+  uint8 pri = (cellinfo >> 15) & 1 ? pribit : 0;
+  const uint8 *row;
+  unsigned int r, i;
+
+  for (r = 0; r < 8; r++, offset += pw) {
+    row = vdp_tilerow(v, pattern + 4 * ((cellinfo & 1 << 12) ? 7 - r : r),
+                      cellinfo & 1 << 11);
+    for (i = 0; i < 8; i++) {
+      p->pixel[offset + i] = row[i] ? (palette | row[i]) : 0;
+      p->pri[offset + i] = pri;
+    }
+  }
+}
+
+/*** vdp_planeline - a line of layer A or B from the plane cache ***/
+
+/* base = name table, hwidth/vwidth = plane size in cells, hoffset/voffset =
+   plane position of the first pixel (taken modulo the plane size) */
+
+static void vdp_planeline(t_vdp_view *v, t_vdp_plane *p, uint16 base,
+                          unsigned int hwidth, unsigned int vwidth,
+                          unsigned int hoffset, unsigned int voffset,
+                          unsigned int pixels, uint8 pribit, uint8 *pridata,
+                          uint8 *outdata)
+{
+  const uint16 *patterndata = (const uint16 *)(v->vram + base);
+  unsigned int pw = hwidth * 8;
+  unsigned int cy, cx, cells, c, n, i;
+  const uint8 *src, *pri;
+  uint16 cellinfo;
+
+  if (p->base != base || p->hwidth != hwidth || p->vwidth != vwidth) {
+    memset(p->valid, 0, sizeof(p->valid));
+    p->base = base;
+    p->hwidth = hwidth;
+    p->vwidth = vwidth;
+  }
+  hoffset &= pw - 1;
+  voffset &= vwidth * 8 - 1;
+
+  /* bring the cells under this line up to date */
+  cy = voffset >> 3;
+  cx = hoffset >> 3;
+  cells = ((hoffset & 7) + pixels + 7) >> 3;
+  for (; cells; cells--, cx = (cx + 1) & (hwidth - 1)) {
+    c = cy * hwidth + cx;
+    cellinfo = LOCENDIAN16(patterndata[c]);
+    if (!p->valid[c] || p->info[c] != cellinfo ||
+        p->gen[c] != v->tilegen[cellinfo & 2047]) {
+      vdp_planecell(v, p, cx, cy, cellinfo, pribit);
+      p->valid[c] = 1;
+      p->info[c] = cellinfo;
+      p->gen[c] = v->tilegen[cellinfo & 2047];
+    }
+  }
+
+  /* and copy the row out, wrapping at the right edge of the plane */
+  src = p->pixel + voffset * pw;
+  pri = p->pri + voffset * pw;
+  while (pixels) {
+    n = pw - hoffset < pixels ? pw - hoffset : pixels;
+    memcpy(outdata, src + hoffset, n);
+    for (i = 0; i < n; i++)
+      pridata[i] |= pri[hoffset + i];
+    outdata += n;
+    pridata += n;
+    pixels -= n;
+    hoffset = 0;
+  }
+}
+
 /* layer 0 = A (top), layer 1 = B (bottom) */
 
-void vdp_newlayer(unsigned int line, uint8 *pridata, uint8 *outdata,
-                  unsigned int layer)
+void vdp_newlayer(t_vdp_view *v, unsigned int line, uint8 *pridata,
+                  uint8 *outdata, unsigned int layer)
 {
-  int i, j;
-  uint8 hsize = vdp_reg[16] & 3;
-  uint8 vsize = (vdp_reg[16] >> 4) & 3;
-  uint8 hmode = vdp_reg[11] & 3;
-  uint8 vmode = (vdp_reg[11] >> 2) & 1;
+  int j;
+  uint8 hsize = v->reg[16] & 3;
+  uint8 vsize = (v->reg[16] >> 4) & 3;
+  uint8 hmode = v->reg[11] & 3;
+  uint8 vmode = (v->reg[11] >> 2) & 1;
   uint16 vramoffset =
-      (layer ? ((vdp_reg[4] & 7) << 13) : ((vdp_reg[2] & (7 << 3)) << 10));
-  uint16 *patterndata = (uint16 *)(vdp_vram + vramoffset);
-  uint16 *hscrolldata =
-      (uint16 *)(((vdp_reg[13] & 63) << 10) + vdp_vram + layer * 2);
-  uint8 screencells = (vdp_reg[12] & 1) ? 40 : 32;
+      (layer ? ((v->reg[4] & 7) << 13) : ((v->reg[2] & (7 << 3)) << 10));
+  const uint16 *patterndata = (const uint16 *)(v->vram + vramoffset);
+  const uint16 *hscrolldata =
+      (const uint16 *)(((v->reg[13] & 63) << 10) + v->vram + layer * 2);
+  const uint16 *vsram = (const uint16 *)v->vsram;
+  uint8 screencells = (v->reg[12] & 1) ? 40 : 32;
   uint16 hwidth, vwidth, vmask, hoffset, voffset;
   uint16 cellinfo;
-  uint8 *pattern;
-  uint32 data;
+  unsigned int pattern;
+  const uint8 *row;
   uint8 palette;
-  uint8 pixel;
   uint8 priority;
-  int interlace = (((vdp_reg[12] >> 1) & 3) == 3) ? 1 : 0;
+  uint8 pribit = layer ? 1 << PRIBIT_LAYERB : 1 << PRIBIT_LAYERA;
+  int interlace = (((v->reg[12] >> 1) & 3) == 3) ? 1 : 0;
   int realline = interlace ? line >> 1 : line;
   int column;
 
   /* window stuff */
   int vcell = realline >> 3;
-  int topbottom = vdp_reg[18] & 0x80;
-  int winvpos = vdp_reg[18] & 0x1f;
-  int leftright = vdp_reg[17] & 0x80;
-  int winhpos = vdp_reg[17] & 0x1f;
+  int topbottom = v->reg[18] & 0x80;
+  int winvpos = v->reg[18] & 0x1f;
+  int leftright = v->reg[17] & 0x80;
+  int winhpos = v->reg[17] & 0x1f;
   int corrupted = 0;
 
   if (layer == 0) {
@@ -839,6 +1431,20 @@ void vdp_newlayer(unsigned int line, uint8 *pridata, uint8 *outdata,
 
   column = (hoffset & 15) == 0 ? 0 : ((hoffset & 15) > 8 ? -2 : -1);
 
+  /* with full screen vertical scroll and a plane the cache can hold the
+     line is one wrapped row of the plane - but not when the window bug
+     below moves the horizontal offset part way along */
+
+  if (v->plane && !vmode && !interlace && hsize != 2 && vsize != 2 &&
+      (hsize + 1) * (vsize + 1) <= VDP_PLANECELLS / 1024 &&
+      !(layer == 0 && !leftright && winhpos && (hoffset & 15))) {
+    vdp_planeline(v, &v->plane[layer], vramoffset, (hsize + 1) << 5,
+                  (vsize + 1) << 5, hoffset,
+                  LOCENDIAN16(vsram[layer]) + line, screencells * 8, pribit,
+                  pridata, outdata);
+    return;
+  }
+
   /* to implement the bug in the VDP's window code, we check to see if
      the window is on the left (leftright is 0), that there really is a
      window (winhpos not 0, winhpos < max is checked earlier) and that
@@ -859,7 +1465,7 @@ void vdp_newlayer(unsigned int line, uint8 *pridata, uint8 *outdata,
   hwidth = (hsize + 1) << 5;
   /* if 2-cell mode and vsram not valid yet, use 0 as the offset */
   voffset =
-      ((vmode && column < 0) ? 0 : LOCENDIAN16(((uint16 *)vdp_vsram)[layer]));
+      ((vmode && column < 0) ? 0 : LOCENDIAN16(vsram[layer]));
   voffset = (voffset + line) & vmask;
   hoffset &= (hwidth << 3) - 1; /* put offset in range */
   if (hsize == 2) {
@@ -870,7 +1476,7 @@ void vdp_newlayer(unsigned int line, uint8 *pridata, uint8 *outdata,
   cellinfo = LOCENDIAN16(
       patterndata[(hoffset >> 3) + hwidth * ((voffset >> 3) >> interlace)]);
   /* 32 bytes per pattern or 64 in interlace mode 2 */
-  pattern = vdp_vram + (((cellinfo & 2047) << 5) << interlace);
+  pattern = ((cellinfo & 2047) << 5) << interlace;
   /* now get correct line from pattern data */
   if (interlace) {
     /* interlace - double height cells */
@@ -893,23 +1499,9 @@ void vdp_newlayer(unsigned int line, uint8 *pridata, uint8 *outdata,
   }
   priority = (cellinfo >> 15) & 1;
   palette = (cellinfo >> 13) & 3;
-  data = LOCENDIAN32(*(uint32 *)pattern);
-  if (cellinfo & 1 << 11) {
-    /* horizontal flip */
-    data >>= (hoffset & 7) * 4; /* get first pixel in bottom 4 bits */
-    for (i = 0; i < 8 - (hoffset & 7); i++) {
-      pixel = data & 15;
-      LINEDATALAYER(i, pixel, palette, priority);
-      data >>= 4;
-    }
-  } else {
-    data <<= (hoffset & 7) * 4; /* get first pixel in top 4 bits */
-    for (i = 0; i < 8 - (hoffset & 7); i++) {
-      pixel = (data >> 28) & 15;
-      LINEDATALAYER(i, pixel, palette, priority);
-      data <<= 4;
-    }
-  }
+  row = vdp_tilerow(v, pattern, cellinfo & 1 << 11);
+  vdp_layercell(row + (hoffset & 7), 8 - (hoffset & 7), palette,
+                priority ? pribit : 0, outdata, pridata);
   outdata += 8 - (hoffset & 7);
   pridata += 8 - (hoffset & 7);
   hoffset += 8;
@@ -921,12 +1513,12 @@ void vdp_newlayer(unsigned int line, uint8 *pridata, uint8 *outdata,
     if (vmode) {
       /* 2-cell scroll */
       if (column >= 0)
-        voffset = LOCENDIAN16(((uint16 *)vdp_vsram)[(column & ~1) + layer]);
+        voffset = LOCENDIAN16(vsram[(column & ~1) + layer]);
       else
         voffset = 0;
     } else {
       /* full screen */
-      voffset = LOCENDIAN16(((uint16 *)vdp_vsram)[layer]);
+      voffset = LOCENDIAN16(vsram[layer]);
     }
     voffset = (voffset + line) & vmask;
     if (hsize == 2)
@@ -943,7 +1535,7 @@ void vdp_newlayer(unsigned int line, uint8 *pridata, uint8 *outdata,
        cellinfo); */
     palette = (cellinfo >> 13) & 3;
     /* 32 bytes per pattern or 64 in interlace mode 2 */
-    pattern = vdp_vram + (((cellinfo & 2047) << 5) << interlace);
+    pattern = ((cellinfo & 2047) << 5) << interlace;
     /* now get correct line from pattern data */
     if (interlace) {
       /* interlace - double height cells */
@@ -964,21 +1556,8 @@ void vdp_newlayer(unsigned int line, uint8 *pridata, uint8 *outdata,
         pattern += 4 * (voffset & 7);
       }
     }
-    data = LOCENDIAN32(*(uint32 *)pattern);
-    if (cellinfo & 1 << 11) {
-      /* horizontal flip */
-      for (i = 0; i < 8; i++) {
-        pixel = data & 15;
-        LINEDATALAYER(i, pixel, palette, priority);
-        data >>= 4;
-      }
-    } else {
-      for (i = 0; i < 8; i++) {
-        pixel = (data >> 28) & 15;
-        LINEDATALAYER(i, pixel, palette, priority);
-        data <<= 4;
-      }
-    }
+    row = vdp_tilerow(v, pattern, cellinfo & 1 << 11);
+    vdp_layercell(row, 8, palette, priority ? pribit : 0, outdata, pridata);
     outdata += 8;
     pridata += 8;
     hoffset += 8;
@@ -991,12 +1570,12 @@ void vdp_newlayer(unsigned int line, uint8 *pridata, uint8 *outdata,
     if (vmode) {
       /* 2-cell scroll */
       if (column >= 0)
-        voffset = LOCENDIAN16(((uint16 *)vdp_vsram)[(column & ~1) + layer]);
+        voffset = LOCENDIAN16(vsram[(column & ~1) + layer]);
       else
         voffset = 0;
     } else {
       /* full screen */
-      voffset = LOCENDIAN16(((uint16 *)vdp_vsram)[layer]);
+      voffset = LOCENDIAN16(vsram[layer]);
     }
     voffset = (voffset + line) & vmask;
     if (hsize == 2)
@@ -1007,7 +1586,7 @@ void vdp_newlayer(unsigned int line, uint8 *pridata, uint8 *outdata,
     priority = (cellinfo >> 15) & 1;
     palette = (cellinfo >> 13) & 3;
     /* 32 bytes per pattern or 64 in interlace mode 2 */
-    pattern = vdp_vram + (((cellinfo & 2047) << 5) << interlace);
+    pattern = ((cellinfo & 2047) << 5) << interlace;
     /* now get correct line from pattern data */
     if (interlace) {
       /* interlace - double height cells */
@@ -1028,50 +1607,38 @@ void vdp_newlayer(unsigned int line, uint8 *pridata, uint8 *outdata,
         pattern += 4 * (voffset & 7);
       }
     }
-    data = LOCENDIAN32(*(uint32 *)pattern);
-    if (cellinfo & 1 << 11) {
-      /* horizontal flip */
-      for (i = 0; i < (hoffset & 7); i++) {
-        pixel = data & 15;
-        LINEDATALAYER(i, pixel, palette, priority);
-        data >>= 4;
-      }
-    } else {
-      for (i = 0; i < (hoffset & 7); i++) {
-        pixel = (data >> 28) & 15;
-        LINEDATALAYER(i, pixel, palette, priority);
-        data <<= 4;
-      }
-    }
+    row = vdp_tilerow(v, pattern, cellinfo & 1 << 11);
+    vdp_layercell(row, hoffset & 7, palette, priority ? pribit : 0, outdata,
+                  pridata);
   }
 }
 
 /* this function updates outdata/pridata which came from the layerA generation
    routines */
 
-void vdp_newwindow(unsigned int line, uint8 *pridata, uint8 *outdata)
+void vdp_newwindow(t_vdp_view *v, unsigned int line, uint8 *pridata,
+                   uint8 *outdata)
 {
-  int interlace = (((vdp_reg[12] >> 1) & 3) == 3) ? 1 : 0;
+  int interlace = (((v->reg[12] >> 1) & 3) == 3) ? 1 : 0;
   int realline = line >> interlace;
   int voffset = line;
-  uint16 *patterndata = (uint16 *)(vdp_vram + ((vdp_reg[3] & 0x3e) << 10));
-  uint8 winhpos = vdp_reg[17] & 0x1f;
-  uint8 winvpos = vdp_reg[18] & 0x1f;
+  const uint16 *patterndata =
+      (const uint16 *)(v->vram + ((v->reg[3] & 0x3e) << 10));
+  uint8 winhpos = v->reg[17] & 0x1f;
+  uint8 winvpos = v->reg[18] & 0x1f;
   uint8 vcell = realline / 8;
   uint8 hcell;
-  uint8 screencells = (vdp_reg[12] & 1) ? 40 : 32;
-  uint8 topbottom = vdp_reg[18] & 0x80;
-  uint8 leftright = vdp_reg[17] & 0x80;
-  uint8 patternshift = (vdp_reg[12] & 1) ? 6 : 5;
+  uint8 screencells = (v->reg[12] & 1) ? 40 : 32;
+  uint8 topbottom = v->reg[18] & 0x80;
+  uint8 leftright = v->reg[17] & 0x80;
+  uint8 patternshift = (v->reg[12] & 1) ? 6 : 5;
   uint16 cellinfo;
-  uint8 *pattern;
-  uint32 data;
+  unsigned int pattern;
+  const uint8 *row;
   uint8 palette;
-  uint8 pixel;
   unsigned int i;
   unsigned int wholeline = 0;
   uint8 priority;
-  int layer = 0; /* for LINEDATALAYER macro */
 
   /* if topbottom is set then the wholeline part of the window is to the
      bottom, if it is clear then it is to the top
@@ -1112,7 +1679,7 @@ void vdp_newwindow(unsigned int line, uint8 *pridata, uint8 *outdata)
     priority = (cellinfo >> 15) & 1;
     palette = (cellinfo >> 13) & 3;
     /* 32 bytes per pattern */
-    pattern = vdp_vram + (((cellinfo & 2047) << 5) << interlace);
+    pattern = ((cellinfo & 2047) << 5) << interlace;
     /* now get correct line from pattern data */
     if (interlace) {
       /* interlace - double height cells */
@@ -1133,350 +1700,849 @@ void vdp_newwindow(unsigned int line, uint8 *pridata, uint8 *outdata)
         pattern += 4 * (voffset & 7);
       }
     }
-    data = LOCENDIAN32(*(uint32 *)pattern);
-    if (cellinfo & 1 << 11) {
-      /* horizontal flip */
-      for (i = 0; i < 8; i++) {
-        pixel = data & 15;
-        LINEDATALAYER(i, pixel, palette, priority);
-        data >>= 4;
-      }
-    } else {
-      for (i = 0; i < 8; i++) {
-        pixel = (data >> 28) & 15;
-        LINEDATALAYER(i, pixel, palette, priority);
-        data <<= 4;
-      }
-    }
+    row = vdp_tilerow(v, pattern, cellinfo & 1 << 11);
+    vdp_layercell(row, 8, palette, priority ? 1 << PRIBIT_LAYERA : 0, outdata,
+                  pridata);
   } /* hcell */
 }
 
-/*** vdp_renderline - render a line of a field ***/
+/*** vdp_composite_scalar - resolve priorities and shadow/highlight ***/
 
-/* line = field line (0 to 223)
-   linedata = buffer to put the output data (console colours: 0-191)
-   odd = whether this is an odd field or not (fields are 0 or 1, therefore
-                                              odd is the second one in a pair)
-   call with odd=0 at all times when not in interlace mode 2
+/* sprite, layerA, layerB = line buffers from vdp_sprites and vdp_newlayer
+   priorities = priority bits (1 = B, 2 = A, 4 = sprite) for each pixel
+   bg = background colour
+   ste = shadow/highlight enable bit (8) from register 12
  */
 
-void vdp_renderline(unsigned int line, uint8 *linedata, unsigned int odd)
+static void vdp_composite_scalar(uint8 *linedata, const uint8 *sprite,
+                                 const uint8 *layerA, const uint8 *layerB,
+                                 const uint8 *priorities, uint8 bg,
+                                 unsigned int ste)
 {
   int i;
-  uint8 datablock[320 * 4];
-  uint8 *data_sprite = datablock;
-  uint8 *data_layerA = datablock + 320;
-  uint8 *data_layerB = datablock + 320 * 2;
-  uint8 *priorities = datablock + 320 * 3;
-  uint8 bg = vdp_reg[7] & 63;
-  unsigned int interlace = (((vdp_reg[12] >> 1) & 3) == 3) ? 1 : 0;
-
-  memset(datablock, 0, sizeof(datablock));
-
-  if ((vdp_reg[1] & 1 << 6) == 0) {
-    /* screen is disabled */
-    for (i = 0; i < 320; i++)
-      linedata[i] = bg;
-    return;
-  }
-
-  if (vdp_layerS || vdp_layerSp)
-    vdp_sprites(interlace ? (line * 2 + odd) : line, priorities, data_sprite);
-  if (vdp_layerA || vdp_layerAp) {
-    vdp_newlayer(interlace ? (line * 2 + odd) : line, priorities, data_layerA,
-                 0);
-    if (vdp_layerW || vdp_layerWp)
-      vdp_newwindow(interlace ? (line * 2 + odd) : line, priorities,
-                    data_layerA);
-  }
-  if (vdp_layerB || vdp_layerBp)
-    vdp_newlayer(interlace ? (line * 2 + odd) : line, priorities, data_layerB,
-                 1);
 
   for (i = 0; i < 320; i++) {
-    switch (priorities[i] | (vdp_reg[12] & 1 << 3)) {
+
+    switch (priorities[i] | ste) {
     case 0: /* s/ten=0, B=0, A=0, S=0 */
-      if (data_sprite[i])
-        linedata[i] = data_sprite[i];
-      else if (data_layerA[i])
-        linedata[i] = data_layerA[i];
-      else if (data_layerB[i])
-        linedata[i] = data_layerB[i];
+      if (sprite[i])
+        linedata[i] = sprite[i];
+      else if (layerA[i])
+        linedata[i] = layerA[i];
+      else if (layerB[i])
+        linedata[i] = layerB[i];
       else
         linedata[i] = bg;
       break;
     case 1: /* s/ten=0, B=1, A=0, S=0 */
-      if (data_layerB[i])
-        linedata[i] = data_layerB[i];
-      else if (data_sprite[i])
-        linedata[i] = data_sprite[i];
-      else if (data_layerA[i])
-        linedata[i] = data_layerA[i];
+      if (layerB[i])
+        linedata[i] = layerB[i];
+      else if (sprite[i])
+        linedata[i] = sprite[i];
+      else if (layerA[i])
+        linedata[i] = layerA[i];
       else
         linedata[i] = bg;
       break;
     case 2: /* s/ten=0, B=0, A=1, S=0 */
-      if (data_layerA[i])
-        linedata[i] = data_layerA[i];
-      else if (data_sprite[i])
-        linedata[i] = data_sprite[i];
-      else if (data_layerB[i])
-        linedata[i] = data_layerB[i];
+      if (layerA[i])
+        linedata[i] = layerA[i];
+      else if (sprite[i])
+        linedata[i] = sprite[i];
+      else if (layerB[i])
+        linedata[i] = layerB[i];
       else
         linedata[i] = bg;
       break;
     case 3: /* s/ten=0, B=1, A=1, S=0 */
-      if (data_layerA[i])
-        linedata[i] = data_layerA[i];
-      else if (data_layerB[i])
-        linedata[i] = data_layerB[i];
-      else if (data_sprite[i])
-        linedata[i] = data_sprite[i];
+      if (layerA[i])
+        linedata[i] = layerA[i];
+      else if (layerB[i])
+        linedata[i] = layerB[i];
+      else if (sprite[i])
+        linedata[i] = sprite[i];
       else
         linedata[i] = bg;
       break;
     case 4: /* s/ten=0, B=0, A=0, S=1 */
-      if (data_sprite[i])
-        linedata[i] = data_sprite[i];
-      else if (data_layerA[i])
-        linedata[i] = data_layerA[i];
-      else if (data_layerB[i])
-        linedata[i] = data_layerB[i];
+      if (sprite[i])
+        linedata[i] = sprite[i];
+      else if (layerA[i])
+        linedata[i] = layerA[i];
+      else if (layerB[i])
+        linedata[i] = layerB[i];
       else
         linedata[i] = bg;
       break;
     case 5: /* s/ten=0, B=1, A=0, S=1 */
-      if (data_sprite[i])
-        linedata[i] = data_sprite[i];
-      else if (data_layerB[i])
-        linedata[i] = data_layerB[i];
-      else if (data_layerA[i])
-        linedata[i] = data_layerA[i];
+      if (sprite[i])
+        linedata[i] = sprite[i];
+      else if (layerB[i])
+        linedata[i] = layerB[i];
+      else if (layerA[i])
+        linedata[i] = layerA[i];
       else
         linedata[i] = bg;
       break;
     case 6: /* s/ten=0, B=0, A=1, S=1 */
-      if (data_sprite[i])
-        linedata[i] = data_sprite[i];
-      else if (data_layerA[i])
-        linedata[i] = data_layerA[i];
-      else if (data_layerB[i])
-        linedata[i] = data_layerB[i];
+      if (sprite[i])
+        linedata[i] = sprite[i];
+      else if (layerA[i])
+        linedata[i] = layerA[i];
+      else if (layerB[i])
+        linedata[i] = layerB[i];
       else
         linedata[i] = bg;
       break;
     case 7: /* s/ten=0, B=1, A=1, S=1 */
-      if (data_sprite[i])
-        linedata[i] = data_sprite[i];
-      else if (data_layerA[i])
-        linedata[i] = data_layerA[i];
-      else if (data_layerB[i])
-        linedata[i] = data_layerB[i];
+      if (sprite[i])
+        linedata[i] = sprite[i];
+      else if (layerA[i])
+        linedata[i] = layerA[i];
+      else if (layerB[i])
+        linedata[i] = layerB[i];
       else
         linedata[i] = bg;
       break;
     case 8: /* s/ten=1, B=0, A=0, S=0 */
-      if (data_sprite[i]) {
-        if (data_sprite[i] == 63) { /* shadow operator */
-          if (data_layerA[i])
-            linedata[i] = data_layerA[i] | 128; /* shadow */
-          else if (data_layerB[i])
-            linedata[i] = data_layerB[i] | 128; /* shadow */
+      if (sprite[i]) {
+        if (sprite[i] == 63) { /* shadow operator */
+          if (layerA[i])
+            linedata[i] = layerA[i] | 128; /* shadow */
+          else if (layerB[i])
+            linedata[i] = layerB[i] | 128; /* shadow */
           else
             linedata[i] = bg | 128;        /* shadow */
-        } else if (data_sprite[i] == 62) { /* highlight operator */
-          if (data_layerA[i])
-            linedata[i] = data_layerA[i]; /* normal */
-          else if (data_layerB[i])
-            linedata[i] = data_layerB[i]; /* normal */
+        } else if (sprite[i] == 62) { /* highlight operator */
+          if (layerA[i])
+            linedata[i] = layerA[i]; /* normal */
+          else if (layerB[i])
+            linedata[i] = layerB[i]; /* normal */
           else
             linedata[i] = bg; /* normal */
         } else {
-          linedata[i] = data_sprite[i] | 128; /* shadow */
+          linedata[i] = sprite[i] | 128; /* shadow */
         }
       } else {
-        if (data_layerA[i])
-          linedata[i] = data_layerA[i] | 128; /* shadow */
-        else if (data_layerB[i])
-          linedata[i] = data_layerB[i] | 128; /* shadow */
+        if (layerA[i])
+          linedata[i] = layerA[i] | 128; /* shadow */
+        else if (layerB[i])
+          linedata[i] = layerB[i] | 128; /* shadow */
         else
           linedata[i] = bg | 128; /* shadow */
       }
       break;
     case 9: /* s/ten=1, B=1, A=0, S=0 */
-      if (data_layerB[i]) {
-        linedata[i] = data_layerB[i]; /* normal */
+      if (layerB[i]) {
+        linedata[i] = layerB[i]; /* normal */
       } else {
-        if (data_sprite[i]) {
-          if (data_sprite[i] == 63) { /* shadow operator */
-            if (data_layerA[i])
-              linedata[i] = data_layerA[i] | 128; /* shadow */
+        if (sprite[i]) {
+          if (sprite[i] == 63) { /* shadow operator */
+            if (layerA[i])
+              linedata[i] = layerA[i] | 128; /* shadow */
             else
               linedata[i] = bg | 128;        /* shadow */
-          } else if (data_sprite[i] == 62) { /* highlight operator */
-            if (data_layerA[i])
-              linedata[i] = data_layerA[i] | 64; /* highlight */
+          } else if (sprite[i] == 62) { /* highlight operator */
+            if (layerA[i])
+              linedata[i] = layerA[i] | 64; /* highlight */
             else
               linedata[i] = bg | 64; /* highlight */
           } else {
-            linedata[i] = data_sprite[i]; /* normal */
+            linedata[i] = sprite[i]; /* normal */
           }
         } else {
-          if (data_layerA[i])
-            linedata[i] = data_layerA[i]; /* normal */
+          if (layerA[i])
+            linedata[i] = layerA[i]; /* normal */
           else
             linedata[i] = bg; /* normal */
         }
       }
       break;
     case 10: /* s/ten=1, B=0, A=1, S=0 */
-      if (data_layerA[i]) {
-        linedata[i] = data_layerA[i]; /* normal */
+      if (layerA[i]) {
+        linedata[i] = layerA[i]; /* normal */
       } else {
-        if (data_sprite[i]) {
-          if (data_sprite[i] == 63) { /* shadow operator */
-            if (data_layerB[i])
-              linedata[i] = data_layerB[i] | 128; /* shadow */
+        if (sprite[i]) {
+          if (sprite[i] == 63) { /* shadow operator */
+            if (layerB[i])
+              linedata[i] = layerB[i] | 128; /* shadow */
             else
               linedata[i] = bg | 128;        /* shadow */
-          } else if (data_sprite[i] == 62) { /* highlight operator */
-            if (data_layerB[i])
-              linedata[i] = data_layerB[i] | 64; /* highlight */
+          } else if (sprite[i] == 62) { /* highlight operator */
+            if (layerB[i])
+              linedata[i] = layerB[i] | 64; /* highlight */
             else
               linedata[i] = bg | 64; /* highlight */
           } else {
-            linedata[i] = data_sprite[i]; /* normal */
+            linedata[i] = sprite[i]; /* normal */
           }
         } else {
-          if (data_layerB[i])
-            linedata[i] = data_layerB[i]; /* normal */
+          if (layerB[i])
+            linedata[i] = layerB[i]; /* normal */
           else
             linedata[i] = bg; /* normal */
         }
       }
       break;
     case 11: /* s/ten=1, B=1, A=1, S=0 */
-      if (data_layerA[i]) {
-        linedata[i] = data_layerA[i]; /* normal */
-      } else if (data_layerB[i]) {
-        linedata[i] = data_layerB[i]; /* normal */
-      } else if (data_sprite[i]) {
-        if (data_sprite[i] == 63)      /* shadow operator */
+      if (layerA[i]) {
+        linedata[i] = layerA[i]; /* normal */
+      } else if (layerB[i]) {
+        linedata[i] = layerB[i]; /* normal */
+      } else if (sprite[i]) {
+        if (sprite[i] == 63)      /* shadow operator */
           linedata[i] = bg | 128;      /* shadow */
-        else if (data_sprite[i] == 62) /* highlight operator */
+        else if (sprite[i] == 62) /* highlight operator */
           linedata[i] = bg | 64;       /* highlight */
         else
-          linedata[i] = data_sprite[i]; /* normal */
+          linedata[i] = sprite[i]; /* normal */
       } else {
         linedata[i] = bg; /* normal */
       }
       break;
     case 12: /* s/ten=0, B=0, A=0, S=1 */
-      if (data_sprite[i]) {
-        if (data_sprite[i] == 63) { /* shadow operator */
-          if (data_layerA[i])
-            linedata[i] = data_layerA[i] | 128; /* shadow */
-          else if (data_layerB[i])
-            linedata[i] = data_layerB[i] | 128; /* shadow */
+      if (sprite[i]) {
+        if (sprite[i] == 63) { /* shadow operator */
+          if (layerA[i])
+            linedata[i] = layerA[i] | 128; /* shadow */
+          else if (layerB[i])
+            linedata[i] = layerB[i] | 128; /* shadow */
           else
             linedata[i] = bg | 128;        /* shadow */
-        } else if (data_sprite[i] == 62) { /* highlight operator */
-          if (data_layerA[i])
-            linedata[i] = data_layerA[i]; /* normal */
-          else if (data_layerB[i])
-            linedata[i] = data_layerB[i]; /* normal */
+        } else if (sprite[i] == 62) { /* highlight operator */
+          if (layerA[i])
+            linedata[i] = layerA[i]; /* normal */
+          else if (layerB[i])
+            linedata[i] = layerB[i]; /* normal */
           else
             linedata[i] = bg; /* normal */
         } else {
-          linedata[i] = data_sprite[i]; /* normal */
+          linedata[i] = sprite[i]; /* normal */
         }
-      } else if (data_layerA[i]) {
-        linedata[i] = data_layerA[i] | 128; /* shadow */
-      } else if (data_layerB[i]) {
-        linedata[i] = data_layerB[i] | 128; /* shadow */
+      } else if (layerA[i]) {
+        linedata[i] = layerA[i] | 128; /* shadow */
+      } else if (layerB[i]) {
+        linedata[i] = layerB[i] | 128; /* shadow */
       } else {
         linedata[i] = bg | 128; /* shadow */
       }
       break;
     case 13: /* s/ten=1, B=1, A=0, S=1 */
-      if (data_sprite[i]) {
-        if (data_sprite[i] == 63) { /* shadow operator */
-          if (data_layerB[i])
-            linedata[i] = data_layerB[i] | 128; /* shadow */
-          else if (data_layerA[i])
-            linedata[i] = data_layerA[i] | 128; /* shadow */
+      if (sprite[i]) {
+        if (sprite[i] == 63) { /* shadow operator */
+          if (layerB[i])
+            linedata[i] = layerB[i] | 128; /* shadow */
+          else if (layerA[i])
+            linedata[i] = layerA[i] | 128; /* shadow */
           else
             linedata[i] = bg | 128;        /* shadow */
-        } else if (data_sprite[i] == 62) { /* highlight operator */
-          if (data_layerB[i])
-            linedata[i] = data_layerB[i] | 64; /* highlight */
-          else if (data_layerA[i])
-            linedata[i] = data_layerA[i] | 64; /* highlight */
+        } else if (sprite[i] == 62) { /* highlight operator */
+          if (layerB[i])
+            linedata[i] = layerB[i] | 64; /* highlight */
+          else if (layerA[i])
+            linedata[i] = layerA[i] | 64; /* highlight */
           else
             linedata[i] = bg | 64; /* highlight */
         } else {
-          linedata[i] = data_sprite[i]; /* normal */
+          linedata[i] = sprite[i]; /* normal */
         }
-      } else if (data_layerB[i]) {
-        linedata[i] = data_layerB[i]; /* normal */
-      } else if (data_layerA[i]) {
-        linedata[i] = data_layerA[i]; /* normal */
+      } else if (layerB[i]) {
+        linedata[i] = layerB[i]; /* normal */
+      } else if (layerA[i]) {
+        linedata[i] = layerA[i]; /* normal */
       }
       break;
     case 14: /* s/ten=1, B=0, A=1, S=1 */
-      if (data_sprite[i]) {
-        if (data_sprite[i] == 63) { /* shadow operator */
-          if (data_layerA[i])
-            linedata[i] = data_layerA[i] | 128; /* shadow */
-          else if (data_layerB[i])
-            linedata[i] = data_layerB[i] | 128; /* shadow */
+      if (sprite[i]) {
+        if (sprite[i] == 63) { /* shadow operator */
+          if (layerA[i])
+            linedata[i] = layerA[i] | 128; /* shadow */
+          else if (layerB[i])
+            linedata[i] = layerB[i] | 128; /* shadow */
           else
             linedata[i] = bg | 128;        /* shadow */
-        } else if (data_sprite[i] == 62) { /* highlight operator */
-          if (data_layerA[i])
-            linedata[i] = data_layerA[i] | 64; /* highlight */
-          else if (data_layerB[i])
-            linedata[i] = data_layerB[i] | 64; /* highlight */
+        } else if (sprite[i] == 62) { /* highlight operator */
+          if (layerA[i])
+            linedata[i] = layerA[i] | 64; /* highlight */
+          else if (layerB[i])
+            linedata[i] = layerB[i] | 64; /* highlight */
           else
             linedata[i] = bg | 64; /* highlight */
         } else {
-          linedata[i] = data_sprite[i]; /* normal */
+          linedata[i] = sprite[i]; /* normal */
         }
-      } else if (data_layerA[i]) {
-        linedata[i] = data_layerA[i]; /* normal */
-      } else if (data_layerB[i]) {
-        linedata[i] = data_layerB[i]; /* normal */
+      } else if (layerA[i]) {
+        linedata[i] = layerA[i]; /* normal */
+      } else if (layerB[i]) {
+        linedata[i] = layerB[i]; /* normal */
       }
       break;
     case 15: /* s/ten=1, B=1, A=1, S=1 */
-      if (data_sprite[i]) {
-        if (data_sprite[i] == 63) { /* shadow operator */
-          if (data_layerA[i])
-            linedata[i] = data_layerA[i] | 128; /* shadow */
-          else if (data_layerB[i])
-            linedata[i] = data_layerB[i] | 128; /* shadow */
+      if (sprite[i]) {
+        if (sprite[i] == 63) { /* shadow operator */
+          if (layerA[i])
+            linedata[i] = layerA[i] | 128; /* shadow */
+          else if (layerB[i])
+            linedata[i] = layerB[i] | 128; /* shadow */
           else
             linedata[i] = bg | 128;        /* shadow */
-        } else if (data_sprite[i] == 62) { /* highlight operator */
-          if (data_layerA[i])
-            linedata[i] = data_layerA[i] | 64; /* highlight */
-          else if (data_layerB[i])
-            linedata[i] = data_layerB[i] | 64; /* highlight */
+        } else if (sprite[i] == 62) { /* highlight operator */
+          if (layerA[i])
+            linedata[i] = layerA[i] | 64; /* highlight */
+          else if (layerB[i])
+            linedata[i] = layerB[i] | 64; /* highlight */
           else
             linedata[i] = bg | 64; /* highlight */
         } else {
-          linedata[i] = data_sprite[i]; /* normal */
+          linedata[i] = sprite[i]; /* normal */
         }
-      } else if (data_layerA[i]) {
-        linedata[i] = data_layerA[i]; /* normal */
-      } else if (data_layerB[i]) {
-        linedata[i] = data_layerB[i]; /* normal */
+      } else if (layerA[i]) {
+        linedata[i] = layerA[i]; /* normal */
+      } else if (layerB[i]) {
+        linedata[i] = layerB[i]; /* normal */
       }
       break;
     }
   }
 }
 
+#if SIMD_VECTORS
+
+/* The vector compositor does the same job as the switch above but on whole
+   registers of pixels at once, building the answer from lane masks instead
+   of branching.  The plane winner is the first visible pixel of A high, B
+   high, A low, B low, falling back to the background; the sprite beats it
+   when the sprite is visible and either has priority itself or no visible
+   plane pixel does.  With shadow/highlight on, the pixel is shadowed when
+   neither plane has its priority bit set, and a winning operator sprite (62
+   highlight, 63 shadow) applies to the plane winner underneath.  The switch
+   is the reference and these must match it byte for byte - including case
+   13-15 leaving linedata alone when nothing is visible. */
+
+#define VDP_COMPOSITE(V)                                                      \
+  {                                                                           \
+    const V bgv = (V){} + bg;                                                 \
+    unsigned int i;                                                           \
+                                                                              \
+    for (i = 0; i < 320; i += sizeof(V)) {                                    \
+      V s, a, b, p, l, sv, av, bv, sp, ap, bp, ahi, bhi, w, win, out;         \
+      V shadow, spr, keep;                                                    \
+                                                                              \
+      memcpy(&s, sprite + i, sizeof(V));                                      \
+      memcpy(&a, layerA + i, sizeof(V));                                      \
+      memcpy(&b, layerB + i, sizeof(V));                                      \
+      memcpy(&p, priorities + i, sizeof(V));                                  \
+      sv = (V)(s != 0);                                                       \
+      av = (V)(a != 0);                                                       \
+      bv = (V)(b != 0);                                                       \
+      sp = (V)((p & 4) != 0);                                                 \
+      ap = (V)((p & 2) != 0);                                                 \
+      bp = (V)((p & 1) != 0);                                                 \
+      ahi = av & ap;                                                          \
+      bhi = bv & bp;                                                          \
+      w = simd_select(bv, b, bgv);                                            \
+      w = simd_select(av & ~ap, a, w);                                        \
+      w = simd_select(bhi, b, w);                                             \
+      w = simd_select(ahi, a, w);                                             \
+      win = sv & (sp | ~(ahi | bhi));                                         \
+      if (!ste) {                                                             \
+        out = simd_select(win, s, w);                                         \
+      } else {                                                                \
+        shadow = ~(ap | bp);                                                  \
+        spr = simd_select((V)(s == 62), w | (~shadow & 64),                   \
+                          s | (shadow & ~sp & 128));                          \
+        spr = simd_select((V)(s == 63), w | 128, spr);                        \
+        out = simd_select(win, spr, w | (shadow & 128));                      \
+        keep = sp & (ap | bp) & ~(sv | av | bv);                              \
+        memcpy(&l, linedata + i, sizeof(V));                                  \
+        out = simd_select(keep, l, out);                                      \
+      }                                                                       \
+      memcpy(linedata + i, &out, sizeof(V));                                  \
+    }                                                                         \
+  }
+
+/*** vdp_composite_vec16 - 16 pixels at a time, SSE2 or NEON ***/
+
+static void vdp_composite_vec16(uint8 *linedata, const uint8 *sprite,
+                                const uint8 *layerA, const uint8 *layerB,
+                                const uint8 *priorities, uint8 bg,
+                                unsigned int ste)
+VDP_COMPOSITE(t_simd_u8x16)
+
+#if SIMD_HAVE_AVX2
+
+/*** vdp_composite_avx2 - 32 pixels at a time ***/
+
+SIMD_AVX2 static void vdp_composite_avx2(uint8 *linedata, const uint8 *sprite,
+                                         const uint8 *layerA,
+                                         const uint8 *layerB,
+                                         const uint8 *priorities, uint8 bg,
+                                         unsigned int ste)
+VDP_COMPOSITE(t_simd_u8x32)
+
+#endif
+#endif
+
+/*** vdp_palmap - console colours to pixels through a palette ***/
+
+/* palette = 192 entries, normal then highlighted then shadowed, as
+   uiplot_palcache */
+
+static void vdp_palmap_scalar(uint32 *outdata, const uint8 *linedata,
+                              const uint32 *palette, unsigned int pixels)
+{
+  unsigned int i;
+
+  for (i = 0; i < pixels; i++)
+    outdata[i] = palette[linedata[i]];
+}
+
+#if SIMD_HAVE_AVX2
+static SIMD_AVX2 void vdp_palmap_avx2(uint32 *outdata, const uint8 *linedata,
+                                      const uint32 *palette,
+                                      unsigned int pixels)
+{
+  unsigned int i;
+  __m256i index;
+
+  /* eight lookups at once with a gather */
+  for (i = 0; i + 8 <= pixels; i += 8) {
+    index = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64((const __m128i *)(linedata + i)));
+    _mm256_storeu_si256((__m256i *)(outdata + i),
+                        _mm256_i32gather_epi32((const int *)palette, index, 4));
+  }
+  vdp_palmap_scalar(outdata + i, linedata + i, palette, pixels - i);
+}
+#endif
+
+/*** vdp_composite_select - choose the compositor for this cpu ***/
+
+/* and the palette lookup to go with it */
+
+static void vdp_composite_select(void)
+{
+#if SIMD_HAVE_AVX2
+  if (simd_avx2()) {
+    vdp_composite = vdp_composite_avx2;
+    vdp_palmap = vdp_palmap_avx2;
+    LOG_VERBOSE(("VDP compositor: AVX2"));
+    return;
+  }
+#endif
+#if SIMD_VECTORS
+  vdp_composite = vdp_composite_vec16;
+  LOG_VERBOSE(("VDP compositor: 16 byte vectors"));
+#else
+  vdp_composite = vdp_composite_scalar;
+  LOG_VERBOSE(("VDP compositor: scalar"));
+#endif
+}
+
+/*** vdp_showlayers - which layers the user has left switched on ***/
+
+static unsigned int vdp_showlayers(void)
+{
+  return ((vdp_layerS || vdp_layerSp) ? VDP_SHOW_S : 0) |
+         ((vdp_layerA || vdp_layerAp) ? VDP_SHOW_A : 0) |
+         ((vdp_layerW || vdp_layerWp) ? VDP_SHOW_W : 0) |
+         ((vdp_layerB || vdp_layerBp) ? VDP_SHOW_B : 0);
+}
+
+/*** vdp_renderline - render a line of a field ***/
+
+/* line = field line (0 to 223)
+   linedata = buffer to put the output data (console colours: 0-191)
+   odd = whether this is an odd field or not (fields are 0 or 1, therefore
+                                              odd is the second one in a pair)
+   call with odd=0 at all times when not in interlace mode 2
+ */
+
+void vdp_renderline(unsigned int line, uint8 *linedata, unsigned int odd)
+{
+  if (line < VDP_MAXLINES)
+    vdp_dirtystate(line);
+  vdp_renderlive(line, linedata, odd);
+}
+
+/*** vdp_renderlive - render a line from the live VDP state ***/
+
+static void vdp_renderlive(unsigned int line, uint8 *linedata,
+                           unsigned int odd)
+{
+  vdp_live.layers = vdp_showlayers();
+  vdp_live.plane = vdp_planecache ? vdp_liveplane : nullptr;
+  vdp_renderview(&vdp_live, line, linedata, odd);
+  vdp_livestatus();
+  if (line < VDP_MAXLINES)
+    vdp_dirtypixels(line, linedata);
+}
+
+/*** vdp_dirtystate - start vdp_dirty for a line about to be rendered ***/
+
+/* a different width or CRAM from last time changes the whole line,
+   otherwise only the pixels that come out different do.  A line rendered
+   again in the same field (the display height changing part way down)
+   adds to what the first time changed */
+
+static void vdp_dirtystate(unsigned int line)
+{
+  unsigned int width = (vdp_reg[12] & 1) ? 320 : 256;
+  t_vdp_dirty *d = &vdp_dirty[line];
+
+  if (vdp_dirtyfield[line] != vdp_fields) {
+    vdp_dirtyfield[line] = vdp_fields;
+    d->left = 0;
+    d->right = 0;
+  }
+  if (vdp_dirtywidth[line] != width ||
+      memcmp(vdp_dirtycram[line], vdp_cram, LEN_CRAM)) {
+    vdp_dirtywidth[line] = width;
+    memcpy(vdp_dirtycram[line], vdp_cram, LEN_CRAM);
+    d->left = 0;
+    d->right = width;
+  }
+}
+
+/*** vdp_dirtypixels - finish vdp_dirty for a line just rendered ***/
+
+/* may be called by any thread, each for its own lines */
+
+static void vdp_dirtypixels(unsigned int line, const uint8 *linedata)
+{
+  t_vdp_dirty *d = &vdp_dirty[line];
+  uint8 *out = vdp_dirtyout[line];
+  unsigned int width = vdp_dirtywidth[line];
+  unsigned int cell, first = width / 8, last = 0;
+
+  if (d->left == 0 && d->right >= width) {
+    memcpy(out, linedata, width);
+    return;
+  }
+  if (!memcmp(out, linedata, width))
+    return;
+  for (cell = 0; cell < width / 8; cell++) {
+    if (memcmp(out + cell * 8, linedata + cell * 8, 8)) {
+      if (cell < first)
+        first = cell;
+      last = cell + 1;
+    }
+  }
+  memcpy(out, linedata, width);
+  if (d->right && d->left < first * 8)
+    first = d->left / 8;
+  if (d->right > last * 8)
+    last = d->right / 8;
+  d->left = first * 8;
+  d->right = last * 8;
+}
+
+/*** vdp_dirtyrect - the area that changed over the first lines lines ***/
+
+/* returns 0 and leaves rect alone if nothing did */
+
+int vdp_dirtyrect(unsigned int lines, t_vdp_rect *rect)
+{
+  unsigned int line;
+  int found = 0;
+
+  for (line = 0; line < lines && line < VDP_MAXLINES; line++) {
+    if (!vdp_dirty[line].right)
+      continue;
+    if (!found) {
+      rect->top = line;
+      rect->left = vdp_dirty[line].left;
+      rect->right = vdp_dirty[line].right;
+      found = 1;
+    }
+    if (vdp_dirty[line].left < rect->left)
+      rect->left = vdp_dirty[line].left;
+    if (vdp_dirty[line].right > rect->right)
+      rect->right = vdp_dirty[line].right;
+    rect->bottom = line + 1;
+  }
+  return found;
+}
+
+/*** vdp_dirtyall - treat every line as changed when next rendered ***/
+
+/* for when something other than vdp_renderline has been drawing */
+
+void vdp_dirtyall(void)
+{
+  memset(vdp_dirtywidth, 0, sizeof(vdp_dirtywidth));
+}
+
+/*** vdp_livestatus - pass sprite status from vdp_live on to vdp_status ***/
+
+static void vdp_livestatus(void)
+{
+  if (vdp_live.collision) {
+    vdp_collision = 1;
+    vdp_live.collision = 0;
+  }
+  if (vdp_live.overflow) {
+    vdp_overflow = 1;
+    vdp_live.overflow = 0;
+  }
+  vdp_spritesdone = 1;
+}
+
+/*** vdp_spritestatus - sprite status for a line that isn't rendered ***/
+
+/* line, odd = as for vdp_renderline; for when the UI skips a line, so the
+   collision and overflow status the 68k reads is the same whether a field
+   is drawn or not.  Only the sprites are looked at, and only as far as
+   needed */
+
+void vdp_spritestatus(int line, unsigned int odd)
+{
+  unsigned int interlace = (((vdp_reg[12] >> 1) & 3) == 3) ? 1 : 0;
+
+  if (line < 0 || line >= (int)vdp_vislines)
+    return;
+  /* under the same conditions as vdp_renderline looks at sprites */
+  if ((vdp_reg[1] & 1 << 6) && (vdp_layerS || vdp_layerSp)) {
+    if (vdp_spritehit(&vdp_live,
+                      interlace ? (line * 2 + odd) : line))
+      vdp_live.collision = 1;
+  }
+  vdp_livestatus();
+}
+
+/*** vdp_renderline_rgb32 - render a line straight to 32-bit pixels ***/
+
+/* as vdp_renderline, but the line is put through palette (192 entries as
+   uiplot_palcache) into outdata while it is still in the cache, rather
+   than handed back for the UI to convert.  pixels = how many to convert,
+   256 or 320 */
+
+void vdp_renderline_rgb32(unsigned int line, uint32 *outdata,
+                          const uint32 *palette, unsigned int pixels,
+                          unsigned int odd)
+{
+  uint8 linedata[320];
+
+  vdp_renderline(line, linedata, odd);
+  vdp_palmap(outdata, linedata, palette, pixels);
+}
+
+/*** vdp_renderview - render a line from a view of the VDP state ***/
+
+static void vdp_renderview(t_vdp_view *v, unsigned int line, uint8 *linedata,
+                           unsigned int odd)
+{
+  int i;
+  uint8 datablock[320 * 4];
+  uint8 *data_sprite = datablock;
+  uint8 *data_layerA = datablock + 320;
+  uint8 *data_layerB = datablock + 320 * 2;
+  uint8 *priorities = datablock + 320 * 3;
+  uint8 bg = v->reg[7] & 63;
+  unsigned int interlace = (((v->reg[12] >> 1) & 3) == 3) ? 1 : 0;
+
+  memset(datablock, 0, sizeof(datablock));
+
+  if ((v->reg[1] & 1 << 6) == 0) {
+    /* screen is disabled */
+    for (i = 0; i < 320; i++)
+      linedata[i] = bg;
+    return;
+  }
+
+  if (v->layers & VDP_SHOW_S)
+    vdp_sprites(v, interlace ? (line * 2 + odd) : line, priorities,
+                data_sprite);
+  if (v->layers & VDP_SHOW_A) {
+    vdp_newlayer(v, interlace ? (line * 2 + odd) : line, priorities,
+                 data_layerA, 0);
+    if (v->layers & VDP_SHOW_W)
+      vdp_newwindow(v, interlace ? (line * 2 + odd) : line, priorities,
+                    data_layerA);
+  }
+  if (v->layers & VDP_SHOW_B)
+    vdp_newlayer(v, interlace ? (line * 2 + odd) : line, priorities,
+                 data_layerB, 1);
+
+  vdp_composite(linedata, data_sprite, data_layerA, data_layerB, priorities, bg,
+                v->reg[12] & 1 << 3);
+}
+
+/*** vdp_logline - log a line for the render threads ***/
+
+/* the UI calls this instead of vdp_renderline when vdpthread_on is set,
+   with the same arguments; the line is available from vdp_loggedline once
+   vdp_logfield has been called at the end of the field */
+
+void vdp_logline(unsigned int line, unsigned int odd)
+{
+  t_vdp_band *b;
+  t_vdp_logline *l;
+
+  if (line >= VDP_MAXLINES)
+    return;
+
+  /* the 68k can see sprite collisions, so those can't wait for the render
+     threads */
+  vdp_spritestatus(line, odd);
+  vdp_dirtystate(line);
+
+  if (!vdp_bands)
+    vdp_bands = calloc(VDPTHREAD_BANDS, sizeof(t_vdp_band));
+  if (!vdp_logband && (vdp_logbands == VDPTHREAD_BANDS || !vdp_bands)) {
+    /* out of band slots - a field with lots of big VRAM transfers - or
+       no memory for them */
+    vdp_renderlive(line, vdp_logout[line], odd);
+  } else {
+    if (!vdp_logband) {
+      b = vdp_logband = &vdp_bands[vdp_logbands++];
+      vdp_logsnapshot(b);
+      b->lines = 0;
+      b->writes = 0;
+    }
+    b = vdp_logband;
+    l = &b->line[b->lines++];
+    memcpy(l->reg, vdp_reg, sizeof(l->reg));
+    memcpy(l->vsram, vdp_vsram, LEN_VSRAM);
+    l->line = line;
+    l->odd = odd;
+    l->layers = vdp_showlayers();
+    l->writes = b->writes;
+    if (b->lines == VDP_BANDLINES)
+      vdp_logclose();
+  }
+
+  /* the first line of each field always carries its CRAM so the UI needn't
+     know what was in its palette cache before */
+  if (vdp_logfirst || memcmp(vdp_logprevcram, vdp_cram, LEN_CRAM)) {
+    memcpy(vdp_logprevcram, vdp_cram, LEN_CRAM);
+    memcpy(vdp_logcram[line], vdp_cram, LEN_CRAM);
+    vdp_logstate[line] = VDP_LOGGED | VDP_LOGGED_CRAM;
+  } else {
+    vdp_logstate[line] = VDP_LOGGED;
+  }
+  if (vdp_reg[12] & 1)
+    vdp_logstate[line] |= VDP_LOGGED_H40;
+  vdp_logfirst = 0;
+}
+
+/*** vdp_logsnapshot - bring a band slot's copy of VRAM up to date ***/
+
+/* the slot keeps its VRAM and decoded tiles from the last time it was
+   used, which was usually the same lines of the previous field, so only
+   the tiles that differ now need copying and decoding again */
+
+static void vdp_logsnapshot(t_vdp_band *b)
+{
+  unsigned int tile;
+
+  for (tile = 0; tile < VDP_TILES; tile++) {
+    if (memcmp(b->vram + tile * 32, vdp_vram + tile * 32, 32)) {
+      memcpy(b->vram + tile * 32, vdp_vram + tile * 32, 32);
+      b->tiledirty[tile] = 1;
+      b->tilegen[tile]++;
+      if ((uint16)(tile * 32 - b->sat.base) < VDP_SATLEN)
+        b->sat.valid = 0;
+    }
+  }
+}
+
+/*** vdp_logclose - queue the band being logged into ***/
+
+static void vdp_logclose(void)
+{
+  unsigned int band;
+
+  if (!vdp_logband)
+    return;
+  band = vdp_logband - vdp_bands;
+  vdp_logband = nullptr;
+  if (vdpthread_on)
+    vdpthread_queue(band);
+  else
+    vdp_renderband(band);
+}
+
+/*** vdp_logfield - end of field, wait for all logged lines to render ***/
+
+void vdp_logfield(void)
+{
+  vdp_logclose();
+  vdpthread_wait();
+  vdp_logbands = 0;
+  vdp_logfirst = 1;
+}
+
+/*** vdp_logfree - free the band slots ***/
+
+/* called once the render threads have stopped; anything still being
+   logged into is rendered first, and the next line logged allocates the
+   slots again */
+
+void vdp_logfree(void)
+{
+  vdp_logclose();
+  free(vdp_bands);
+  vdp_bands = nullptr;
+  vdp_logbands = 0;
+}
+
+/*** vdp_loggedline - a line rendered from the log this field ***/
+
+/* returns nullptr if the line wasn't logged, otherwise the rendered line as
+   vdp_renderline would have left it.  *cram is set to the CRAM the line was
+   logged with if that differs from the previous logged line's, else to
+   nullptr, and *width to the line's width in pixels.  Each line can be
+   fetched once per field */
+
+const uint8 *vdp_loggedline(unsigned int line, const uint8 **cram,
+                            unsigned int *width)
+{
+  uint8 state;
+
+  *cram = nullptr;
+  if (line >= VDP_MAXLINES || !(state = vdp_logstate[line]))
+    return nullptr;
+  vdp_logstate[line] = 0;
+  if (state & VDP_LOGGED_CRAM)
+    *cram = vdp_logcram[line];
+  *width = (state & VDP_LOGGED_H40) ? 320 : 256;
+  return vdp_logout[line];
+}
+
+/*** vdp_renderband - render a band of logged lines, called by any thread ***/
+
+void vdp_renderband(unsigned int band)
+{
+  t_vdp_band *b = &vdp_bands[band];
+  t_vdp_view v = {nullptr,       nullptr,      b->vram,
+                  b->tilecache, b->tiledirty, &b->sat,
+                  b->tilegen,   vdp_planecache ? b->plane : nullptr};
+  const t_vdp_logline *l;
+  unsigned int i, w = 0;
+  uint16 addr;
+
+  for (i = 0; i < b->lines; i++) {
+    l = &b->line[i];
+    for (; w < l->writes; w++) {
+      addr = b->write[w] >> 16;
+      b->vram[addr] = b->write[w] >> 8;
+      b->vram[addr + 1] = b->write[w];
+      if (!b->tiledirty[addr >> 5]) {
+        b->tiledirty[addr >> 5] = 1;
+        b->tilegen[addr >> 5]++;
+      }
+      if ((uint16)(addr - b->sat.base) < VDP_SATLEN)
+        b->sat.valid = 0;
+    }
+    v.reg = l->reg;
+    v.vsram = l->vsram;
+    v.layers = l->layers;
+    vdp_renderview(&v, l->line, vdp_logout[l->line], l->odd);
+    vdp_dirtypixels(l->line, vdp_logout[l->line]);
+  }
+}
+
 void vdp_renderframe(uint8 *framedata, unsigned int lineoffset)
 {
   unsigned int i, line;
@@ -1495,7 +2561,10 @@ void vdp_renderframe(uint8 *framedata, unsigned int lineoffset)
     for (i = 0; i < (320 / 4); i++) {
       ((uint32 *)linedata)[i] = background;
     }
+    vdp_dirty[line].left = 0;
+    vdp_dirty[line].right = (vdp_reg[12] & 1) ? 320 : 256;
   }
+  vdp_dirtyall();
 
   if (vdp_reg[1] & 1 << 6) {
     if (vdp_layerB)
@@ -1732,6 +2801,14 @@ void vdp_eventinit(void)
 
 void vdp_endfield(void)
 {
+  vdp_fields++;
+  vdp_tiles_dirtied = vdp_tilecount_dirtied;
+  vdp_tiles_decoded = vdp_live.decoded;
+  vdp_tilecount_dirtied = 0;
+  vdp_live.decoded = 0;
+  vdpthread_endfield();
+  LOG_DEBUG1(("Tile cache: %d tiles dirtied, %d decoded", vdp_tiles_dirtied,
+              vdp_tiles_decoded));
   vdp_line = 0;
   vdp_eventinit();
   vdp_oddframe ^= 1; /* toggle */
@@ -2100,6 +3177,14 @@ int vdp_sprite_simple(unsigned int priority, uint8 *framedata,
   return plotted;
 }
 
+/*** vdp_dmarate - DMA bytes the VDP moves per line in the current mode ***/
+
+unsigned int vdp_dmarate(void)
+{
+  return vdp_dmaslots[vdp_reg[12] & 1]
+                     [vdp_vblank || !(vdp_reg[1] & 1 << 6) ? 1 : 0];
+}
+
 uint8 vdp_gethpos(void)
 {
   float percent;
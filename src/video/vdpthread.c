@@ -0,0 +1,156 @@
+/* Generator is (c) James Ponder, 1997-2001 http://www.squish.net/generator/ */
+
+/* render threads - renders field lines on other cores
+
+   With vdp_renderthreads set the UI passes each line to vdp_logline instead
+   of rendering it.  vdp.c keeps a log of everything the renderer reads -
+   registers, VSRAM and VRAM - grouped into bands of lines, and queues each
+   band here as soon as it fills.  The threads render bands while the 68k
+   carries on with the rest of the field, and vdp_logfield waits for the
+   last of them at the end of the field.  Bands are independent so any
+   number of threads can work on one field at once. */
+
+#include <threads.h>
+
+#include "generator.h"
+#include "vdp.h"
+#include "vdpthread.h"
+#include "ui.h"
+
+/*** variables externed ***/
+
+unsigned int vdpthread_on = 0; /* lines are to be logged, not rendered */
+
+/*** forward references ***/
+
+static int vdpthread_main(void *arg);
+
+/*** file scoped variables ***/
+
+static thrd_t vdpthread_threads[VDPTHREAD_MAX];
+static unsigned int vdpthread_count;
+static unsigned int vdpthread_bands[VDPTHREAD_BANDS]; /* queued band slots */
+static unsigned int vdpthread_queued; /* bands queued this field */
+static unsigned int vdpthread_taken;  /* bands a thread has started on */
+static unsigned int vdpthread_done;   /* bands finished */
+static unsigned int vdpthread_quit;
+static mtx_t vdpthread_mutex;
+static cnd_t vdpthread_work; /* signalled when a band is queued */
+static cnd_t vdpthread_idle; /* signalled when the last band is done */
+
+/*** vdpthread_start - start the pool ***/
+
+static int vdpthread_start(unsigned int threads)
+{
+  vdpthread_queued = vdpthread_taken = vdpthread_done = 0;
+  vdpthread_quit = 0;
+  if (mtx_init(&vdpthread_mutex, mtx_plain) != thrd_success)
+    return -1;
+  if (cnd_init(&vdpthread_work) != thrd_success) {
+    mtx_destroy(&vdpthread_mutex);
+    return -1;
+  }
+  if (cnd_init(&vdpthread_idle) != thrd_success) {
+    cnd_destroy(&vdpthread_work);
+    mtx_destroy(&vdpthread_mutex);
+    return -1;
+  }
+  vdpthread_on = 1; /* so a failed start can use vdpthread_stop */
+  for (vdpthread_count = 0; vdpthread_count < threads; vdpthread_count++) {
+    if (thrd_create(&vdpthread_threads[vdpthread_count], vdpthread_main,
+                    nullptr) != thrd_success) {
+      vdpthread_stop();
+      return -1;
+    }
+  }
+  LOG_VERBOSE(("%d render threads started", threads));
+  return 0;
+}
+
+/*** vdpthread_stop - finish queued bands and stop the pool ***/
+
+void vdpthread_stop(void)
+{
+  unsigned int i;
+
+  if (!vdpthread_on)
+    return;
+  vdpthread_wait();
+  mtx_lock(&vdpthread_mutex);
+  vdpthread_quit = 1;
+  cnd_broadcast(&vdpthread_work);
+  mtx_unlock(&vdpthread_mutex);
+  for (i = 0; i < vdpthread_count; i++)
+    thrd_join(vdpthread_threads[i], nullptr);
+  cnd_destroy(&vdpthread_idle);
+  cnd_destroy(&vdpthread_work);
+  mtx_destroy(&vdpthread_mutex);
+  vdpthread_count = 0;
+  vdpthread_on = 0;
+  vdp_logfree(); /* after vdpthread_on, so an open band renders here */
+  LOG_VERBOSE(("Render threads stopped"));
+}
+
+/*** vdpthread_endfield - start, stop or resize the pool between fields ***/
+
+void vdpthread_endfield(void)
+{
+  unsigned int want = vdp_renderthreads;
+
+  if (want > VDPTHREAD_MAX)
+    want = VDPTHREAD_MAX;
+  if (want == vdpthread_count)
+    return;
+  vdpthread_stop();
+  if (want && vdpthread_start(want)) {
+    LOG_CRITICAL(("Unable to start render threads"));
+    vdp_renderthreads = 0;
+  }
+}
+
+/*** vdpthread_queue - hand a band to the pool ***/
+
+void vdpthread_queue(unsigned int band)
+{
+  mtx_lock(&vdpthread_mutex);
+  vdpthread_bands[vdpthread_queued++ % VDPTHREAD_BANDS] = band;
+  cnd_signal(&vdpthread_work);
+  mtx_unlock(&vdpthread_mutex);
+}
+
+/*** vdpthread_wait - wait for every queued band to be rendered ***/
+
+void vdpthread_wait(void)
+{
+  if (!vdpthread_on)
+    return;
+  mtx_lock(&vdpthread_mutex);
+  while (vdpthread_done != vdpthread_queued)
+    cnd_wait(&vdpthread_idle, &vdpthread_mutex);
+  vdpthread_queued = vdpthread_taken = vdpthread_done = 0;
+  mtx_unlock(&vdpthread_mutex);
+}
+
+/*** vdpthread_main - thread body ***/
+
+static int vdpthread_main(void *arg)
+{
+  unsigned int band;
+
+  (void)arg;
+  mtx_lock(&vdpthread_mutex);
+  for (;;) {
+    while (vdpthread_taken == vdpthread_queued && !vdpthread_quit)
+      cnd_wait(&vdpthread_work, &vdpthread_mutex);
+    if (vdpthread_taken == vdpthread_queued)
+      break; /* quitting and nothing left */
+    band = vdpthread_bands[vdpthread_taken++ % VDPTHREAD_BANDS];
+    mtx_unlock(&vdpthread_mutex);
+    vdp_renderband(band);
+    mtx_lock(&vdpthread_mutex);
+    if (++vdpthread_done == vdpthread_queued)
+      cnd_signal(&vdpthread_idle);
+  }
+  mtx_unlock(&vdpthread_mutex);
+  return 0;
+}
@@ -0,0 +1,113 @@
+/* xBRZ benchmark - times 2x, 3x and 4x scaling of a Genesis sized frame
+   with different thread counts, and checks every thread count gives the
+   same output as one thread.
+
+   Usage: xbrz-bench [frames]  (default 120 frames per measurement) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "bench.h"
+#include "xbrz_wrapper.h"
+
+#define BENCH_WIDTH 320
+#define BENCH_HEIGHT 224
+
+static const int bench_threads[] = {1, 2, 4, 8, 0};
+
+/*** bench_frame - make up something that looks like pixel art ***/
+
+static void bench_frame(uint32_t *frame)
+{
+  static const uint32_t pal[8] = {0x000000, 0xe0e0e0, 0xe02000, 0x2040c0,
+                                  0x20a040, 0xe0c020, 0x604020, 0x8080a0};
+  uint32_t seed = 12345;
+  unsigned int x, y, tx, ty;
+
+  /* 8x8 tiles of a few colours, each either flat, a diagonal or noise */
+  for (ty = 0; ty < BENCH_HEIGHT / 8; ty++) {
+    for (tx = 0; tx < BENCH_WIDTH / 8; tx++) {
+      unsigned int kind, a, b;
+
+      seed = seed * 1103515245 + 12345;
+      kind = seed >> 28 & 3;
+      a = seed >> 20 & 7;
+      b = seed >> 16 & 7;
+      for (y = 0; y < 8; y++) {
+        for (x = 0; x < 8; x++) {
+          unsigned int c = a;
+
+          if (kind == 1)
+            c = x > y ? a : b;
+          else if (kind == 2)
+            c = x + y < 8 ? a : b;
+          else if (kind == 3) {
+            seed = seed * 1103515245 + 12345;
+            c = seed >> 29;
+          }
+          frame[(ty * 8 + y) * BENCH_WIDTH + tx * 8 + x] = pal[c];
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int frames = argc > 1 ? atoi(argv[1]) : 120;
+  static uint32_t src[BENCH_WIDTH * BENCH_HEIGHT];
+  size_t out = (size_t)BENCH_WIDTH * 4 * BENCH_HEIGHT * 4;
+  uint32_t *ref = malloc(out * sizeof(uint32_t));
+  uint32_t *trg = malloc(out * sizeof(uint32_t));
+  int factor, failed = 0;
+  unsigned int t;
+
+  if (frames < 1 || !ref || !trg) {
+    fprintf(stderr, "Usage: %s [frames]\n", argv[0]);
+    return 1;
+  }
+  bench_frame(src);
+  printf("xBRZ %dx%d, %d frames each, ms per frame\n", BENCH_WIDTH,
+         BENCH_HEIGHT, frames);
+  printf("factor");
+  for (t = 0; t < sizeof(bench_threads) / sizeof(bench_threads[0]); t++) {
+    if (bench_threads[t])
+      printf("  %2d thread%s", bench_threads[t],
+             bench_threads[t] == 1 ? " " : "s");
+    else
+      printf("   per core");
+  }
+  printf("\n");
+
+  for (factor = 2; factor <= 4; factor++) {
+    size_t pixels = (size_t)BENCH_WIDTH * factor * BENCH_HEIGHT * factor;
+
+    xbrz_set_threads(1);
+    xbrz_scale(factor, src, ref, BENCH_WIDTH, BENCH_HEIGHT);
+    printf("%5dx", factor);
+    for (t = 0; t < sizeof(bench_threads) / sizeof(bench_threads[0]); t++) {
+      double start;
+      int i;
+
+      xbrz_set_threads(bench_threads[t]);
+      memset(trg, 0, pixels * sizeof(uint32_t));
+      xbrz_scale(factor, src, trg, BENCH_WIDTH, BENCH_HEIGHT); /* warm up */
+      if (memcmp(trg, ref, pixels * sizeof(uint32_t))) {
+        printf("  DIFFERENT");
+        failed = 1;
+        continue;
+      }
+      start = bench_now();
+      for (i = 0; i < frames; i++)
+        xbrz_scale(factor, src, trg, BENCH_WIDTH, BENCH_HEIGHT);
+      printf("  %10.3f", (bench_now() - start) * 1000 / frames);
+    }
+    printf("\n");
+  }
+  xbrz_set_threads(1);
+  free(ref);
+  free(trg);
+  return failed;
+}
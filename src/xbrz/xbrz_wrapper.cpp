@@ -1,10 +1,164 @@
-/* xBRZ C wrapper implementation - bridges C and C++ code */
+/* xBRZ C wrapper implementation - bridges C and C++ code
+
+   Every call is split into horizontal bands of source rows, which xBRZ can
+   scale independently (see the slice notes in xbrz.h).  A persistent pool
+   of worker threads takes bands alongside the calling thread, so a frame
+   costs roughly 1 / threads of the single threaded time and the output is
+   the same whatever the thread count. */
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "xbrz_wrapper.h"
 #include "xbrz.h"
 
+namespace {
+
+constexpr int kBandRows = 16;  // xBRZ redoes two rows per slice, keep it small
+
+// One scale call shared out between the pool and the caller
+struct Job {
+  size_t factor;
+  const uint32_t *src;
+  uint32_t *trg;
+  int width, height;
+  int first, last;  // source rows [first, last)
+  int bands;
+  xbrz::ScalerCfg cfg;
+
+  void scaleBand(int band) const
+  {
+    const int rows = last - first;
+    xbrz::scale(factor, src, trg, width, height, xbrz::ColorFormat::RGB, cfg,
+                first + rows * band / bands,
+                first + rows * (band + 1) / bands);
+  }
+};
+
+class Pool {
+ public:
+  ~Pool()
+  {
+    stopWorkers();
+  }
+
+  void setThreads(int threads)
+  {
+    std::lock_guard<std::mutex> call(call_);
+    if (threads <= 0)
+      threads = static_cast<int>(std::thread::hardware_concurrency());
+    threads_ = std::clamp(threads, 1, XBRZ_THREADS_MAX);
+  }
+
+  void scale(const Job &job)
+  {
+    std::lock_guard<std::mutex> call(call_);  // one caller at a time
+    Job shared = job;
+
+    shared.bands = std::min(threads_, (job.last - job.first + kBandRows - 1) /
+                                          kBandRows);
+    if (shared.bands <= 1) {
+      shared.bands = 1;
+      shared.scaleBand(0);
+      return;
+    }
+    if (static_cast<int>(workers_.size()) != threads_ - 1) {
+      stopWorkers();
+      startWorkers(threads_ - 1);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_ = shared;
+    next_ = done_ = 0;
+    work_.notify_all();
+    takeBands(lock);
+    idle_.wait(lock, [this] { return done_ == job_.bands; });
+    job_.bands = 0;
+  }
+
+ private:
+  // Scale bands until none are left to start, called with mutex_ held
+  void takeBands(std::unique_lock<std::mutex> &lock)
+  {
+    while (next_ < job_.bands) {
+      const int band = next_++;
+      const Job job = job_;
+      lock.unlock();
+      job.scaleBand(band);
+      lock.lock();
+      if (++done_ == job_.bands)
+        idle_.notify_one();
+    }
+  }
+
+  void worker()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      work_.wait(lock, [this] { return quit_ || next_ < job_.bands; });
+      if (quit_)
+        return;
+      takeBands(lock);
+    }
+  }
+
+  void startWorkers(int count)
+  {
+    quit_ = false;
+    for (int i = 0; i < count; i++)
+      workers_.emplace_back(&Pool::worker, this);
+  }
+
+  void stopWorkers()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      quit_ = true;
+    }
+    work_.notify_all();
+    for (std::thread &t : workers_)
+      t.join();
+    workers_.clear();
+  }
+
+  std::mutex call_;  // held for a whole scale() or setThreads()
+  int threads_ = 1;  // including the caller
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;  // guards the rest
+  std::condition_variable work_;  // a job has bands to start, or quit
+  std::condition_variable idle_;  // the last band of a job is done
+  Job job_ = {};
+  int next_ = 0;  // next band to start
+  int done_ = 0;  // bands finished
+  bool quit_ = false;
+};
+
+Pool pool;
+
+void scaleBands(int factor, const uint32_t *src, uint32_t *trg, int width,
+                int height, int first, int last, const xbrz::ScalerCfg &cfg)
+{
+  first = std::max(first, 0);
+  last = std::min(last, height);
+  if (first >= last)
+    return;
+  pool.scale(Job{static_cast<size_t>(factor), src, trg, width, height, first,
+                 last, 0, cfg});
+}
+
+}  // namespace
+
 extern "C" {
 
+void xbrz_set_threads(int threads)
+{
+  pool.setThreads(threads);
+}
+
 void xbrz_scale(int factor, const uint32_t *src, uint32_t *trg, int src_width,
                 int src_height)
 {
@@ -16,8 +170,19 @@ void xbrz_scale(int factor, const uint32_t *src, uint32_t *trg, int src_width,
   xbrz::ScalerCfg cfg;
 
   // RGB format (no alpha channel)
-  xbrz::scale(static_cast<size_t>(factor), src, trg, src_width, src_height,
-              xbrz::ColorFormat::RGB, cfg);
+  scaleBands(factor, src, trg, src_width, src_height, 0, src_height, cfg);
+}
+
+void xbrz_scale_rows(int factor, const uint32_t *src, uint32_t *trg,
+                     int src_width, int src_height, int y_first, int y_last)
+{
+  if (factor < 2 || factor > xbrz::SCALE_FACTOR_MAX) {
+    return;  // Invalid scale factor
+  }
+
+  xbrz::ScalerCfg cfg;
+
+  scaleBands(factor, src, trg, src_width, src_height, y_first, y_last, cfg);
 }
 
 void xbrz_scale_custom(int factor, const uint32_t *src, uint32_t *trg,
@@ -31,8 +196,7 @@ void xbrz_scale_custom(int factor, const uint32_t *src, uint32_t *trg,
   // Custom configuration
   xbrz::ScalerCfg cfg(luminance_weight, equal_color_tolerance);
 
-  xbrz::scale(static_cast<size_t>(factor), src, trg, src_width, src_height,
-              xbrz::ColorFormat::RGB, cfg);
+  scaleBands(factor, src, trg, src_width, src_height, 0, src_height, cfg);
 }
 
 }  // extern "C"
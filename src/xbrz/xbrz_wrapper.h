@@ -12,6 +12,21 @@ extern "C" {
 
 /* C-compatible wrapper functions for xBRZ scaling */
 
+#define XBRZ_THREADS_MAX 16
+
+/**
+ * Set how many threads share each scale call
+ *
+ * @param threads Threads including the caller (1 - XBRZ_THREADS_MAX), or 0
+ * for one per CPU core
+ *
+ * Frames are split into bands of at least 16 source rows, which a persistent
+ * pool of threads - 1 workers scales alongside the calling thread.  The
+ * output does not depend on the thread count.  The default is 1, in which
+ * case no workers are started.
+ */
+void xbrz_set_threads(int threads);
+
 /**
  * Scale an image using xBRZ algorithm
  *
@@ -27,6 +42,16 @@ extern "C" {
 void xbrz_scale(int factor, const uint32_t *src, uint32_t *trg, int src_width,
                 int src_height);
 
+/**
+ * Scale source rows [y_first, y_last) only
+ *
+ * Output rows y_first * factor to y_last * factor - 1 are written, reading
+ * source rows up to two either side of the slice.  The rest of trg is
+ * left as it was.
+ */
+void xbrz_scale_rows(int factor, const uint32_t *src, uint32_t *trg,
+                     int src_width, int src_height, int y_first, int y_last);
+
 /**
  * Scale with custom configuration
  *